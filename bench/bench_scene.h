@@ -0,0 +1,53 @@
+#ifndef IGGPU_BENCH_BENCH_SCENE_H
+#define IGGPU_BENCH_BENCH_SCENE_H
+
+#include <iggpu/app_base.h>
+#include <iggpu/frame_timer.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace iggpu::bench {
+
+// How many_objects submits its draws
+enum class BatchingMode {
+  // One draw call, with its own state changes, per object
+  Direct,
+  // Through a DrawBatcher
+  Batched,
+  // Through a DrawBatcher, with indirect draws
+  Indirect,
+};
+
+class BenchScene {
+ public:
+  virtual ~BenchScene() = default;
+
+  virtual const char* name() const = 0;
+  virtual bool load(AppBase* app_base) = 0;
+
+  // Records, submits and presents one frame. Returns the number of
+  //  Queue.Submit calls made for the frame.
+  virtual uint32_t render_frame(AppBase* app_base, FrameTimer& timer) = 0;
+
+  // Optional scene-specific statistics, as a JSON object (or empty)
+  virtual std::string stats_json() const { return ""; }
+};
+
+std::unique_ptr<BenchScene> create_triangle_scene();
+std::unique_ptr<BenchScene> create_many_draws_scene(uint32_t draw_count);
+std::unique_ptr<BenchScene> create_big_uploads_scene(uint64_t bytes_per_frame,
+                                                     bool use_upload_ring);
+std::unique_ptr<BenchScene> create_many_uniforms_scene(uint32_t draw_count,
+                                                       bool use_arena);
+std::unique_ptr<BenchScene> create_many_objects_scene(uint32_t object_count,
+                                                      BatchingMode mode);
+std::unique_ptr<BenchScene> create_many_pipelines_scene(
+    uint32_t pipeline_count);
+std::unique_ptr<BenchScene> create_parallel_draws_scene(uint32_t draw_count,
+                                                        uint32_t thread_count);
+
+}  // namespace iggpu::bench
+
+#endif
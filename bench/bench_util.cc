@@ -0,0 +1,63 @@
+#include "bench_util.h"
+
+namespace iggpu::bench {
+
+wgpu::ShaderModule create_wgsl_module(const wgpu::Device& device,
+                                      const char* code) {
+  wgpu::ShaderModuleWGSLDescriptor wgslDesc{};
+  wgslDesc.code = code;
+
+  wgpu::ShaderModuleDescriptor desc{};
+  desc.nextInChain = &wgslDesc;
+  return device.CreateShaderModule(&desc);
+}
+
+wgpu::RenderPipeline create_simple_pipeline(
+    const wgpu::Device& device, const wgpu::ShaderModule& module,
+    wgpu::TextureFormat format, wgpu::BindGroupLayout bind_group_layout) {
+  wgpu::PipelineLayoutDescriptor pl{};
+  pl.bindGroupLayoutCount = bind_group_layout ? 1 : 0;
+  pl.bindGroupLayouts = bind_group_layout ? &bind_group_layout : nullptr;
+
+  wgpu::ColorTargetState colorTargetState{};
+  colorTargetState.format = format;
+
+  wgpu::FragmentState fragmentState{};
+  fragmentState.module = module;
+  fragmentState.entryPoint = "fs_main";
+  fragmentState.targetCount = 1;
+  fragmentState.targets = &colorTargetState;
+
+  wgpu::RenderPipelineDescriptor rpd{};
+  rpd.layout = device.CreatePipelineLayout(&pl);
+  rpd.vertex.module = module;
+  rpd.vertex.entryPoint = "vs_main";
+  rpd.fragment = &fragmentState;
+  rpd.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+
+  return device.CreateRenderPipeline(&rpd);
+}
+
+ClearPass::ClearPass(wgpu::TextureView view) {
+  color_attachment = {};
+  color_attachment.clearValue = {0.f, 0.f, 0.f, 1.f};
+  color_attachment.loadOp = wgpu::LoadOp::Clear;
+  color_attachment.storeOp = wgpu::StoreOp::Store;
+  color_attachment.view = view;
+
+  desc = {};
+  desc.colorAttachmentCount = 1;
+  desc.colorAttachments = &color_attachment;
+}
+
+std::string to_string(wgpu::StringView sv) {
+  if (sv.data == nullptr) {
+    return "";
+  }
+  if (sv.length == WGPU_STRLEN) {
+    return std::string(sv.data);
+  }
+  return std::string(sv.data, sv.length);
+}
+
+}  // namespace iggpu::bench
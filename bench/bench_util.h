@@ -0,0 +1,35 @@
+#ifndef IGGPU_BENCH_BENCH_UTIL_H
+#define IGGPU_BENCH_BENCH_UTIL_H
+
+#include <webgpu/webgpu_cpp.h>
+
+#include <string>
+
+namespace iggpu::bench {
+
+wgpu::ShaderModule create_wgsl_module(const wgpu::Device& device,
+                                      const char* code);
+
+// Pipeline with no vertex buffers, no depth and one color target, using the
+//  "vs_main" and "fs_main" entry points of the given module. If given,
+//  bind_group_layout is used for group 0.
+wgpu::RenderPipeline create_simple_pipeline(
+    const wgpu::Device& device, const wgpu::ShaderModule& module,
+    wgpu::TextureFormat format,
+    wgpu::BindGroupLayout bind_group_layout = nullptr);
+
+// Render pass descriptor that clears and stores a single color target
+struct ClearPass {
+  explicit ClearPass(wgpu::TextureView view);
+  ClearPass(const ClearPass&) = delete;
+  ClearPass& operator=(const ClearPass&) = delete;
+
+  wgpu::RenderPassColorAttachment color_attachment;
+  wgpu::RenderPassDescriptor desc;
+};
+
+std::string to_string(wgpu::StringView sv);
+
+}  // namespace iggpu::bench
+
+#endif
@@ -0,0 +1,488 @@
+#include <iggpu/app_base.h>
+#include <iggpu/frame_timer.h>
+#include <iggpu/rolling_stats.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench_scene.h"
+#include "bench_util.h"
+
+#if defined(_WIN32)
+// clang-format off
+#include <windows.h>
+#include <psapi.h>
+// clang-format on
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Limits how far the CPU may run ahead of the GPU, so that measured frame
+//  times reflect GPU throughput instead of how deep Dawn's queue can get.
+const uint32_t kMaxFramesInFlight = 2u;
+
+struct BenchOptions {
+  uint32_t warmup_frames = 30u;
+  uint32_t measured_frames = 300u;
+  uint32_t width = 1280u;
+  uint32_t height = 720u;
+  iggpu::HeadlessAdapterType adapter_type = iggpu::HeadlessAdapterType::Default;
+  std::vector<std::string> scenes = {"triangle",
+                                     "many_draws",
+                                     "many_uniforms",
+                                     "many_uniforms_arena",
+                                     "many_objects",
+                                     "many_objects_batched",
+                                     "many_objects_indirect",
+                                     "big_uploads",
+                                     "big_uploads_ring",
+                                     "many_pipelines",
+                                     "parallel_draws"};
+  std::string out_path;
+
+  uint32_t draw_count = 10000u;
+  uint32_t object_count = 100000u;
+  uint64_t upload_bytes = 64ull * 1024ull * 1024ull;
+  uint32_t pipeline_count = 256u;
+  std::vector<uint32_t> thread_counts = {1u, 2u, 4u, 8u};
+};
+
+struct SceneResult {
+  std::string name;
+  uint32_t frames;
+  double wall_time_s;
+  uint64_t submits;
+  iggpu::Percentiles frame_ms;
+  iggpu::Percentiles cpu_encode_ms;
+  iggpu::Percentiles cpu_submit_ms;
+  iggpu::Percentiles gpu_frame_ms;
+  bool gpu_timestamps;
+  uint64_t skipped_gpu_samples;
+  uint64_t peak_memory_bytes;
+  std::string scene_stats_json;
+};
+
+void print_usage() {
+  std::cerr
+      << "Usage: iggpu_bench [options]\n"
+         "  --warmup N          Frames rendered before measuring (default 30)\n"
+         "  --frames N          Measured frames per scene (default 300)\n"
+         "  --size WxH          Render target size (default 1280x720)\n"
+         "  --adapter TYPE      default | cpu | null (default: default)\n"
+         "  --scenes A,B,...    Scenes to run (default: all)\n"
+         "                      triangle, many_draws, many_uniforms,\n"
+         "                      many_uniforms_arena, many_objects,\n"
+         "                      many_objects_batched,\n"
+         "                      many_objects_indirect, big_uploads,\n"
+         "                      big_uploads_ring, many_pipelines,\n"
+         "                      parallel_draws\n"
+         "  --draws N           Draw calls per frame in many_draws and\n"
+         "                      many_uniforms (10000)\n"
+         "  --objects N         Objects in many_objects (100000)\n"
+         "  --upload-mb N       MiB uploaded per frame in big_uploads (64)\n"
+         "  --pipelines N       Pipelines in many_pipelines (256)\n"
+         "  --threads A,B,...   Recording threads for parallel_draws, one\n"
+         "                      run per count (1,2,4,8)\n"
+         "  --out PATH          Write JSON results to PATH (default: stdout)\n";
+}
+
+std::vector<std::string> split(const std::string& s, char delim) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (start <= s.size()) {
+    size_t end = s.find(delim, start);
+    if (end == std::string::npos) end = s.size();
+    if (end > start) parts.push_back(s.substr(start, end - start));
+    start = end + 1;
+  }
+  return parts;
+}
+
+bool parse_args(int argc, char** argv, BenchOptions& opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      return false;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    std::string value = argv[++i];
+
+    if (arg == "--warmup") {
+      opts.warmup_frames = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--frames") {
+      opts.measured_frames = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--size") {
+      if (std::sscanf(value.c_str(), "%ux%u", &opts.width, &opts.height) != 2) {
+        std::cerr << "Invalid size " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--adapter") {
+      if (value == "default") {
+        opts.adapter_type = iggpu::HeadlessAdapterType::Default;
+      } else if (value == "cpu") {
+        opts.adapter_type = iggpu::HeadlessAdapterType::CPU;
+      } else if (value == "null") {
+        opts.adapter_type = iggpu::HeadlessAdapterType::Null;
+      } else {
+        std::cerr << "Unknown adapter type " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--scenes") {
+      opts.scenes = ::split(value, ',');
+    } else if (arg == "--draws") {
+      opts.draw_count = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--objects") {
+      opts.object_count = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--upload-mb") {
+      opts.upload_bytes =
+          std::strtoull(value.c_str(), nullptr, 10) * 1024ull * 1024ull;
+    } else if (arg == "--pipelines") {
+      opts.pipeline_count = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--threads") {
+      opts.thread_counts.clear();
+      for (const auto& count : ::split(value, ',')) {
+        opts.thread_counts.push_back(
+            std::strtoul(count.c_str(), nullptr, 10));
+      }
+    } else if (arg == "--out") {
+      opts.out_path = value;
+    } else {
+      std::cerr << "Unknown argument " << arg << std::endl;
+      return false;
+    }
+  }
+
+  if (opts.measured_frames == 0u || opts.width == 0u || opts.height == 0u) {
+    std::cerr << "Frame count and size must be non-zero" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+// Most names map to a single scene, but sweeps (e.g. parallel_draws over
+//  --threads) expand to one scene per configuration
+std::vector<std::unique_ptr<iggpu::bench::BenchScene>> create_scenes(
+    const std::string& name, const BenchOptions& opts) {
+  std::vector<std::unique_ptr<iggpu::bench::BenchScene>> scenes;
+  if (name == "triangle") {
+    scenes.push_back(iggpu::bench::create_triangle_scene());
+  } else if (name == "many_draws") {
+    scenes.push_back(iggpu::bench::create_many_draws_scene(opts.draw_count));
+  } else if (name == "many_uniforms") {
+    scenes.push_back(
+        iggpu::bench::create_many_uniforms_scene(opts.draw_count, false));
+  } else if (name == "many_uniforms_arena") {
+    scenes.push_back(
+        iggpu::bench::create_many_uniforms_scene(opts.draw_count, true));
+  } else if (name == "many_objects") {
+    scenes.push_back(iggpu::bench::create_many_objects_scene(
+        opts.object_count, iggpu::bench::BatchingMode::Direct));
+  } else if (name == "many_objects_batched") {
+    scenes.push_back(iggpu::bench::create_many_objects_scene(
+        opts.object_count, iggpu::bench::BatchingMode::Batched));
+  } else if (name == "many_objects_indirect") {
+    scenes.push_back(iggpu::bench::create_many_objects_scene(
+        opts.object_count, iggpu::bench::BatchingMode::Indirect));
+  } else if (name == "big_uploads") {
+    scenes.push_back(
+        iggpu::bench::create_big_uploads_scene(opts.upload_bytes, false));
+  } else if (name == "big_uploads_ring") {
+    scenes.push_back(
+        iggpu::bench::create_big_uploads_scene(opts.upload_bytes, true));
+  } else if (name == "many_pipelines") {
+    scenes.push_back(
+        iggpu::bench::create_many_pipelines_scene(opts.pipeline_count));
+  } else if (name == "parallel_draws") {
+    for (uint32_t thread_count : opts.thread_counts) {
+      scenes.push_back(iggpu::bench::create_parallel_draws_scene(
+          opts.draw_count, thread_count));
+    }
+  }
+  return scenes;
+}
+
+uint64_t peak_memory_bytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS pmc{};
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+    return pmc.PeakWorkingSetSize;
+  }
+  return 0u;
+#else
+  struct rusage usage {};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0u;
+  }
+#if defined(__APPLE__)
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024u;
+#endif
+#endif
+}
+
+// Sleeps until at most max_in_flight frames are still on the GPU. Frames
+//  complete in order, so waiting on the oldest one is enough.
+void wait_for_frames(iggpu::AppBase* app_base,
+                     std::deque<iggpu::GpuFuture>& in_flight,
+                     uint32_t max_in_flight) {
+  while (in_flight.size() > max_in_flight) {
+    app_base->wait(in_flight.front());
+    in_flight.pop_front();
+  }
+}
+
+bool run_scene(iggpu::AppBase* app_base, iggpu::bench::BenchScene* scene,
+               const BenchOptions& opts, SceneResult& out) {
+  using clock = std::chrono::steady_clock;
+
+  if (!scene->load(app_base)) {
+    std::cerr << "Failed to load scene " << scene->name() << std::endl;
+    return false;
+  }
+
+  iggpu::FrameTimer timer(app_base, opts.measured_frames);
+  iggpu::RollingStats frame_ms(opts.measured_frames);
+  std::deque<iggpu::GpuFuture> in_flight;
+
+  auto run_frame = [&]() -> uint32_t {
+    uint32_t submits = scene->render_frame(app_base, timer);
+    in_flight.push_back(app_base->on_submitted_work_done([]() {}));
+    app_base->process_events();
+    ::wait_for_frames(app_base, in_flight, ::kMaxFramesInFlight - 1u);
+    return submits;
+  };
+
+  for (uint32_t i = 0; i < opts.warmup_frames; i++) {
+    run_frame();
+  }
+  ::wait_for_frames(app_base, in_flight, 0u);
+
+  // FrameTimer windows are sized to the measured frame count, so only
+  //  measured frames remain in them once the loop below completes
+  uint64_t submits = 0u;
+  uint64_t skipped_before = timer.skipped_gpu_samples();
+  auto start = clock::now();
+  auto frame_start = start;
+  for (uint32_t i = 0; i < opts.measured_frames; i++) {
+    submits += run_frame();
+    auto frame_end = clock::now();
+    frame_ms.add(
+        std::chrono::duration<double, std::milli>(frame_end - frame_start)
+            .count());
+    frame_start = frame_end;
+  }
+  ::wait_for_frames(app_base, in_flight, 0u);
+  double wall_time_s =
+      std::chrono::duration<double>(clock::now() - start).count();
+
+  out.name = scene->name();
+  out.frames = opts.measured_frames;
+  out.wall_time_s = wall_time_s;
+  out.submits = submits;
+  out.frame_ms = frame_ms.percentiles();
+  out.cpu_encode_ms = timer.cpu_encode_stats();
+  out.cpu_submit_ms = timer.cpu_submit_stats();
+  out.gpu_frame_ms = timer.gpu_frame_stats();
+  out.gpu_timestamps = timer.has_gpu_timestamps();
+  out.skipped_gpu_samples = timer.skipped_gpu_samples() - skipped_before;
+  out.peak_memory_bytes = ::peak_memory_bytes();
+  out.scene_stats_json = scene->stats_json();
+  return true;
+}
+
+std::string json_escape(const std::string& s) {
+  std::string out;
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buff[8];
+          std::snprintf(buff, sizeof(buff), "\\u%04x", c);
+          out += buff;
+        } else {
+          out += c;
+        }
+    }
+  }
+  return out;
+}
+
+std::string json_percentiles(const iggpu::Percentiles& p) {
+  char buff[256];
+  std::snprintf(buff, sizeof(buff),
+                "{\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"min\": %.4f, "
+                "\"max\": %.4f, \"mean\": %.4f, \"samples\": %u}",
+                p.p50, p.p95, p.p99, p.min, p.max, p.mean, p.sample_count);
+  return buff;
+}
+
+const char* adapter_type_name(wgpu::AdapterType type) {
+  switch (type) {
+    case wgpu::AdapterType::DiscreteGPU:
+      return "DiscreteGPU";
+    case wgpu::AdapterType::IntegratedGPU:
+      return "IntegratedGPU";
+    case wgpu::AdapterType::CPU:
+      return "CPU";
+    default:
+      return "Unknown";
+  }
+}
+
+const char* backend_type_name(wgpu::BackendType type) {
+  switch (type) {
+    case wgpu::BackendType::Null:
+      return "Null";
+    case wgpu::BackendType::D3D11:
+      return "D3D11";
+    case wgpu::BackendType::D3D12:
+      return "D3D12";
+    case wgpu::BackendType::Metal:
+      return "Metal";
+    case wgpu::BackendType::Vulkan:
+      return "Vulkan";
+    case wgpu::BackendType::OpenGL:
+      return "OpenGL";
+    case wgpu::BackendType::OpenGLES:
+      return "OpenGLES";
+    default:
+      return "Unknown";
+  }
+}
+
+std::string to_json(iggpu::AppBase* app_base, const BenchOptions& opts,
+                    const std::vector<SceneResult>& results) {
+  wgpu::AdapterInfo info{};
+  app_base->Adapter.GetInfo(&info);
+
+  std::string out = "{\n";
+  out += "  \"adapter\": {\"vendor\": \"" +
+         ::json_escape(iggpu::bench::to_string(info.vendor)) +
+         "\", \"device\": \"" +
+         ::json_escape(iggpu::bench::to_string(info.device)) +
+         "\", \"description\": \"" +
+         ::json_escape(iggpu::bench::to_string(info.description)) +
+         "\", \"type\": \"" + ::adapter_type_name(info.adapterType) +
+         "\", \"backend\": \"" + ::backend_type_name(info.backendType) +
+         "\"},\n";
+  out += "  \"config\": {\"warmup_frames\": " +
+         std::to_string(opts.warmup_frames) +
+         ", \"measured_frames\": " + std::to_string(opts.measured_frames) +
+         ", \"width\": " + std::to_string(opts.width) +
+         ", \"height\": " + std::to_string(opts.height) + "},\n";
+  out += "  \"scenes\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto& r = results[i];
+    out += "    {\n";
+    out += "      \"name\": \"" + ::json_escape(r.name) + "\",\n";
+    out += "      \"frames\": " + std::to_string(r.frames) + ",\n";
+    out += "      \"wall_time_s\": " + std::to_string(r.wall_time_s) + ",\n";
+    out += "      \"frames_per_second\": " +
+           std::to_string(r.frames / r.wall_time_s) + ",\n";
+    out += "      \"submits\": " + std::to_string(r.submits) + ",\n";
+    out += "      \"submits_per_second\": " +
+           std::to_string(r.submits / r.wall_time_s) + ",\n";
+    out += "      \"frame_ms\": " + ::json_percentiles(r.frame_ms) + ",\n";
+    out += "      \"cpu_encode_ms\": " + ::json_percentiles(r.cpu_encode_ms) +
+           ",\n";
+    out += "      \"cpu_submit_ms\": " + ::json_percentiles(r.cpu_submit_ms) +
+           ",\n";
+    out += "      \"gpu_frame_ms\": " + ::json_percentiles(r.gpu_frame_ms) +
+           ",\n";
+    out += std::string("      \"gpu_timestamps\": ") +
+           (r.gpu_timestamps ? "true" : "false") + ",\n";
+    out += "      \"skipped_gpu_samples\": " +
+           std::to_string(r.skipped_gpu_samples) + ",\n";
+    if (!r.scene_stats_json.empty()) {
+      out += "      \"scene_stats\": " + r.scene_stats_json + ",\n";
+    }
+    out += "      \"peak_memory_bytes\": " +
+           std::to_string(r.peak_memory_bytes) + "\n";
+    out += (i + 1 < results.size()) ? "    },\n" : "    }\n";
+  }
+  out += "  ],\n";
+  out += "  \"peak_memory_bytes\": " + std::to_string(::peak_memory_bytes()) +
+         "\n";
+  out += "}\n";
+  return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchOptions opts;
+  if (!::parse_args(argc, argv, opts)) {
+    ::print_usage();
+    return -1;
+  }
+
+  auto app_create_rsl = iggpu::AppBase::CreateHeadless(
+      opts.width, opts.height, wgpu::TextureFormat::BGRA8Unorm,
+      opts.adapter_type);
+  if (std::holds_alternative<iggpu::AppBaseCreateError>(app_create_rsl)) {
+    std::cerr << "Failed to create app: "
+              << iggpu::app_base_create_error_text(
+                     std::get<iggpu::AppBaseCreateError>(app_create_rsl))
+              << std::endl;
+    return -1;
+  }
+
+  std::unique_ptr<iggpu::AppBase> app_base =
+      std::move(std::get<std::unique_ptr<iggpu::AppBase>>(app_create_rsl));
+
+  std::vector<SceneResult> results;
+  for (const auto& scene_name : opts.scenes) {
+    auto scenes = ::create_scenes(scene_name, opts);
+    if (scenes.empty()) {
+      std::cerr << "Unknown scene " << scene_name << std::endl;
+      ::print_usage();
+      return -1;
+    }
+
+    for (auto& scene : scenes) {
+      std::cerr << "Running scene " << scene->name() << "..." << std::endl;
+      SceneResult result{};
+      if (!::run_scene(app_base.get(), scene.get(), opts, result)) {
+        return -1;
+      }
+      results.push_back(std::move(result));
+    }
+  }
+
+  std::string json = ::to_json(app_base.get(), opts, results);
+  if (opts.out_path.empty()) {
+    std::cout << json;
+    return 0;
+  }
+
+  std::FILE* f = std::fopen(opts.out_path.c_str(), "w");
+  if (!f) {
+    std::cerr << "Failed to open " << opts.out_path << std::endl;
+    return -1;
+  }
+  std::fwrite(json.data(), 1, json.size(), f);
+  std::fclose(f);
+  return 0;
+}
@@ -0,0 +1,353 @@
+#include <iggpu/app_base.h>
+#include <iggpu/gpu_memory.h>
+#include <iggpu/mesh_file.h>
+#include <iggpu/rolling_stats.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include "obj_reader.h"
+
+// Time to get a mesh from disk into GPU buffers, for:
+//  - obj: the usual app path - parse OBJ text into std::vectors, then
+//    Queue.WriteBuffer
+//  - igmesh_read: read the whole .igmesh into a std::vector, then
+//    Queue.WriteBuffer from it
+//  - igmesh_mmap: iggpu::load_mesh_file (mmap, copied straight into buffers
+//    created mappedAtCreation)
+//
+// Each load ends once the GPU has finished the uploads. Files are read from
+//  the page cache after the first iteration, so this measures parsing,
+//  copies and upload rather than the disk.
+
+namespace {
+
+struct MeshLoadOptions {
+  iggpu::HeadlessAdapterType adapter_type = iggpu::HeadlessAdapterType::Default;
+  std::string mesh_path;
+  uint32_t segments = 512u;
+  uint32_t iterations = 10u;
+  std::string out_path;
+};
+
+struct LoaderResult {
+  std::string name;
+  iggpu::Percentiles load_ms;
+};
+
+struct MeshBuffers {
+  wgpu::Buffer vertex_buffer;
+  wgpu::Buffer index_buffer;
+};
+
+void print_usage() {
+  std::cerr
+      << "Usage: iggpu_mesh_load_bench [options]\n"
+         "  --adapter TYPE      default | cpu | null (default: default)\n"
+         "  --mesh PATH         OBJ file to load (default: a generated UV\n"
+         "                      sphere)\n"
+         "  --segments N        Segments around the generated sphere (512)\n"
+         "  --iterations N      Loads timed per loader (10)\n"
+         "  --out PATH          Write JSON results to PATH (default: stdout)\n";
+}
+
+bool parse_args(int argc, char** argv, MeshLoadOptions& opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      return false;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    std::string value = argv[++i];
+
+    if (arg == "--adapter") {
+      if (value == "default") {
+        opts.adapter_type = iggpu::HeadlessAdapterType::Default;
+      } else if (value == "cpu") {
+        opts.adapter_type = iggpu::HeadlessAdapterType::CPU;
+      } else if (value == "null") {
+        opts.adapter_type = iggpu::HeadlessAdapterType::Null;
+      } else {
+        std::cerr << "Unknown adapter type " << value << std::endl;
+        return false;
+      }
+    } else if (arg == "--mesh") {
+      opts.mesh_path = value;
+    } else if (arg == "--segments") {
+      opts.segments = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--iterations") {
+      opts.iterations = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--out") {
+      opts.out_path = value;
+    } else {
+      std::cerr << "Unknown argument " << arg << std::endl;
+      return false;
+    }
+  }
+
+  if (opts.iterations == 0u || opts.segments < 3u) {
+    std::cerr << "Iterations must be non-zero and segments at least 3"
+              << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+// UV sphere with positions, normals and texcoords
+bool write_sphere_obj(const std::string& path, uint32_t segments) {
+  std::FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) {
+    return false;
+  }
+
+  uint32_t rings = segments / 2u;
+  for (uint32_t r = 0u; r <= rings; r++) {
+    float phi = std::numbers::pi_v<float> * r / rings;
+    for (uint32_t s = 0u; s <= segments; s++) {
+      float theta = 2.f * std::numbers::pi_v<float> * s / segments;
+      float x = std::sin(phi) * std::cos(theta);
+      float y = std::cos(phi);
+      float z = std::sin(phi) * std::sin(theta);
+      std::fprintf(f, "v %.6f %.6f %.6f\nvn %.6f %.6f %.6f\nvt %.6f %.6f\n", x,
+                   y, z, x, y, z, static_cast<float>(s) / segments,
+                   static_cast<float>(r) / rings);
+    }
+  }
+  for (uint32_t r = 0u; r < rings; r++) {
+    for (uint32_t s = 0u; s < segments; s++) {
+      uint32_t a = r * (segments + 1u) + s + 1u;
+      uint32_t b = a + segments + 1u;
+      std::fprintf(f, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b,
+                   b, b + 1u, b + 1u, b + 1u, a + 1u, a + 1u, a + 1u);
+    }
+  }
+  return std::fclose(f) == 0;
+}
+
+// size must be a multiple of 4 (floats, uint32 indices, or .igmesh blobs,
+//  which are padded)
+wgpu::Buffer upload(iggpu::AppBase* app_base, const void* data, uint64_t size,
+                    wgpu::BufferUsage usage) {
+  wgpu::BufferDescriptor bd{};
+  bd.size = std::max<uint64_t>(size, 4u);
+  bd.usage = usage | wgpu::BufferUsage::CopyDst;
+  wgpu::Buffer buffer =
+      iggpu::create_buffer(app_base->Device, bd, "mesh_load_bench");
+  if (buffer && size > 0u) {
+    app_base->Queue.WriteBuffer(buffer, 0, data, size);
+  }
+  return buffer;
+}
+
+bool load_obj(iggpu::AppBase* app_base, const std::string& path,
+              MeshBuffers& out) {
+  iggpu::tools::ObjMesh mesh;
+  std::string error;
+  if (!iggpu::tools::read_obj(path, mesh, error)) {
+    std::cerr << error << std::endl;
+    return false;
+  }
+  out.vertex_buffer =
+      ::upload(app_base, mesh.vertices.data(),
+               mesh.vertices.size() * sizeof(float), wgpu::BufferUsage::Vertex);
+  out.index_buffer = ::upload(app_base, mesh.indices.data(),
+                              mesh.indices.size() * sizeof(uint32_t),
+                              wgpu::BufferUsage::Index);
+  return out.vertex_buffer && out.index_buffer;
+}
+
+bool load_igmesh_read(iggpu::AppBase* app_base, const std::string& path,
+                      MeshBuffers& out) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    std::cerr << "Failed to open " << path << std::endl;
+    return false;
+  }
+  std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+    std::cerr << "Failed to read " << path << std::endl;
+    return false;
+  }
+
+  auto parse_rsl = iggpu::parse_mesh_file(data);
+  if (std::holds_alternative<iggpu::MeshFileError>(parse_rsl)) {
+    std::cerr << "Invalid mesh file " << path << std::endl;
+    return false;
+  }
+  const auto& view = std::get<iggpu::MeshFileView>(parse_rsl);
+  out.vertex_buffer = ::upload(app_base, view.vertex_data.data(),
+                               view.vertex_data.size(),
+                               wgpu::BufferUsage::Vertex);
+  out.index_buffer =
+      ::upload(app_base, view.index_data.data(), view.index_data.size(),
+               wgpu::BufferUsage::Index);
+  return out.vertex_buffer && out.index_buffer;
+}
+
+bool load_igmesh_mmap(iggpu::AppBase* app_base, const std::string& path,
+                      MeshBuffers& out) {
+  auto load_rsl = iggpu::load_mesh_file(app_base, path, "mesh_load_bench");
+  if (std::holds_alternative<iggpu::MeshFileError>(load_rsl)) {
+    return false;
+  }
+  const auto& mesh = std::get<iggpu::LoadedMesh>(load_rsl);
+  out.vertex_buffer = mesh.vertex_buffer;
+  out.index_buffer = mesh.index_buffer;
+  return true;
+}
+
+using LoadFn = std::function<bool(iggpu::AppBase*, const std::string&,
+                                  MeshBuffers&)>;
+
+bool run_loader(iggpu::AppBase* app_base, const std::string& path,
+                const LoadFn& load, uint32_t iterations,
+                iggpu::Percentiles& out) {
+  using clock = std::chrono::steady_clock;
+
+  iggpu::RollingStats load_ms(iterations);
+  for (uint32_t i = 0u; i < iterations; i++) {
+    MeshBuffers buffers{};
+    auto start = clock::now();
+    if (!load(app_base, path, buffers)) {
+      return false;
+    }
+    // Flushes the queued writes, so that the wait covers them
+    app_base->Queue.Submit(0, nullptr);
+    app_base->wait(app_base->on_submitted_work_done([]() {}));
+    load_ms.add(
+        std::chrono::duration<double, std::milli>(clock::now() - start)
+            .count());
+
+    iggpu::destroy_buffer(buffers.vertex_buffer);
+    iggpu::destroy_buffer(buffers.index_buffer);
+  }
+
+  out = load_ms.percentiles();
+  return true;
+}
+
+std::string json_percentiles(const iggpu::Percentiles& p) {
+  char buff[256];
+  std::snprintf(buff, sizeof(buff),
+                "{\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"min\": %.4f, "
+                "\"max\": %.4f, \"mean\": %.4f, \"samples\": %u}",
+                p.p50, p.p95, p.p99, p.min, p.max, p.mean, p.sample_count);
+  return buff;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  MeshLoadOptions opts;
+  if (!::parse_args(argc, argv, opts)) {
+    ::print_usage();
+    return -1;
+  }
+
+  std::filesystem::path temp_dir = std::filesystem::temp_directory_path();
+  std::string obj_path = opts.mesh_path;
+  if (obj_path.empty()) {
+    obj_path = (temp_dir / "iggpu_mesh_load_bench.obj").string();
+    std::cerr << "Generating " << obj_path << "..." << std::endl;
+    if (!::write_sphere_obj(obj_path, opts.segments)) {
+      std::cerr << "Failed to write " << obj_path << std::endl;
+      return -1;
+    }
+  }
+  std::string igmesh_path =
+      (temp_dir / "iggpu_mesh_load_bench.igmesh").string();
+
+  iggpu::tools::ObjMesh mesh;
+  std::string error;
+  if (!iggpu::tools::read_obj(obj_path, mesh, error)) {
+    std::cerr << error << std::endl;
+    return -1;
+  }
+  auto write_rsl = iggpu::write_mesh_file(
+      igmesh_path, iggpu::tools::to_mesh_file_desc(mesh));
+  if (std::holds_alternative<iggpu::MeshFileError>(write_rsl)) {
+    std::cerr << "Failed to write " << igmesh_path << std::endl;
+    return -1;
+  }
+
+  auto app_create_rsl = iggpu::AppBase::CreateHeadless(
+      64u, 64u, wgpu::TextureFormat::BGRA8Unorm, opts.adapter_type);
+  if (std::holds_alternative<iggpu::AppBaseCreateError>(app_create_rsl)) {
+    std::cerr << "Failed to create app: "
+              << iggpu::app_base_create_error_text(
+                     std::get<iggpu::AppBaseCreateError>(app_create_rsl))
+              << std::endl;
+    return -1;
+  }
+
+  std::unique_ptr<iggpu::AppBase> app_base =
+      std::move(std::get<std::unique_ptr<iggpu::AppBase>>(app_create_rsl));
+
+  struct Loader {
+    const char* name;
+    const std::string& path;
+    LoadFn load;
+  };
+  Loader loaders[] = {
+      {"obj", obj_path, ::load_obj},
+      {"igmesh_read", igmesh_path, ::load_igmesh_read},
+      {"igmesh_mmap", igmesh_path, ::load_igmesh_mmap},
+  };
+
+  std::vector<LoaderResult> results;
+  for (const auto& loader : loaders) {
+    std::cerr << "Running loader " << loader.name << "..." << std::endl;
+    LoaderResult result{loader.name, {}};
+    if (!::run_loader(app_base.get(), loader.path, loader.load,
+                      opts.iterations, result.load_ms)) {
+      std::cerr << "Loader " << loader.name << " failed" << std::endl;
+      return -1;
+    }
+    results.push_back(result);
+  }
+
+  std::string json = "{\n";
+  json += "  \"mesh\": {\"vertices\": " + std::to_string(mesh.vertex_count()) +
+          ", \"indices\": " + std::to_string(mesh.indices.size()) +
+          ", \"obj_bytes\": " +
+          std::to_string(std::filesystem::file_size(obj_path)) +
+          ", \"igmesh_bytes\": " +
+          std::to_string(std::get<uint64_t>(write_rsl)) + "},\n";
+  json += "  \"loaders\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    json += "    {\"name\": \"" + results[i].name + "\", \"load_ms\": " +
+            ::json_percentiles(results[i].load_ms) + "}";
+    json += (i + 1 < results.size()) ? ",\n" : "\n";
+  }
+  json += "  ]\n";
+  json += "}\n";
+
+  if (opts.out_path.empty()) {
+    std::cout << json;
+    return 0;
+  }
+
+  std::FILE* f = std::fopen(opts.out_path.c_str(), "w");
+  if (!f) {
+    std::cerr << "Failed to open " << opts.out_path << std::endl;
+    return -1;
+  }
+  std::fwrite(json.data(), 1, json.size(), f);
+  std::fclose(f);
+  return 0;
+}
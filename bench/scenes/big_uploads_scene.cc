@@ -0,0 +1,116 @@
+#include <iggpu/upload_ring.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "bench_scene.h"
+#include "bench_util.h"
+
+namespace {
+
+const uint64_t kChunkSize = 4ull * 1024ull * 1024ull;
+
+// Streams a large amount of data to the GPU every frame in fixed size chunks,
+//  either through Queue.WriteBuffer or through an iggpu::UploadRing, then
+//  clears the backbuffer
+class BigUploadsScene : public iggpu::bench::BenchScene {
+ public:
+  BigUploadsScene(uint64_t bytes_per_frame, bool use_upload_ring)
+      : bytes_per_frame_((bytes_per_frame + 3ull) & ~3ull),
+        use_upload_ring_(use_upload_ring),
+        frame_idx_(0u) {}
+
+  const char* name() const override {
+    return use_upload_ring_ ? "big_uploads_ring" : "big_uploads";
+  }
+
+  bool load(iggpu::AppBase* app_base) override {
+    wgpu::BufferDescriptor bd{};
+    bd.size = bytes_per_frame_;
+    bd.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+    dst_buffer_ = app_base->Device.CreateBuffer(&bd);
+
+    scratch_.resize(std::min(bytes_per_frame_, ::kChunkSize));
+    if (use_upload_ring_) {
+      // Enough staging slots for a few frames in flight
+      uint32_t chunks_per_frame =
+          (bytes_per_frame_ + ::kChunkSize - 1u) / ::kChunkSize;
+      upload_ring_ = std::make_unique<iggpu::UploadRing>(
+          app_base, ::kChunkSize, chunks_per_frame * 3u);
+    }
+    return static_cast<bool>(dst_buffer_);
+  }
+
+  uint32_t render_frame(iggpu::AppBase* app_base,
+                        iggpu::FrameTimer& timer) override {
+    timer.begin_frame();
+
+    // Touch the source data so that every frame uploads "new" contents
+    std::fill(scratch_.begin(), scratch_.end(),
+              static_cast<uint8_t>(frame_idx_++));
+    for (uint64_t offset = 0; offset < bytes_per_frame_;
+         offset += scratch_.size()) {
+      uint64_t size = std::min<uint64_t>(scratch_.size(),
+                                         bytes_per_frame_ - offset);
+      if (upload_ring_) {
+        upload_ring_->upload(dst_buffer_, offset, scratch_.data(), size);
+      } else {
+        app_base->Queue.WriteBuffer(dst_buffer_, offset, scratch_.data(),
+                                    size);
+      }
+    }
+
+    iggpu::bench::ClearPass clear_pass(
+        app_base->get_current_texture().CreateView());
+    clear_pass.desc.timestampWrites = timer.render_pass_timestamps("clear");
+
+    wgpu::CommandEncoder encoder = app_base->Device.CreateCommandEncoder();
+    if (upload_ring_) {
+      upload_ring_->record_copies(encoder);
+    }
+    encoder.BeginRenderPass(&clear_pass.desc).End();
+    timer.end_encode(encoder);
+    timer.submit(encoder.Finish());
+    if (upload_ring_) {
+      upload_ring_->on_submitted();
+    }
+    timer.present();
+    return 1u;
+  }
+
+  std::string stats_json() const override {
+    if (!upload_ring_) {
+      return "";
+    }
+
+    auto stats = upload_ring_->stats();
+    return "{\"bytes_uploaded\": " + std::to_string(stats.bytes_uploaded) +
+           ", \"upload_count\": " + std::to_string(stats.upload_count) +
+           ", \"stall_count\": " + std::to_string(stats.stall_count) +
+           ", \"high_water_bytes\": " +
+           std::to_string(stats.high_water_bytes) +
+           ", \"slot_count\": " + std::to_string(stats.slot_count) +
+           ", \"high_water_slots\": " +
+           std::to_string(stats.high_water_slots) + "}";
+  }
+
+ private:
+  uint64_t bytes_per_frame_;
+  bool use_upload_ring_;
+  uint32_t frame_idx_;
+  std::unique_ptr<iggpu::UploadRing> upload_ring_;
+  wgpu::Buffer dst_buffer_;
+  std::vector<uint8_t> scratch_;
+};
+
+}  // namespace
+
+namespace iggpu::bench {
+
+std::unique_ptr<BenchScene> create_big_uploads_scene(uint64_t bytes_per_frame,
+                                                     bool use_upload_ring) {
+  return std::make_unique<::BigUploadsScene>(bytes_per_frame, use_upload_ring);
+}
+
+}  // namespace iggpu::bench
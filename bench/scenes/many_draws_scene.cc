@@ -0,0 +1,76 @@
+#include "bench_scene.h"
+#include "bench_util.h"
+
+namespace {
+
+// Each instance index draws one small triangle in a 128x128 grid, so every
+//  draw call is a separate (tiny) piece of work with no state changes.
+const char kShaderCode[] = R"(
+@vertex
+fn vs_main(@builtin(vertex_index) vidx: u32,
+           @builtin(instance_index) iidx: u32) -> @builtin(position) vec4<f32> {
+  let cols = 128u;
+  let cell = 2.0 / f32(cols);
+  let origin = vec2<f32>(f32(iidx % cols), f32((iidx / cols) % cols)) * cell - vec2<f32>(1.0, 1.0);
+  var pos = array<vec2<f32>, 3>(vec2<f32>(0.0, cell), vec2<f32>(0.0, 0.0), vec2<f32>(cell, 0.0));
+  return vec4<f32>(origin + pos[vidx], 0.0, 1.0);
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4<f32> {
+  return vec4<f32>(0.1, 0.6, 0.3, 1.0);
+}
+)";
+
+class ManyDrawsScene : public iggpu::bench::BenchScene {
+ public:
+  explicit ManyDrawsScene(uint32_t draw_count) : draw_count_(draw_count) {}
+
+  const char* name() const override { return "many_draws"; }
+
+  bool load(iggpu::AppBase* app_base) override {
+    auto module =
+        iggpu::bench::create_wgsl_module(app_base->Device, ::kShaderCode);
+    pipeline_ = iggpu::bench::create_simple_pipeline(
+        app_base->Device, module, app_base->SurfaceFormat);
+    return static_cast<bool>(pipeline_);
+  }
+
+  uint32_t render_frame(iggpu::AppBase* app_base,
+                        iggpu::FrameTimer& timer) override {
+    timer.begin_frame();
+
+    iggpu::bench::ClearPass clear_pass(
+        app_base->get_current_texture().CreateView());
+    clear_pass.desc.timestampWrites =
+        timer.render_pass_timestamps("many_draws");
+
+    wgpu::CommandEncoder encoder = app_base->Device.CreateCommandEncoder();
+    {
+      wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&clear_pass.desc);
+      pass.SetPipeline(pipeline_);
+      for (uint32_t i = 0; i < draw_count_; i++) {
+        pass.Draw(3, 1, 0, i);
+      }
+      pass.End();
+    }
+    timer.end_encode(encoder);
+    timer.submit(encoder.Finish());
+    timer.present();
+    return 1u;
+  }
+
+ private:
+  uint32_t draw_count_;
+  wgpu::RenderPipeline pipeline_;
+};
+
+}  // namespace
+
+namespace iggpu::bench {
+
+std::unique_ptr<BenchScene> create_many_draws_scene(uint32_t draw_count) {
+  return std::make_unique<::ManyDrawsScene>(draw_count);
+}
+
+}  // namespace iggpu::bench
@@ -0,0 +1,348 @@
+#include <iggpu/draw_batcher.h>
+#include <iggpu/gpu_memory.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_scene.h"
+#include "bench_util.h"
+
+namespace {
+
+// A grid of small objects, each one of 2 meshes drawn with one of 2
+//  pipelines and 4 materials. Objects are submitted with their state
+//  interleaved, as a scene traversal would, so drawing them in order
+//  changes state on every object.
+const uint32_t kPipelineCount = 2u;
+const uint32_t kMaterialCount = 4u;
+const uint32_t kMeshCount = 2u;
+
+const char kShaderCode[] = R"(
+struct Material {
+  color: vec4<f32>,
+}
+
+@group(0) @binding(0) var<uniform> material: Material;
+
+struct VertexOut {
+  @builtin(position) position: vec4<f32>,
+  @location(0) shade: f32,
+}
+
+@vertex
+fn vs_main(@location(0) pos: vec2<f32>,
+           @location(1) instance: vec4<f32>) -> VertexOut {
+  var out: VertexOut;
+  out.position = vec4<f32>(instance.xy + pos * instance.z, 0.0, 1.0);
+  out.shade = instance.w;
+  return out;
+}
+
+@fragment
+fn fs_flat(in: VertexOut) -> @location(0) vec4<f32> {
+  return material.color;
+}
+
+@fragment
+fn fs_shaded(in: VertexOut) -> @location(0) vec4<f32> {
+  return vec4<f32>(material.color.rgb * in.shade, 1.0);
+}
+)";
+
+// Triangle (vertices 0-2) and quad (vertices 3-6) in shared buffers
+const float kVertices[] = {0.f, 1.f, 0.f, 0.f, 1.f, 0.f,
+                           0.f, 0.f, 1.f, 0.f, 1.f, 1.f, 0.f, 1.f};
+const uint16_t kIndices[] = {0u, 1u, 2u, 0u, 1u, 2u, 0u, 2u, 3u, 0u};
+
+// offset (xy), scale, shade
+struct Instance {
+  float data[4];
+};
+
+const char* mode_name(iggpu::bench::BatchingMode mode) {
+  switch (mode) {
+    case iggpu::bench::BatchingMode::Direct:
+      return "many_objects";
+    case iggpu::bench::BatchingMode::Batched:
+      return "many_objects_batched";
+    case iggpu::bench::BatchingMode::Indirect:
+      return "many_objects_indirect";
+  }
+  return "many_objects";
+}
+
+wgpu::RenderPipeline create_pipeline(const wgpu::Device& device,
+                                     const wgpu::ShaderModule& module,
+                                     const char* fs_entry_point,
+                                     wgpu::TextureFormat format,
+                                     wgpu::BindGroupLayout layout) {
+  wgpu::PipelineLayoutDescriptor pl{};
+  pl.bindGroupLayoutCount = 1;
+  pl.bindGroupLayouts = &layout;
+
+  wgpu::VertexAttribute position_attribute{};
+  position_attribute.format = wgpu::VertexFormat::Float32x2;
+  position_attribute.shaderLocation = 0;
+
+  wgpu::VertexAttribute instance_attribute{};
+  instance_attribute.format = wgpu::VertexFormat::Float32x4;
+  instance_attribute.shaderLocation = 1;
+
+  wgpu::VertexBufferLayout buffers[2]{};
+  buffers[0].arrayStride = 2 * sizeof(float);
+  buffers[0].stepMode = wgpu::VertexStepMode::Vertex;
+  buffers[0].attributeCount = 1;
+  buffers[0].attributes = &position_attribute;
+  buffers[1].arrayStride = sizeof(Instance);
+  buffers[1].stepMode = wgpu::VertexStepMode::Instance;
+  buffers[1].attributeCount = 1;
+  buffers[1].attributes = &instance_attribute;
+
+  wgpu::ColorTargetState colorTargetState{};
+  colorTargetState.format = format;
+
+  wgpu::FragmentState fragmentState{};
+  fragmentState.module = module;
+  fragmentState.entryPoint = fs_entry_point;
+  fragmentState.targetCount = 1;
+  fragmentState.targets = &colorTargetState;
+
+  wgpu::RenderPipelineDescriptor rpd{};
+  rpd.layout = device.CreatePipelineLayout(&pl);
+  rpd.vertex.module = module;
+  rpd.vertex.entryPoint = "vs_main";
+  rpd.vertex.bufferCount = 2;
+  rpd.vertex.buffers = buffers;
+  rpd.fragment = &fragmentState;
+  rpd.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+
+  return device.CreateRenderPipeline(&rpd);
+}
+
+// The same objects drawn one draw call (and one set of state changes) per
+//  object, or through an iggpu::DrawBatcher (with direct or indirect draws)
+class ManyObjectsScene : public iggpu::bench::BenchScene {
+ public:
+  ManyObjectsScene(uint32_t object_count, iggpu::bench::BatchingMode mode)
+      : object_count_(object_count), mode_(mode), frame_idx_(0u) {}
+
+  ~ManyObjectsScene() override {
+    iggpu::destroy_buffer(vertex_buffer_);
+    iggpu::destroy_buffer(index_buffer_);
+    iggpu::destroy_buffer(instance_buffer_);
+    for (auto& buffer : material_buffers_) {
+      iggpu::destroy_buffer(buffer);
+    }
+  }
+
+  const char* name() const override { return ::mode_name(mode_); }
+
+  bool load(iggpu::AppBase* app_base) override {
+    const wgpu::Device& device = app_base->Device;
+
+    wgpu::BufferDescriptor bd{};
+    bd.size = sizeof(::kVertices);
+    bd.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
+    vertex_buffer_ = iggpu::create_buffer(device, bd, "many_objects");
+    app_base->Queue.WriteBuffer(vertex_buffer_, 0, ::kVertices, bd.size);
+
+    bd.size = sizeof(::kIndices);
+    bd.usage = wgpu::BufferUsage::Index | wgpu::BufferUsage::CopyDst;
+    index_buffer_ = iggpu::create_buffer(device, bd, "many_objects");
+    app_base->Queue.WriteBuffer(index_buffer_, 0, ::kIndices, bd.size);
+
+    meshes_[0].vertex_buffer = vertex_buffer_;
+    meshes_[0].index_buffer = index_buffer_;
+    meshes_[0].element_count = 3u;
+    meshes_[1] = meshes_[0];
+    meshes_[1].element_count = 6u;
+    meshes_[1].first_element = 3u;
+    meshes_[1].base_vertex = 3;
+
+    wgpu::BindGroupLayoutEntry entry{};
+    entry.binding = 0;
+    entry.visibility = wgpu::ShaderStage::Fragment;
+    entry.buffer.type = wgpu::BufferBindingType::Uniform;
+    wgpu::BindGroupLayoutDescriptor bgld{};
+    bgld.entryCount = 1;
+    bgld.entries = &entry;
+    wgpu::BindGroupLayout layout = device.CreateBindGroupLayout(&bgld);
+
+    for (uint32_t m = 0; m < ::kMaterialCount; m++) {
+      float color[4] = {0.2f + 0.2f * m, 0.6f, 1.f - 0.2f * m, 1.f};
+      bd.size = sizeof(color);
+      bd.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+      wgpu::Buffer buffer = iggpu::create_buffer(device, bd, "many_objects");
+      app_base->Queue.WriteBuffer(buffer, 0, color, sizeof(color));
+
+      wgpu::BindGroupEntry bge{};
+      bge.binding = 0;
+      bge.buffer = buffer;
+      wgpu::BindGroupDescriptor bgd{};
+      bgd.layout = layout;
+      bgd.entryCount = 1;
+      bgd.entries = &bge;
+      materials_.push_back(device.CreateBindGroup(&bgd));
+      material_buffers_.push_back(std::move(buffer));
+    }
+
+    auto module = iggpu::bench::create_wgsl_module(device, ::kShaderCode);
+    const char* fs_entry_points[::kPipelineCount] = {"fs_flat", "fs_shaded"};
+    for (uint32_t p = 0; p < ::kPipelineCount; p++) {
+      pipelines_[p] = ::create_pipeline(device, module, fs_entry_points[p],
+                                        app_base->SurfaceFormat, layout);
+      if (!pipelines_[p]) {
+        return false;
+      }
+    }
+
+    instances_.resize(object_count_);
+    if (mode_ == iggpu::bench::BatchingMode::Direct) {
+      bd.size = std::max<uint64_t>(instances_.size() * sizeof(Instance), 16u);
+      bd.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
+      instance_buffer_ = iggpu::create_buffer(device, bd, "many_objects");
+      return static_cast<bool>(instance_buffer_);
+    }
+
+    iggpu::DrawBatcherDesc desc{};
+    desc.indirect = mode_ == iggpu::bench::BatchingMode::Indirect;
+    batcher_ = std::make_unique<iggpu::DrawBatcher>(app_base, desc);
+    for (uint32_t m = 0; m < ::kMeshCount; m++) {
+      mesh_ids_[m] = batcher_->add_mesh(meshes_[m]);
+    }
+    return true;
+  }
+
+  uint32_t render_frame(iggpu::AppBase* app_base,
+                        iggpu::FrameTimer& timer) override {
+    timer.begin_frame();
+
+    iggpu::bench::ClearPass clear_pass(
+        app_base->get_current_texture().CreateView());
+    clear_pass.desc.timestampWrites = timer.render_pass_timestamps(name());
+
+    // Per-object data changes every frame, as it would with moving objects
+    const uint32_t cols = static_cast<uint32_t>(
+        std::ceil(std::sqrt(static_cast<double>(object_count_))));
+    const float cell = 2.f / cols;
+    const float shade = 0.5f + static_cast<float>(frame_idx_++ % 60u) / 120.f;
+    for (uint32_t i = 0; i < object_count_; i++) {
+      instances_[i] = {(i % cols) * cell - 1.f, (i / cols) * cell - 1.f,
+                       cell * 0.8f, shade};
+    }
+
+    wgpu::CommandEncoder encoder = app_base->Device.CreateCommandEncoder();
+    {
+      wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&clear_pass.desc);
+      if (batcher_) {
+        record_batched(pass);
+      } else {
+        record_direct(app_base, pass);
+      }
+      pass.End();
+    }
+    timer.end_encode(encoder);
+    timer.submit(encoder.Finish());
+    timer.present();
+    return 1u;
+  }
+
+  std::string stats_json() const override {
+    if (!batcher_) {
+      return "{\"draw_calls\": " + std::to_string(object_count_) + "}";
+    }
+
+    auto stats = batcher_->stats();
+    return "{\"draw_calls\": " + std::to_string(stats.batches) +
+           ", \"pipeline_changes\": " +
+           std::to_string(stats.pipeline_changes) +
+           ", \"bind_group_changes\": " +
+           std::to_string(stats.bind_group_changes) +
+           ", \"instance_bytes\": " + std::to_string(stats.instance_bytes) +
+           "}";
+  }
+
+ private:
+  uint32_t mesh_of(uint32_t i) const { return i % ::kMeshCount; }
+  uint32_t pipeline_of(uint32_t i) const {
+    return (i / ::kMeshCount) % ::kPipelineCount;
+  }
+  uint32_t material_of(uint32_t i) const {
+    return (i / (::kMeshCount * ::kPipelineCount)) % ::kMaterialCount;
+  }
+
+  void record_direct(iggpu::AppBase* app_base,
+                     wgpu::RenderPassEncoder& pass) {
+    app_base->Queue.WriteBuffer(instance_buffer_, 0, instances_.data(),
+                                instances_.size() * sizeof(Instance));
+    for (uint32_t i = 0; i < object_count_; i++) {
+      const iggpu::BatchMesh& mesh = meshes_[mesh_of(i)];
+      pass.SetPipeline(pipelines_[pipeline_of(i)]);
+      pass.SetBindGroup(0, materials_[material_of(i)]);
+      pass.SetVertexBuffer(0, mesh.vertex_buffer);
+      pass.SetIndexBuffer(mesh.index_buffer, mesh.index_format);
+      pass.SetVertexBuffer(1, instance_buffer_, i * sizeof(Instance),
+                           sizeof(Instance));
+      pass.DrawIndexed(mesh.element_count, 1, mesh.first_element,
+                       mesh.base_vertex);
+    }
+  }
+
+  void record_batched(wgpu::RenderPassEncoder& pass) {
+    // Items for each combination of state are built once - only the
+    //  instance data changes between objects
+    iggpu::DrawItem items[::kPipelineCount][::kMaterialCount][::kMeshCount];
+    for (uint32_t p = 0; p < ::kPipelineCount; p++) {
+      for (uint32_t m = 0; m < ::kMaterialCount; m++) {
+        for (uint32_t k = 0; k < ::kMeshCount; k++) {
+          items[p][m][k].mesh = mesh_ids_[k];
+          items[p][m][k].pipeline = pipelines_[p];
+          items[p][m][k].bind_groups[0] = materials_[m];
+          items[p][m][k].instance_size = sizeof(Instance);
+        }
+      }
+    }
+
+    for (uint32_t i = 0; i < object_count_; i++) {
+      iggpu::DrawItem& item =
+          items[pipeline_of(i)][material_of(i)][mesh_of(i)];
+      item.instance_data = &instances_[i];
+      batcher_->add(item);
+    }
+    batcher_->prepare();
+    batcher_->record(pass);
+    batcher_->clear();
+  }
+
+  uint32_t object_count_;
+  iggpu::bench::BatchingMode mode_;
+  uint32_t frame_idx_;
+
+  wgpu::Buffer vertex_buffer_;
+  wgpu::Buffer index_buffer_;
+  iggpu::BatchMesh meshes_[::kMeshCount];
+  wgpu::RenderPipeline pipelines_[::kPipelineCount];
+  std::vector<wgpu::BindGroup> materials_;
+  std::vector<wgpu::Buffer> material_buffers_;
+  std::vector<Instance> instances_;
+
+  // Direct mode - every object's instance data, bound at its offset
+  wgpu::Buffer instance_buffer_;
+
+  std::unique_ptr<iggpu::DrawBatcher> batcher_;
+  uint32_t mesh_ids_[::kMeshCount];
+};
+
+}  // namespace
+
+namespace iggpu::bench {
+
+std::unique_ptr<BenchScene> create_many_objects_scene(uint32_t object_count,
+                                                      BatchingMode mode) {
+  return std::make_unique<::ManyObjectsScene>(object_count, mode);
+}
+
+}  // namespace iggpu::bench
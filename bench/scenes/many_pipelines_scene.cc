@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <vector>
+
+#include "bench_scene.h"
+#include "bench_util.h"
+
+namespace {
+
+// Every pipeline gets its own shader module (differing only by output color)
+//  so that the backend cannot share compiled shaders between them.
+const char kShaderTemplate[] = R"(
+@vertex
+fn vs_main(@builtin(vertex_index) vidx: u32) -> @builtin(position) vec4<f32> {
+  var pos = array<vec2<f32>, 3>(vec2<f32>(0.0, 0.5), vec2<f32>(-0.5, -0.5), vec2<f32>(0.5, -0.5));
+  return vec4<f32>(pos[vidx], 0.0, 1.0);
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4<f32> {
+  return vec4<f32>(%f, %f, 0.5, 1.0);
+}
+)";
+
+class ManyPipelinesScene : public iggpu::bench::BenchScene {
+ public:
+  explicit ManyPipelinesScene(uint32_t pipeline_count)
+      : pipeline_count_(pipeline_count) {}
+
+  const char* name() const override { return "many_pipelines"; }
+
+  bool load(iggpu::AppBase* app_base) override {
+    char shader_code[sizeof(::kShaderTemplate) + 64];
+    for (uint32_t i = 0; i < pipeline_count_; i++) {
+      float t = static_cast<float>(i) / pipeline_count_;
+      std::snprintf(shader_code, sizeof(shader_code), ::kShaderTemplate, t,
+                    1.f - t);
+      auto module =
+          iggpu::bench::create_wgsl_module(app_base->Device, shader_code);
+      auto pipeline = iggpu::bench::create_simple_pipeline(
+          app_base->Device, module, app_base->SurfaceFormat);
+      if (!pipeline) {
+        return false;
+      }
+      pipelines_.push_back(pipeline);
+    }
+    return true;
+  }
+
+  uint32_t render_frame(iggpu::AppBase* app_base,
+                        iggpu::FrameTimer& timer) override {
+    timer.begin_frame();
+
+    iggpu::bench::ClearPass clear_pass(
+        app_base->get_current_texture().CreateView());
+    clear_pass.desc.timestampWrites =
+        timer.render_pass_timestamps("many_pipelines");
+
+    wgpu::CommandEncoder encoder = app_base->Device.CreateCommandEncoder();
+    {
+      wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&clear_pass.desc);
+      for (const auto& pipeline : pipelines_) {
+        pass.SetPipeline(pipeline);
+        pass.Draw(3);
+      }
+      pass.End();
+    }
+    timer.end_encode(encoder);
+    timer.submit(encoder.Finish());
+    timer.present();
+    return 1u;
+  }
+
+ private:
+  uint32_t pipeline_count_;
+  std::vector<wgpu::RenderPipeline> pipelines_;
+};
+
+}  // namespace
+
+namespace iggpu::bench {
+
+std::unique_ptr<BenchScene> create_many_pipelines_scene(
+    uint32_t pipeline_count) {
+  return std::make_unique<::ManyPipelinesScene>(pipeline_count);
+}
+
+}  // namespace iggpu::bench
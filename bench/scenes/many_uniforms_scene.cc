@@ -0,0 +1,182 @@
+#include <iggpu/gpu_memory.h>
+#include <iggpu/uniform_arena.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_scene.h"
+#include "bench_util.h"
+
+namespace {
+
+// Same grid of triangles as many_draws, but each draw reads its position and
+//  color from per-draw constants that change every frame
+const char kShaderCode[] = R"(
+struct DrawConstants {
+  origin: vec2<f32>,
+  scale: f32,
+  color: vec4<f32>,
+}
+
+@group(0) @binding(0) var<uniform> draw: DrawConstants;
+
+@vertex
+fn vs_main(@builtin(vertex_index) vidx: u32) -> @builtin(position) vec4<f32> {
+  var pos = array<vec2<f32>, 3>(vec2<f32>(0.0, 1.0), vec2<f32>(0.0, 0.0), vec2<f32>(1.0, 0.0));
+  return vec4<f32>(draw.origin + pos[vidx] * draw.scale, 0.0, 1.0);
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4<f32> {
+  return draw.color;
+}
+)";
+
+// Matches DrawConstants (WGSL layout: vec4 aligned to 16 bytes)
+struct DrawConstants {
+  float origin[2];
+  float scale;
+  float pad;
+  float color[4];
+};
+
+// Per-draw constants either in one buffer per object, each updated with its
+//  own Queue.WriteBuffer (the pattern UniformArena replaces), or allocated
+//  from an iggpu::UniformArena
+class ManyUniformsScene : public iggpu::bench::BenchScene {
+ public:
+  ManyUniformsScene(uint32_t draw_count, bool use_arena)
+      : draw_count_(draw_count), use_arena_(use_arena), frame_idx_(0u) {}
+
+  ~ManyUniformsScene() override {
+    for (auto& buffer : object_buffers_) {
+      iggpu::destroy_buffer(buffer);
+    }
+  }
+
+  const char* name() const override {
+    return use_arena_ ? "many_uniforms_arena" : "many_uniforms";
+  }
+
+  bool load(iggpu::AppBase* app_base) override {
+    iggpu::UniformArenaDesc desc{};
+    desc.binding_size = sizeof(DrawConstants);
+    arena_ = std::make_unique<iggpu::UniformArena>(app_base, desc);
+
+    auto module =
+        iggpu::bench::create_wgsl_module(app_base->Device, ::kShaderCode);
+    pipeline_ = iggpu::bench::create_simple_pipeline(
+        app_base->Device, module, app_base->SurfaceFormat,
+        arena_->bind_group_layout());
+
+    if (!use_arena_) {
+      for (uint32_t i = 0; i < draw_count_; i++) {
+        wgpu::BufferDescriptor bd{};
+        bd.size = sizeof(DrawConstants);
+        bd.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+        wgpu::Buffer buffer =
+            iggpu::create_buffer(app_base->Device, bd, "many_uniforms");
+
+        wgpu::BindGroupEntry entry{};
+        entry.binding = 0u;
+        entry.buffer = buffer;
+        entry.size = sizeof(DrawConstants);
+
+        wgpu::BindGroupDescriptor bgd{};
+        bgd.layout = arena_->bind_group_layout();
+        bgd.entryCount = 1u;
+        bgd.entries = &entry;
+        object_bind_groups_.push_back(
+            app_base->Device.CreateBindGroup(&bgd));
+        object_buffers_.push_back(std::move(buffer));
+      }
+    }
+    return static_cast<bool>(pipeline_);
+  }
+
+  uint32_t render_frame(iggpu::AppBase* app_base,
+                        iggpu::FrameTimer& timer) override {
+    timer.begin_frame();
+
+    iggpu::bench::ClearPass clear_pass(
+        app_base->get_current_texture().CreateView());
+    clear_pass.desc.timestampWrites = timer.render_pass_timestamps(name());
+
+    const uint32_t cols = 128u;
+    const float cell = 2.f / cols;
+    float pulse = static_cast<float>(frame_idx_++ % 60u) / 60.f;
+
+    wgpu::CommandEncoder encoder = app_base->Device.CreateCommandEncoder();
+    {
+      wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&clear_pass.desc);
+      pass.SetPipeline(pipeline_);
+      for (uint32_t i = 0; i < draw_count_; i++) {
+        DrawConstants c{};
+        c.origin[0] = (i % cols) * cell - 1.f;
+        c.origin[1] = ((i / cols) % cols) * cell - 1.f;
+        c.scale = cell;
+        c.color[0] = pulse;
+        c.color[1] = 0.6f;
+        c.color[2] = static_cast<float>(i % cols) / cols;
+        c.color[3] = 1.f;
+
+        if (use_arena_) {
+          iggpu::UniformAllocation a = arena_->push(c);
+          pass.SetBindGroup(0, a.bind_group, 1, &a.dynamic_offset);
+        } else {
+          app_base->Queue.WriteBuffer(object_buffers_[i], 0, &c, sizeof(c));
+          uint32_t dynamic_offset = 0u;
+          pass.SetBindGroup(0, object_bind_groups_[i], 1, &dynamic_offset);
+        }
+        pass.Draw(3);
+      }
+      pass.End();
+    }
+    if (use_arena_) {
+      arena_->upload();
+    }
+    timer.end_encode(encoder);
+    timer.submit(encoder.Finish());
+    if (use_arena_) {
+      arena_->end_frame();
+    }
+    timer.present();
+    return 1u;
+  }
+
+  std::string stats_json() const override {
+    if (!use_arena_) {
+      return "";
+    }
+
+    auto stats = arena_->stats();
+    return "{\"allocations\": " + std::to_string(stats.allocations) +
+           ", \"uploads\": " + std::to_string(stats.uploads) +
+           ", \"high_water_bytes\": " +
+           std::to_string(stats.high_water_bytes) +
+           ", \"page_count\": " + std::to_string(stats.page_count) + "}";
+  }
+
+ private:
+  uint32_t draw_count_;
+  bool use_arena_;
+  uint32_t frame_idx_;
+  std::unique_ptr<iggpu::UniformArena> arena_;
+  wgpu::RenderPipeline pipeline_;
+
+  // One buffer and bind group per object, without the arena
+  std::vector<wgpu::Buffer> object_buffers_;
+  std::vector<wgpu::BindGroup> object_bind_groups_;
+};
+
+}  // namespace
+
+namespace iggpu::bench {
+
+std::unique_ptr<BenchScene> create_many_uniforms_scene(uint32_t draw_count,
+                                                       bool use_arena) {
+  return std::make_unique<::ManyUniformsScene>(draw_count, use_arena);
+}
+
+}  // namespace iggpu::bench
@@ -0,0 +1,123 @@
+#include <iggpu/parallel_encoder.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_scene.h"
+#include "bench_util.h"
+
+namespace {
+
+// Same draws as many_draws, split into a fixed number of render bundles so
+//  that GPU work is identical for every thread count - only CPU encoding
+//  time should change.
+const uint32_t kBundleCount = 16u;
+
+const char kShaderCode[] = R"(
+@vertex
+fn vs_main(@builtin(vertex_index) vidx: u32,
+           @builtin(instance_index) iidx: u32) -> @builtin(position) vec4<f32> {
+  let cols = 128u;
+  let cell = 2.0 / f32(cols);
+  let origin = vec2<f32>(f32(iidx % cols), f32((iidx / cols) % cols)) * cell - vec2<f32>(1.0, 1.0);
+  var pos = array<vec2<f32>, 3>(vec2<f32>(0.0, cell), vec2<f32>(0.0, 0.0), vec2<f32>(cell, 0.0));
+  return vec4<f32>(origin + pos[vidx], 0.0, 1.0);
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4<f32> {
+  return vec4<f32>(0.6, 0.3, 0.1, 1.0);
+}
+)";
+
+class ParallelDrawsScene : public iggpu::bench::BenchScene {
+ public:
+  ParallelDrawsScene(uint32_t draw_count, uint32_t thread_count)
+      : draw_count_(draw_count),
+        thread_count_(thread_count == 0u ? 1u : thread_count),
+        name_("parallel_draws_t" + std::to_string(thread_count_)) {}
+
+  const char* name() const override { return name_.c_str(); }
+
+  bool load(iggpu::AppBase* app_base) override {
+    auto module =
+        iggpu::bench::create_wgsl_module(app_base->Device, ::kShaderCode);
+    pipeline_ = iggpu::bench::create_simple_pipeline(
+        app_base->Device, module, app_base->SurfaceFormat);
+    encoder_ = std::make_unique<iggpu::ParallelEncoder>(app_base,
+                                                        thread_count_ - 1u);
+    surface_format_ = app_base->SurfaceFormat;
+    return static_cast<bool>(pipeline_);
+  }
+
+  uint32_t render_frame(iggpu::AppBase* app_base,
+                        iggpu::FrameTimer& timer) override {
+    timer.begin_frame();
+
+    std::vector<iggpu::ParallelEncoder::BundleJob> jobs;
+    uint32_t draws_per_bundle =
+        (draw_count_ + ::kBundleCount - 1u) / ::kBundleCount;
+    for (uint32_t b = 0; b < ::kBundleCount; b++) {
+      uint32_t first = b * draws_per_bundle;
+      uint32_t last = std::min(first + draws_per_bundle, draw_count_);
+      jobs.push_back([this, first, last](wgpu::RenderBundleEncoder& encoder) {
+        encoder.SetPipeline(pipeline_);
+        for (uint32_t i = first; i < last; i++) {
+          encoder.Draw(3, 1, 0, i);
+        }
+      });
+    }
+
+    wgpu::RenderBundleEncoderDescriptor bundle_desc{};
+    bundle_desc.colorFormatCount = 1;
+    bundle_desc.colorFormats = &surface_format_;
+    std::vector<wgpu::RenderBundle> bundles =
+        encoder_->record_bundles(bundle_desc, jobs);
+
+    iggpu::bench::ClearPass clear_pass(
+        app_base->get_current_texture().CreateView());
+    clear_pass.desc.timestampWrites =
+        timer.render_pass_timestamps("parallel_draws");
+
+    wgpu::CommandEncoder encoder = app_base->Device.CreateCommandEncoder();
+    {
+      wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&clear_pass.desc);
+      pass.ExecuteBundles(bundles.size(), bundles.data());
+      pass.End();
+    }
+    timer.end_encode(encoder);
+    timer.submit(encoder.Finish());
+    timer.present();
+    return 1u;
+  }
+
+  std::string stats_json() const override {
+    iggpu::ParallelEncoderStats stats = encoder_->stats();
+    return "{\"threads\": " + std::to_string(thread_count_) +
+           ", \"worker_threads\": " +
+           std::to_string(encoder_->worker_count()) +
+           ", \"jobs\": " + std::to_string(stats.jobs) +
+           ", \"worker_jobs\": " + std::to_string(stats.worker_jobs) + "}";
+  }
+
+ private:
+  uint32_t draw_count_;
+  uint32_t thread_count_;
+  std::string name_;
+  wgpu::RenderPipeline pipeline_;
+  wgpu::TextureFormat surface_format_;
+  std::unique_ptr<iggpu::ParallelEncoder> encoder_;
+};
+
+}  // namespace
+
+namespace iggpu::bench {
+
+std::unique_ptr<BenchScene> create_parallel_draws_scene(uint32_t draw_count,
+                                                        uint32_t thread_count) {
+  return std::make_unique<::ParallelDrawsScene>(draw_count, thread_count);
+}
+
+}  // namespace iggpu::bench
@@ -0,0 +1,68 @@
+#include "bench_scene.h"
+#include "bench_util.h"
+
+namespace {
+
+const char kShaderCode[] = R"(
+@vertex
+fn vs_main(@builtin(vertex_index) idx: u32) -> @builtin(position) vec4<f32> {
+  var pos = array<vec2<f32>, 3>(vec2<f32>(0.0, 0.5), vec2<f32>(-0.5, -0.5), vec2<f32>(0.5, -0.5));
+  return vec4<f32>(pos[idx], 0.0, 1.0);
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4<f32> {
+  return vec4<f32>(0.294, 0.0, 0.51, 1.0);
+}
+)";
+
+// One triangle in a single color-only pass - a baseline for per-frame
+//  overhead. Unlike the simple_triangle sample there is no depth attachment,
+//  frame graph or render target pool, so this measures encode, submit and
+//  present alone.
+class TriangleScene : public iggpu::bench::BenchScene {
+ public:
+  const char* name() const override { return "triangle"; }
+
+  bool load(iggpu::AppBase* app_base) override {
+    auto module =
+        iggpu::bench::create_wgsl_module(app_base->Device, ::kShaderCode);
+    pipeline_ = iggpu::bench::create_simple_pipeline(
+        app_base->Device, module, app_base->SurfaceFormat);
+    return static_cast<bool>(pipeline_);
+  }
+
+  uint32_t render_frame(iggpu::AppBase* app_base,
+                        iggpu::FrameTimer& timer) override {
+    timer.begin_frame();
+
+    iggpu::bench::ClearPass clear_pass(
+        app_base->get_current_texture().CreateView());
+    clear_pass.desc.timestampWrites = timer.render_pass_timestamps("triangle");
+
+    wgpu::CommandEncoder encoder = app_base->Device.CreateCommandEncoder();
+    {
+      wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&clear_pass.desc);
+      pass.SetPipeline(pipeline_);
+      pass.Draw(3);
+      pass.End();
+    }
+    timer.end_encode(encoder);
+    timer.submit(encoder.Finish());
+    timer.present();
+    return 1u;
+  }
+
+ private:
+  wgpu::RenderPipeline pipeline_;
+};
+
+}  // namespace
+
+namespace iggpu::bench {
+
+std::unique_ptr<BenchScene> create_triangle_scene() {
+  return std::make_unique<::TriangleScene>();
+}
+
+}  // namespace iggpu::bench
@@ -0,0 +1,126 @@
+#ifndef IGGPU_BINDING_CACHE_H
+#define IGGPU_BINDING_CACHE_H
+
+#include <iggpu/app_base.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace iggpu {
+
+struct BindingCacheCounters {
+  uint64_t hits;
+  uint64_t misses;
+
+  // Idle for max_idle_frames, or referencing a destroyed resource
+  uint64_t evicted;
+
+  // Descriptors with extension structs (nextInChain), created uncached
+  uint64_t uncached;
+
+  uint32_t live;
+
+  double hit_rate() const {
+    uint64_t lookups = hits + misses;
+    return lookups == 0u ? 0. : static_cast<double>(hits) / lookups;
+  }
+};
+
+struct BindingCacheStats {
+  BindingCacheCounters bind_group_layouts;
+  BindingCacheCounters samplers;
+  BindingCacheCounters texture_views;
+  BindingCacheCounters bind_groups;
+};
+
+// Returns shared bind group layouts, samplers, texture views and bind groups
+//  for identical descriptors, instead of creating new objects every frame.
+//
+// Descriptors are keyed by their contents (the same way as PipelineManager -
+//  every field, with object handles by identity and labels ignored), so a
+//  material that rebuilds its bind group every frame gets the same
+//  wgpu::BindGroup back as long as its buffers, offsets and views match.
+//
+// Cached objects keep what they reference alive, so handles in keys can't be
+//  reused while an entry exists. Entries are evicted:
+//  * in end_frame, if unused for max_idle_frames frames (0 = never)
+//  * when a buffer or texture they reference is destroyed with
+//    iggpu::destroy_buffer/destroy_texture, or passed to evict_resource.
+//    Bind groups are linked to textures through views from texture_view().
+class BindingCache {
+ public:
+  explicit BindingCache(AppBase* app_base, uint32_t max_idle_frames = 120u);
+  ~BindingCache();
+  BindingCache(const BindingCache&) = delete;
+  BindingCache& operator=(const BindingCache&) = delete;
+
+  wgpu::BindGroupLayout bind_group_layout(
+      const wgpu::BindGroupLayoutDescriptor& desc);
+  wgpu::Sampler sampler(const wgpu::SamplerDescriptor& desc);
+  wgpu::TextureView texture_view(
+      const wgpu::Texture& texture,
+      const wgpu::TextureViewDescriptor* desc = nullptr);
+  wgpu::BindGroup bind_group(const wgpu::BindGroupDescriptor& desc);
+
+  // Evicts everything referencing handle (a WGPUBuffer, WGPUTexture,
+  //  WGPUTextureView or WGPUSampler) - for resources destroyed directly,
+  //  without iggpu::destroy_buffer/destroy_texture
+  void evict_resource(const void* handle);
+
+  // Call once per frame
+  void end_frame();
+
+  void clear();
+
+  BindingCacheStats stats() const;
+
+ private:
+  template <typename T>
+  struct Entry {
+    T object;
+    uint64_t last_used_frame;
+
+    // Handles of the buffers, textures, views and samplers the object uses
+    std::vector<const void*> resources;
+  };
+
+  template <typename T>
+  using EntryMap = std::unordered_map<std::string, Entry<T>>;
+
+  // Destroy notifications can come from any thread - they are applied on
+  //  the next cache call
+  struct DestroyedQueue {
+    std::mutex mutex;
+    std::vector<const void*> handles;
+    std::atomic<bool> has_pending{false};
+  };
+
+  void apply_destroyed();
+
+  AppBase* app_base_;
+  uint32_t max_idle_frames_;
+  uint64_t frame_index_;
+
+  EntryMap<wgpu::BindGroupLayout> layouts_;
+  EntryMap<wgpu::Sampler> samplers_;
+  EntryMap<wgpu::TextureView> views_;
+  EntryMap<wgpu::BindGroup> bind_groups_;
+
+  // View handle -> texture handle, for views created by texture_view()
+  std::unordered_map<const void*, const void*> view_textures_;
+
+  BindingCacheStats stats_;
+
+  std::shared_ptr<DestroyedQueue> destroyed_;
+  uint32_t destroyed_listener_id_;
+};
+
+}  // namespace iggpu
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef IGGPU_DRAW_BATCHER_H
+#define IGGPU_DRAW_BATCHER_H
+
+#include <iggpu/app_base.h>
+#include <iggpu/upload_ring.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace iggpu {
+
+// WebGPU's default maxBindGroups
+const uint32_t kMaxDrawBindGroups = 4u;
+
+struct BatchMesh {
+  // Bound at DrawBatcherDesc::vertex_slot if set (meshes may also generate
+  //  their vertices in the shader)
+  wgpu::Buffer vertex_buffer;
+  uint64_t vertex_offset = 0u;
+
+  // Drawn with DrawIndexed if set
+  wgpu::Buffer index_buffer;
+  wgpu::IndexFormat index_format = wgpu::IndexFormat::Uint16;
+  uint64_t index_offset = 0u;
+
+  // Index count for indexed meshes, vertex count otherwise
+  uint32_t element_count = 0u;
+  uint32_t first_element = 0u;
+  int32_t base_vertex = 0;
+};
+
+struct DrawItem {
+  // From DrawBatcher::add_mesh
+  uint32_t mesh = 0u;
+
+  wgpu::RenderPipeline pipeline;
+
+  // Bind groups for groups 0..3 (null slots are left unset). Bind groups with
+  //  dynamic offsets are not supported.
+  std::array<wgpu::BindGroup, kMaxDrawBindGroups> bind_groups;
+
+  // Per-instance data, copied by add() and read by the pipeline as a vertex
+  //  buffer with step mode Instance at DrawBatcherDesc::instance_slot. Size
+  //  must be a multiple of 4, and the same for every item with a pipeline.
+  const void* instance_data = nullptr;
+  uint32_t instance_size = 0u;
+};
+
+struct DrawBatcherDesc {
+  uint32_t vertex_slot = 0u;
+  uint32_t instance_slot = 1u;
+
+  // Write the arguments of every batch into one indirect buffer, and draw
+  //  with Draw(Indexed)Indirect - leaves the instance counts on the GPU,
+  //  where a compute pass can change them
+  bool indirect = false;
+};
+
+// Counts for the last prepared frame
+struct DrawBatcherStats {
+  uint32_t items;
+
+  // Draw calls recorded, one per batch of items with the same state
+  uint32_t batches;
+
+  uint32_t pipeline_changes;
+  uint32_t bind_group_changes;
+  uint32_t mesh_changes;
+
+  uint64_t instance_bytes;
+  uint64_t indirect_bytes;
+};
+
+// Turns a frame's worth of draw items into as few draw calls and state
+//  changes as possible, instead of setting state and drawing per object.
+//
+// Items are sorted by a packed 64-bit state key (pipeline, then bind groups,
+//  then mesh), so that pipelines and bind groups are set once per run of
+//  items using them. Consecutive items with identical state are merged into
+//  one instanced draw, with their instance data packed into a shared
+//  instance buffer that is uploaded once per frame. Order is preserved
+//  between items with the same state, but not otherwise - items that must
+//  be drawn in order (e.g. blended) belong in their own batcher or pass.
+//
+// Per frame:
+//   batcher.add(item);  // for each object
+//   ...
+//   batcher.prepare();  // before submitting, e.g. with the pass
+//   batcher.record(pass);
+//   ...
+//   batcher.clear();
+class DrawBatcher {
+ public:
+  explicit DrawBatcher(AppBase* app_base, DrawBatcherDesc desc = {});
+  ~DrawBatcher();
+  DrawBatcher(const DrawBatcher&) = delete;
+  DrawBatcher& operator=(const DrawBatcher&) = delete;
+
+  // Meshes live as long as the batcher, referenced by the returned id
+  uint32_t add_mesh(const BatchMesh& mesh);
+
+  // Returns false (and logs) if the item is invalid
+  bool add(const DrawItem& item);
+
+  // Sorts and merges this frame's items, and uploads instance data (and
+  //  indirect arguments) with Queue.WriteBuffer or through upload_ring
+  //  (whose record_copies must then run before the pass)
+  void prepare(UploadRing* upload_ring = nullptr);
+
+  // Records the draws prepared by prepare()
+  void record(wgpu::RenderPassEncoder& pass) const;
+  void record(wgpu::RenderBundleEncoder& bundle) const;
+
+  // Drops this frame's items - call after recording
+  void clear();
+
+  // Buffer holding the indirect arguments of each batch, in record() order:
+  //  20 bytes per indexed batch (indexCount, instanceCount, firstIndex,
+  //  baseVertex, firstInstance), 16 per non-indexed one. Null without
+  //  DrawBatcherDesc::indirect.
+  wgpu::Buffer indirect_buffer() const { return indirect_buffer_; }
+
+  DrawBatcherStats stats() const { return stats_; }
+
+ private:
+  struct Item {
+    // Pipeline (16 bits), bind groups (24 bits), mesh (24 bits)
+    uint64_t key;
+    uint32_t instance_offset;
+  };
+
+  struct PipelineState {
+    wgpu::RenderPipeline pipeline;
+    uint32_t instance_size;
+  };
+
+  struct Batch {
+    uint32_t pipeline;
+    uint32_t bindings;
+    uint32_t mesh;
+    uint32_t instance_count;
+    uint64_t instance_offset;
+    uint64_t indirect_offset;
+  };
+
+  struct BindingsHash {
+    size_t operator()(
+        const std::array<const void*, kMaxDrawBindGroups>& h) const;
+  };
+
+  template <typename Encoder>
+  void record_batches(Encoder& encoder) const;
+
+  bool ensure_buffer(wgpu::Buffer& buffer, uint64_t& capacity, uint64_t size,
+                     wgpu::BufferUsage usage);
+  void write(wgpu::Buffer& buffer, const void* data, uint64_t size,
+             UploadRing* upload_ring);
+
+  AppBase* app_base_;
+  DrawBatcherDesc desc_;
+
+  std::vector<BatchMesh> meshes_;
+
+  // State used this frame, interned to the ids packed into item keys
+  std::vector<PipelineState> pipelines_;
+  std::unordered_map<const void*, uint32_t> pipeline_ids_;
+  std::vector<std::array<wgpu::BindGroup, kMaxDrawBindGroups>> bindings_;
+  std::unordered_map<std::array<const void*, kMaxDrawBindGroups>, uint32_t,
+                     BindingsHash>
+      binding_ids_;
+
+  // Consecutive items usually share state - skips the lookups
+  const void* last_pipeline_;
+  uint32_t last_pipeline_id_;
+  std::array<const void*, kMaxDrawBindGroups> last_bindings_;
+  uint32_t last_bindings_id_;
+
+  std::vector<Item> items_;
+  std::vector<uint8_t> item_data_;
+
+  std::vector<Batch> batches_;
+  std::vector<uint8_t> instance_data_;
+  std::vector<uint32_t> indirect_args_;
+
+  wgpu::Buffer instance_buffer_;
+  uint64_t instance_capacity_;
+  wgpu::Buffer indirect_buffer_;
+  uint64_t indirect_capacity_;
+
+  DrawBatcherStats stats_;
+};
+
+}  // namespace iggpu
+
+#endif
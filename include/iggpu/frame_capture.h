@@ -0,0 +1,129 @@
+#ifndef IGGPU_FRAME_CAPTURE_H
+#define IGGPU_FRAME_CAPTURE_H
+
+#include <iggpu/app_base.h>
+#include <iggpu/readback_manager.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <variant>
+
+namespace iggpu {
+
+enum class FrameCaptureFormat {
+  // Packed 8-bit RGBA, frames back to back (no header)
+  RawRGBA,
+  // Binary PPM (P6) per frame - readable as a stream by e.g. ffmpeg's
+  //  image2pipe demuxer
+  PPM,
+  // YUV4MPEG2 with 4:2:0 BT.601 chroma - readable by most video tools
+  Y4M,
+};
+
+enum class FrameCaptureError {
+  // Frames can only be read back from BGRA8Unorm or RGBA8Unorm targets
+  UnsupportedTargetFormat,
+  OutputOpenFailed,
+};
+
+struct FrameCaptureDesc {
+  // File (or named pipe) to write to, "-" for stdout. Move the log fn off
+  //  stdout first (see set_log_fn) - Info messages go there by default.
+  std::string path;
+  FrameCaptureFormat format = FrameCaptureFormat::Y4M;
+
+  // Frame rate written into the Y4M header
+  uint32_t fps = 30u;
+
+  // Frames being copied back from the GPU at once
+  uint32_t readback_ring_size = 3u;
+
+  // Frames read back but not yet written - bounds memory when the output is
+  //  slower than rendering. capture() blocks while the queue is full.
+  uint32_t max_queued_frames = 8u;
+};
+
+struct FrameCaptureStats {
+  uint64_t frames_captured;
+  uint64_t frames_written;
+  uint64_t bytes_written;
+  uint64_t write_errors;
+
+  // Times capture() had to wait for a readback buffer or for queue space
+  uint64_t stall_count;
+
+  // Frames written per second, since the first frame was captured
+  double write_fps;
+};
+
+// Streams every presented frame to a file or pipe, for offline rendering of
+//  previews and thumbnails (typically with a headless AppBase, which also
+//  works on machines with only a CPU adapter).
+//
+// Frames are copied into a ring of readback buffers, so the GPU keeps
+//  rendering while earlier frames are mapped. Conversion from the target
+//  format and writing happen on a worker thread (inline on web).
+//
+// Per frame, after submitting the frame's work and before presenting:
+//   capture->capture();
+//   app_base->present();
+//
+// Windowed apps need a surface configured with CopySrc usage - offscreen
+//  targets of headless apps always have it.
+class FrameCapture {
+ public:
+  using CreateRsl =
+      std::variant<std::unique_ptr<FrameCapture>, FrameCaptureError>;
+  static CreateRsl Create(AppBase* app_base, FrameCaptureDesc desc);
+
+  // Writes out every frame still in flight, then closes the output
+  ~FrameCapture();
+  FrameCapture(const FrameCapture&) = delete;
+  FrameCapture& operator=(const FrameCapture&) = delete;
+
+  // Captures the current texture (AppBase::get_current_texture). Records and
+  //  submits a copy after everything already submitted this frame.
+  void capture();
+
+  // Blocks until every captured frame has been written
+  void flush();
+
+  FrameCaptureStats stats() const;
+
+ private:
+  struct Queue;
+
+  FrameCapture(AppBase* app_base, FrameCaptureDesc desc, std::FILE* out,
+               bool swap_red_blue);
+
+  void on_frame_read(ReadbackResult result);
+
+  AppBase* app_base_;
+  FrameCaptureDesc desc_;
+  ReadbackManager readback_;
+
+  uint64_t frames_captured_;
+  uint64_t stall_count_;
+  std::chrono::steady_clock::time_point start_;
+
+  // Shared with the writer thread
+  std::unique_ptr<Queue> queue_;
+};
+
+inline constexpr const char* frame_capture_error_text(FrameCaptureError err) {
+  switch (err) {
+    case FrameCaptureError::UnsupportedTargetFormat:
+      return "UnsupportedTargetFormat";
+    case FrameCaptureError::OutputOpenFailed:
+      return "OutputOpenFailed";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+}  // namespace iggpu
+
+#endif
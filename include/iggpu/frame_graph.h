@@ -0,0 +1,149 @@
+#ifndef IGGPU_FRAME_GRAPH_H
+#define IGGPU_FRAME_GRAPH_H
+
+#include <iggpu/render_target_pool.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace iggpu {
+
+struct FrameGraphStats {
+  uint32_t pass_count;
+  uint32_t culled_pass_count;
+
+  // Transient textures declared by passes that were not culled, and the
+  //  number of pooled textures actually backing them after aliasing
+  uint32_t transient_texture_count;
+  uint32_t physical_texture_count;
+};
+
+// Per-frame graph of passes that declare which textures they read and write.
+//
+// compile() culls passes whose outputs nobody reads, and assigns transient
+//  textures with non-overlapping lifetimes (and identical descriptions) to
+//  the same pooled texture. execute() then records every remaining pass into
+//  one command encoder.
+//
+// Passes run in the order they were added - always a valid order, since a
+//  pass can only use resource handles created or imported before it. A pass
+//  is kept if it writes an imported texture (e.g. the backbuffer), is marked
+//  with side_effect(), or writes something a kept pass reads.
+//
+// Per frame:
+//   auto backbuffer = graph.import_texture("backbuffer", texture, view);
+//   graph.add_pass("main",
+//       [&](FrameGraph::PassBuilder& b) {
+//         depth = b.create("depth", depth_desc);
+//         b.write(backbuffer);
+//       },
+//       [&](wgpu::CommandEncoder& encoder, const FrameGraph::Resources& r) {
+//         ... encoder.BeginRenderPass with r.view(depth) ...
+//       });
+//   graph.compile();
+//   graph.execute(encoder);
+//   queue.Submit(...);
+//   pool.end_frame();
+//   graph.reset();
+class FrameGraph {
+ public:
+  using ResourceHandle = uint32_t;
+  static constexpr ResourceHandle kInvalidResource =
+      std::numeric_limits<ResourceHandle>::max();
+
+  class PassBuilder {
+   public:
+    // Declares a transient texture written by this pass. Sizes of 0 are
+    //  surface-sized (see RenderTargetDesc).
+    ResourceHandle create(std::string name, const RenderTargetDesc& desc);
+    ResourceHandle read(ResourceHandle resource);
+    ResourceHandle write(ResourceHandle resource);
+
+    // Never cull this pass (e.g. it writes buffers the graph does not track)
+    void side_effect();
+
+   private:
+    friend class FrameGraph;
+    PassBuilder(FrameGraph* graph, uint32_t pass_idx)
+        : graph_(graph), pass_idx_(pass_idx) {}
+
+    FrameGraph* graph_;
+    uint32_t pass_idx_;
+  };
+
+  class Resources {
+   public:
+    wgpu::Texture texture(ResourceHandle resource) const;
+    wgpu::TextureView view(ResourceHandle resource) const;
+
+   private:
+    friend class FrameGraph;
+    explicit Resources(const FrameGraph* graph) : graph_(graph) {}
+
+    const FrameGraph* graph_;
+  };
+
+  using SetupFn = std::function<void(PassBuilder&)>;
+  using ExecuteFn =
+      std::function<void(wgpu::CommandEncoder&, const Resources&)>;
+
+  explicit FrameGraph(RenderTargetPool* render_target_pool);
+  FrameGraph(const FrameGraph&) = delete;
+  FrameGraph& operator=(const FrameGraph&) = delete;
+
+  // Textures owned outside of the graph. Writing one keeps the pass alive.
+  ResourceHandle import_texture(std::string name, wgpu::Texture texture,
+                                wgpu::TextureView view);
+
+  void add_pass(std::string name, const SetupFn& setup, ExecuteFn execute);
+
+  // Culls passes and allocates transient textures. Returns false if a
+  //  transient texture could not be created.
+  bool compile();
+
+  // Records all passes that survived compile() into the encoder
+  void execute(wgpu::CommandEncoder& encoder);
+
+  // Clears all passes and resources, ready for the next frame
+  void reset();
+
+  FrameGraphStats stats() const { return stats_; }
+  bool is_culled(const std::string& pass_name) const;
+
+ private:
+  struct Resource {
+    std::string name;
+    bool imported;
+    RenderTargetDesc desc;
+    RenderTarget target;
+
+    std::vector<uint32_t> writers;
+    uint32_t reader_count;
+  };
+
+  struct Pass {
+    std::string name;
+    ExecuteFn execute;
+    std::vector<ResourceHandle> reads;
+    std::vector<ResourceHandle> writes;
+    bool side_effect;
+    bool culled;
+  };
+
+  void cull_passes();
+  bool allocate_transients();
+
+  RenderTargetPool* render_target_pool_;
+
+  std::vector<Resource> resources_;
+  std::vector<Pass> passes_;
+  FrameGraphStats stats_;
+};
+
+}  // namespace iggpu
+
+#endif
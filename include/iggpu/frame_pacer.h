@@ -0,0 +1,69 @@
+#ifndef IGGPU_FRAME_PACER_H
+#define IGGPU_FRAME_PACER_H
+
+#include <iggpu/rolling_stats.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace iggpu {
+
+// Bounds how many frames the CPU may queue up ahead of the GPU, and measures
+//  frame latency - the time from a frame beginning (where input is sampled)
+//  to the GPU finishing that frame's work.
+//
+// Owned by AppBase, which drives it from AppBase::begin_frame and
+//  AppBase::present - apps only need to configure it.
+class FramePacer {
+ public:
+  explicit FramePacer(uint32_t sample_count = 240u);
+
+  // 0 disables the limit
+  void set_max_frames_in_flight(uint32_t max_frames_in_flight);
+  uint32_t max_frames_in_flight() const { return max_frames_in_flight_; }
+
+  // In low latency mode a frame only begins once every previous frame has
+  //  finished on the GPU, so input is sampled as late as possible. Trades
+  //  away CPU/GPU overlap (i.e. throughput) for latency.
+  void set_low_latency_mode(bool enabled);
+  bool low_latency_mode() const { return low_latency_mode_; }
+
+  uint32_t frames_in_flight() const;
+  bool can_begin_frame() const;
+
+  // wait_ms is the time spent waiting for can_begin_frame
+  void begin_frame(double wait_ms);
+
+  // Ends the frame started by begin_frame, returning the callback to invoke
+  //  once the frame's submitted work is done on the GPU. Returns nullptr if
+  //  no frame was started.
+  std::function<void()> end_frame();
+
+  const RollingStats& latency_stats() const { return shared_->latency_ms; }
+  const RollingStats& wait_stats() const { return wait_ms_; }
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  // Shared with pending GPU callbacks, which may outlive the pacer
+  struct SharedState {
+    explicit SharedState(uint32_t sample_count);
+
+    uint64_t frames_completed;
+    RollingStats latency_ms;
+  };
+
+  std::shared_ptr<SharedState> shared_;
+  uint32_t max_frames_in_flight_;
+  bool low_latency_mode_;
+  uint64_t frames_submitted_;
+  bool frame_open_;
+  clock::time_point frame_begin_;
+  RollingStats wait_ms_;
+};
+
+}  // namespace iggpu
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef IGGPU_FRAME_TIMER_H
+#define IGGPU_FRAME_TIMER_H
+
+#include <iggpu/app_base.h>
+#include <iggpu/rolling_stats.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace iggpu {
+
+// Per-frame CPU and GPU timing, with rolling percentiles per named pass.
+//
+// GPU pass times come from timestamp queries if the device supports them.
+//  Otherwise only a whole-frame GPU time is recorded, measured on the CPU as
+//  the time between Queue.Submit and the submitted work completing.
+//
+// Usage (once per frame):
+//   timer.begin_frame();
+//   rpd.timestampWrites = timer.render_pass_timestamps("main");
+//   ... encode passes ...
+//   timer.end_encode(encoder);
+//   timer.submit(encoder.Finish());
+//   timer.present();
+class FrameTimer {
+ public:
+  static constexpr uint32_t kMaxPassesPerFrame = 16u;
+
+  explicit FrameTimer(AppBase* app_base, uint32_t sample_count = 240u);
+  ~FrameTimer();
+  FrameTimer(const FrameTimer&) = delete;
+  FrameTimer& operator=(const FrameTimer&) = delete;
+
+  void begin_frame();
+
+  // Timestamp writes to attach to a pass descriptor. Returns nullptr if GPU
+  //  timestamps are unavailable (unsupported, too many passes in the frame,
+  //  or all readback buffers still in flight).
+  const wgpu::RenderPassTimestampWrites* render_pass_timestamps(
+      const std::string& pass_name);
+  const wgpu::ComputePassTimestampWrites* compute_pass_timestamps(
+      const std::string& pass_name);
+
+  // Records query resolution into the frame encoder - call after the last
+  //  pass and before Finish(). Ends the CPU encode timer.
+  void end_encode(wgpu::CommandEncoder& encoder);
+
+  // Submits the command buffer to the queue, timing the submission
+  void submit(wgpu::CommandBuffer commands);
+
+  // Presents the frame via AppBase::present, timing the call. Ends the frame.
+  void present();
+
+  bool has_gpu_timestamps() const { return static_cast<bool>(query_set_); }
+
+  // Frames whose GPU timestamps were not recorded because every readback
+  //  buffer was still in flight - those frames are missing from the GPU
+  //  pass stats
+  uint64_t skipped_gpu_samples() const { return skipped_gpu_samples_; }
+
+  Percentiles cpu_frame_stats() const { return cpu_frame_.percentiles(); }
+  Percentiles cpu_encode_stats() const { return cpu_encode_.percentiles(); }
+  Percentiles cpu_submit_stats() const { return cpu_submit_.percentiles(); }
+  Percentiles cpu_present_stats() const { return cpu_present_.percentiles(); }
+  Percentiles gpu_frame_stats() const { return gpu_frame_.percentiles(); }
+  Percentiles gpu_pass_stats(const std::string& pass_name) const;
+  std::vector<std::string> pass_names() const;
+
+  // Multi-line human readable summary of all timings (in milliseconds)
+  std::string summary() const;
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  struct ReadbackSlot {
+    wgpu::Buffer resolve_buffer;
+    wgpu::Buffer readback_buffer;
+    std::vector<std::string> pass_names;
+    bool in_flight;
+  };
+
+  int32_t alloc_pass_queries(const std::string& pass_name);
+  void on_readback_mapped(uint32_t slot_idx);
+
+  AppBase* app_base_;
+  uint32_t sample_count_;
+
+  wgpu::QuerySet query_set_;
+  std::vector<ReadbackSlot> readback_slots_;
+  int32_t current_slot_;
+  uint64_t skipped_gpu_samples_;
+
+  wgpu::RenderPassTimestampWrites render_pass_writes_;
+  wgpu::ComputePassTimestampWrites compute_pass_writes_;
+
+  clock::time_point frame_start_;
+  clock::time_point encode_end_;
+
+  RollingStats cpu_frame_;
+  RollingStats cpu_encode_;
+  RollingStats cpu_submit_;
+  RollingStats cpu_present_;
+  RollingStats gpu_frame_;
+  std::map<std::string, RollingStats> gpu_passes_;
+
+  // GPU callbacks may outlive the timer - they hold a weak reference to this
+  //  token and do nothing once it has expired.
+  std::shared_ptr<bool> alive_token_;
+};
+
+}  // namespace iggpu
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef IGGPU_GPU_CULLER_H
+#define IGGPU_GPU_CULLER_H
+
+#include <iggpu/app_base.h>
+#include <iggpu/binding_cache.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace iggpu {
+
+// Matches the culling shader's Object struct. Vertex shaders drawing culled
+//  instances can read the transform from GpuCuller::objects_buffer().
+struct GpuCullObject {
+  // Column-major object to world transform
+  float transform[16];
+
+  // Bounding sphere in object space - center (xyz) and radius (w)
+  float bounds[4];
+
+  // Draw (from GpuCuller::add_draw) that the object is an instance of
+  uint32_t draw;
+  uint32_t pad[3];
+};
+static_assert(sizeof(GpuCullObject) == 96u);
+
+struct GpuCullerDesc {
+  // Capacity of the objects buffer
+  uint32_t max_objects = 64u * 1024u;
+
+  // Also cull objects hidden behind the previous frame's depth buffer (see
+  //  GpuCuller::build_hiz)
+  bool hiz = false;
+};
+
+struct GpuCullerStats {
+  uint32_t object_count;
+  uint32_t draw_count;
+
+  // Sum of the draws' max_instances
+  uint32_t visible_capacity;
+
+  uint64_t cull_passes;
+  uint64_t hiz_builds;
+};
+
+// GPU-driven culling: objects are culled in a compute pass and the survivors
+//  are drawn with DrawIndexedIndirect, so the CPU cost of a frame doesn't
+//  depend on the number of objects.
+//
+// Every object (a transform, bounding sphere and draw index) lives in a
+//  storage buffer. cull() tests each object's sphere against the frustum,
+//  and optionally against a depth pyramid (Hi-Z) built from the previous
+//  frame's depth buffer. Survivors are compacted with atomics - each one
+//  bumps its draw's instanceCount in the indirect buffer and writes its
+//  object index into the draw's region of the visible buffer. draw() binds
+//  that region as an instance-rate vertex buffer (one uint32 object index
+//  per instance), so instance_index needs no firstInstance offset.
+//
+// Hi-Z tests against the previous frame's depth, so objects uncovered by
+//  camera motion can appear a frame late. Depth convention: 0 near, 1 far,
+//  with a Less depth test.
+//
+// Per frame:
+//   culler.cull(encoder, view_proj);
+//   ... render pass: pipeline, index buffer, then culler.draw(pass, d, 1)
+//   culler.build_hiz(encoder, depth_view, w, h, view_proj);  // if hiz
+class GpuCuller {
+ public:
+  GpuCuller(AppBase* app_base, GpuCullerDesc desc = {});
+  ~GpuCuller();
+  GpuCuller(const GpuCuller&) = delete;
+  GpuCuller& operator=(const GpuCuller&) = delete;
+
+  // Returns the draw's index. Objects beyond max_instances in a frame are
+  //  culled.
+  uint32_t add_draw(uint32_t index_count, uint32_t max_instances,
+                    uint32_t first_index = 0u, int32_t base_vertex = 0);
+
+  // Writes objects at index first, and grows the object count to cover them
+  bool set_objects(std::span<const GpuCullObject> objects,
+                   uint32_t first = 0u);
+
+  // For objects written to objects_buffer() directly (e.g. by a compute pass)
+  void set_object_count(uint32_t object_count);
+
+  // Records the culling pass. Call before the render pass that draws.
+  void cull(wgpu::CommandEncoder& encoder, const glm::mat4& view_proj);
+
+  // Records the indirect draw of one draw's visible instances. The pass
+  //  must have a pipeline with a Uint32 instance-rate attribute at
+  //  instance_slot, and the draw's index buffer set.
+  void draw(wgpu::RenderPassEncoder& pass, uint32_t draw,
+            uint32_t instance_slot) const;
+
+  // Builds the depth pyramid used by the next cull() from this frame's depth
+  //  buffer (sampleable, with TextureBinding usage). view_proj must be the
+  //  one the depth buffer was rendered with. Call after the render pass.
+  void build_hiz(wgpu::CommandEncoder& encoder,
+                 const wgpu::TextureView& depth_view, uint32_t width,
+                 uint32_t height, const glm::mat4& view_proj);
+
+  // Forgets the depth pyramid (e.g. after a camera cut), until the next
+  //  build_hiz
+  void invalidate_hiz() { hiz_valid_ = false; }
+
+  // GpuCullObject array - Storage | CopyDst
+  wgpu::Buffer objects_buffer() const { return objects_buffer_; }
+
+  // DrawIndexedIndirect arguments, 20 bytes per draw - CopySrc, so that
+  //  instance counts can be read back
+  wgpu::Buffer indirect_buffer() const { return args_buffer_; }
+  static uint64_t instance_count_offset(uint32_t draw) {
+    return draw * kArgsSize + sizeof(uint32_t);
+  }
+
+  GpuCullerStats stats() const { return stats_; }
+
+ private:
+  static constexpr uint64_t kArgsSize = 5u * sizeof(uint32_t);
+
+  struct Draw {
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t base_vertex;
+    uint32_t offset;
+    uint32_t capacity;
+  };
+
+  bool create_draw_buffers();
+  bool create_hiz(uint32_t width, uint32_t height);
+  void create_cull_bind_group();
+
+  AppBase* app_base_;
+  GpuCullerDesc desc_;
+
+  wgpu::ComputePipeline cull_pipeline_;
+  wgpu::ComputePipeline hiz_copy_pipeline_;
+  wgpu::ComputePipeline hiz_downsample_pipeline_;
+
+  wgpu::Buffer params_buffer_;
+  wgpu::Buffer objects_buffer_;
+  uint32_t object_count_;
+
+  std::vector<Draw> draws_;
+  bool draws_dirty_;
+  wgpu::Buffer args_buffer_;
+  wgpu::Buffer args_reset_buffer_;
+  wgpu::Buffer regions_buffer_;
+  wgpu::Buffer visible_buffer_;
+  wgpu::BindGroup cull_bind_group_;
+
+  // Depth pyramid - R32Float, farthest depth of each texel's footprint
+  wgpu::Texture hiz_texture_;
+  uint32_t hiz_width_;
+  uint32_t hiz_height_;
+  uint32_t hiz_mip_count_;
+  std::vector<wgpu::BindGroup> hiz_downsample_bind_groups_;
+  wgpu::BindGroupLayout hiz_copy_layout_;
+  wgpu::TextureView hiz_copy_target_;
+
+  // Copy bind groups, per depth view
+  BindingCache hiz_bind_groups_;
+  glm::mat4 hiz_view_proj_;
+  bool hiz_valid_;
+
+  GpuCullerStats stats_;
+};
+
+}  // namespace iggpu
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef IGGPU_GPU_ERRORS_H
+#define IGGPU_GPU_ERRORS_H
+
+#include <iggpu/log.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+namespace iggpu {
+
+struct AppBase;
+
+// Totals since startup (or the last reset_gpu_error_counts)
+struct GpuErrorCounts {
+  uint64_t validation = 0u;
+  uint64_t out_of_memory = 0u;
+  uint64_t device_lost = 0u;
+  uint64_t internal = 0u;
+  uint64_t unknown = 0u;
+
+  // Errors and Dawn log messages that were counted but not logged, because
+  //  an identical message was logged before
+  uint64_t suppressed = 0u;
+
+  uint64_t total() const {
+    return validation + out_of_memory + device_lost + internal + unknown;
+  }
+};
+
+// GPU errors tend to arrive in storms - one bad binding fails validation on
+//  every draw that uses it, every frame. Reported errors are fingerprinted
+//  (message text with numbers stripped, so errors that differ only in sizes,
+//  offsets or indices match), and only the first occurrence of each is logged
+//  right away. Repeats are counted, and logged as a single summary line per
+//  fingerprint once per report interval.
+//
+// AppBase routes uncaptured errors, device loss and Dawn error/warning log
+//  messages through here, and flushes due summaries in begin_frame.
+void report_gpu_error(wgpu::ErrorType type, std::string_view message,
+                      const char* scope_label = nullptr);
+void report_gpu_log_message(LogLevel log_level, std::string_view message);
+
+// Logs summaries for repeated errors if the report interval has passed (or
+//  always, if force is set). Cheap when nothing has repeated.
+void flush_gpu_error_reports(bool force = false);
+
+// Default 5s. 0 disables deduplication - every error is logged.
+void set_gpu_error_report_interval(double interval_s);
+
+GpuErrorCounts gpu_error_counts();
+
+// Also forgets fingerprints, so the next occurrence of each error is logged
+void reset_gpu_error_counts();
+
+namespace detail {
+inline std::atomic<bool> gGpuErrorScopesEnabled{false};
+}  // namespace detail
+
+// Off by default - GpuErrorScope does nothing until enabled
+inline void set_gpu_error_scopes_enabled(bool enabled) {
+  detail::gGpuErrorScopesEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+inline bool gpu_error_scopes_enabled() {
+  return detail::gGpuErrorScopesEnabled.load(std::memory_order_relaxed);
+}
+
+// Pushes a device error scope for its lifetime, so errors raised in a suspect
+//  region are reported with the region's label instead of as uncaptured
+//  errors. When scopes are disabled, costs one relaxed load.
+//
+// label must outlive the scope's callback (use a string literal). Errors are
+//  reported once the GPU resolves the scope (native: from process_events).
+class GpuErrorScope {
+ public:
+  GpuErrorScope(AppBase* app_base, const char* label,
+                wgpu::ErrorFilter filter = wgpu::ErrorFilter::Validation);
+  ~GpuErrorScope();
+
+  GpuErrorScope(const GpuErrorScope&) = delete;
+  GpuErrorScope& operator=(const GpuErrorScope&) = delete;
+
+ private:
+  AppBase* app_base_;
+  const char* label_;
+};
+
+}  // namespace iggpu
+
+#endif
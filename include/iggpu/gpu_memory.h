@@ -0,0 +1,108 @@
+#ifndef IGGPU_GPU_MEMORY_H
+#define IGGPU_GPU_MEMORY_H
+
+#include <webgpu/webgpu_cpp.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace iggpu {
+
+struct GpuMemoryTagStats {
+  std::string tag;
+  uint64_t live_bytes;
+  uint64_t peak_bytes;
+  uint64_t live_count;
+};
+
+struct GpuMemoryStats {
+  uint64_t live_bytes;
+  uint64_t buffer_bytes;
+  uint64_t texture_bytes;
+  uint64_t live_count;
+
+  // Highest live_bytes since startup (or reset_gpu_memory_peak)
+  uint64_t peak_bytes;
+
+  // 0 if no budget is set
+  uint64_t budget_bytes;
+
+  // Times the eviction callback was asked to free memory, and allocations
+  //  refused because eviction did not free enough
+  uint64_t eviction_requests;
+  uint64_t rejected_allocations;
+
+  // Sorted by live_bytes, largest first
+  std::vector<GpuMemoryTagStats> tags;
+};
+
+// GPU memory accounting - resources created through these wrappers are
+//  recorded (size, usage, format and a tag naming the owning subsystem) until
+//  they are destroyed with destroy_buffer/destroy_texture, which maintain live
+//  totals per tag and a peak watermark. Recording costs a lock and a hash map
+//  insert, small next to resource creation itself, so it stays on in release
+//  builds.
+//
+// Texture sizes are estimates (mip chain x layers x samples, at the format's
+//  texel or block size) - drivers add alignment and metadata on top.
+//
+// tag must outlive the resource (use a string literal). A resource dropped
+//  without destroy_* or release_* stays counted.
+//
+// If a budget is set, allocations that would exceed it first call the
+//  eviction callback, then fail (returning a null handle) if the budget is
+//  still exceeded.
+wgpu::Buffer create_buffer(const wgpu::Device& device,
+                           const wgpu::BufferDescriptor& desc,
+                           const char* tag);
+wgpu::Texture create_texture(const wgpu::Device& device,
+                             const wgpu::TextureDescriptor& desc,
+                             const char* tag);
+
+// Destroys the resource (if non-null), stops counting it, and resets the
+//  handle. Untracked resources are destroyed all the same. Destroy takes
+//  effect immediately - command buffers still to be submitted that use the
+//  resource fail validation.
+void destroy_buffer(wgpu::Buffer& buffer);
+void destroy_texture(wgpu::Texture& texture);
+
+// Stops counting the resource and resets the handle without destroying it,
+//  for resources that recorded (not yet submitted) work or other holders
+//  may still use. The memory is freed when the last reference goes away.
+void release_buffer(wgpu::Buffer& buffer);
+void release_texture(wgpu::Texture& texture);
+
+uint64_t estimate_texture_size(const wgpu::TextureDescriptor& desc);
+
+// Called from destroy_*/release_* (on the calling thread) with the handle -
+//  used by caches holding objects that reference it.
+//  Listeners must not add or remove listeners.
+using GpuResourceDestroyedFn = std::function<void(const void* handle)>;
+uint32_t add_gpu_resource_destroyed_listener(GpuResourceDestroyedFn cb);
+void remove_gpu_resource_destroyed_listener(uint32_t listener_id);
+
+// Called (on the allocating thread, without locks held) with the number of
+//  bytes that must be freed for an allocation to fit. Free memory by calling
+//  destroy_buffer/destroy_texture on idle resources.
+using GpuMemoryEvictFn = std::function<void(uint64_t bytes_needed)>;
+
+// 0 (the default) disables the budget
+void set_gpu_memory_budget(uint64_t budget_bytes,
+                           GpuMemoryEvictFn evict = nullptr);
+
+GpuMemoryStats gpu_memory_stats();
+void reset_gpu_memory_peak();
+
+// Totals, per tag usage and the largest live allocations, for logging
+std::string gpu_memory_report(uint32_t max_allocations = 8u);
+
+// Logs gpu_memory_report() as an error - at most once every few seconds, as
+//  OOM errors tend to repeat. AppBase calls this on uncaptured OutOfMemory
+//  errors.
+void report_gpu_out_of_memory();
+
+}  // namespace iggpu
+
+#endif
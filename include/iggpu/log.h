@@ -1,20 +1,111 @@
 #ifndef IGGPU_LOG_H
 #define IGGPU_LOG_H
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <string>
+#include <string_view>
+
+// Least severe level compiled into the binary (0=Error, 1=Warning, 2=Info,
+//  3=Verbose) - IGGPU_LOG calls below it compile to nothing, arguments
+//  included. Defaults to Info in release (NDEBUG) builds, Verbose otherwise.
+#ifndef IGGPU_LOG_COMPILED_LEVEL
+#ifdef NDEBUG
+#define IGGPU_LOG_COMPILED_LEVEL 2
+#else
+#define IGGPU_LOG_COMPILED_LEVEL 3
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define IGGPU_PRINTF_FORMAT(fmt_idx, args_idx) \
+  __attribute__((format(printf, fmt_idx, args_idx)))
+#else
+#define IGGPU_PRINTF_FORMAT(fmt_idx, args_idx)
+#endif
 
 namespace iggpu {
 
+// Ordered from most to least severe
 enum class LogLevel {
   Error,
   Warning,
   Info,
+  Verbose,
 };
 
+namespace detail {
+inline std::atomic<LogLevel> gRuntimeLogLevel{LogLevel::Info};
+}  // namespace detail
+
+constexpr bool log_level_compiled_in(LogLevel log_level) {
+  return static_cast<int>(log_level) <= IGGPU_LOG_COMPILED_LEVEL;
+}
+
+// Messages less severe than this are discarded before formatting (default:
+//  Info, i.e. Verbose messages are off)
+inline void set_log_level(LogLevel log_level) {
+  detail::gRuntimeLogLevel.store(log_level, std::memory_order_relaxed);
+}
+
+inline bool log_enabled(LogLevel log_level) {
+  return log_level_compiled_in(log_level) &&
+         static_cast<int>(log_level) <=
+             static_cast<int>(
+                 detail::gRuntimeLogLevel.load(std::memory_order_relaxed));
+}
+
+// The log fn is the sink every message ends up in - by default, stdout/stderr
+//  (if IGGPU_ENABLE_DEFAULT_LOGGING is set). Safe to call at any time, also
+//  while async logging is enabled.
 void set_log_fn(std::function<void(LogLevel, const std::string&)> log_fn);
-void log(LogLevel log_level, const std::string& msg);
+
+// The message is copied into a per-thread buffer (or a queue slot, when
+//  async), whose capacity is reused - logging doesn't allocate once warm
+void log(LogLevel log_level, std::string_view msg);
+
+// printf-style - prefer the IGGPU_LOG macros, which skip evaluating the
+//  arguments entirely when the level is disabled
+void log_printf(LogLevel log_level, const char* fmt, ...)
+    IGGPU_PRINTF_FORMAT(2, 3);
+
+// Async logging: log() pushes messages into a bounded lock-free queue and
+//  returns immediately, and a background thread passes them to the log fn.
+//  When the queue is full, messages are dropped (and counted) instead of
+//  blocking the caller. Queued messages are flushed at exit and, best effort,
+//  written straight to stderr when the process crashes (SIGSEGV, SIGABRT...)
+//  before any previously installed handler runs.
+//
+// queue_capacity is rounded up to a power of two, and only the first call
+//  sets it. No-op on web, where logging is always synchronous.
+void enable_async_logging(uint32_t queue_capacity = 4096u);
+void disable_async_logging();
+bool async_logging_enabled();
+
+// Blocks until every message logged before this call has reached the log fn
+void flush_log();
+
+// Messages dropped because the async queue was full
+uint64_t dropped_log_count();
 
 }  // namespace iggpu
 
+// Usage: IGGPU_LOG_WARNING("[IGGPU] Buffer too small (%u < %u)", a, b);
+#define IGGPU_LOG(log_level, ...)                              \
+  do {                                                         \
+    if constexpr (::iggpu::log_level_compiled_in(log_level)) { \
+      if (::iggpu::log_enabled(log_level)) {                   \
+        ::iggpu::log_printf(log_level, __VA_ARGS__);           \
+      }                                                        \
+    }                                                          \
+  } while (0)
+
+#define IGGPU_LOG_ERROR(...) IGGPU_LOG(::iggpu::LogLevel::Error, __VA_ARGS__)
+#define IGGPU_LOG_WARNING(...) \
+  IGGPU_LOG(::iggpu::LogLevel::Warning, __VA_ARGS__)
+#define IGGPU_LOG_INFO(...) IGGPU_LOG(::iggpu::LogLevel::Info, __VA_ARGS__)
+#define IGGPU_LOG_VERBOSE(...) \
+  IGGPU_LOG(::iggpu::LogLevel::Verbose, __VA_ARGS__)
+
 #endif
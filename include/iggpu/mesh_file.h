@@ -0,0 +1,218 @@
+#ifndef IGGPU_MESH_FILE_H
+#define IGGPU_MESH_FILE_H
+
+#include <iggpu/app_base.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace iggpu {
+
+// .igmesh container layout (little endian, offsets from the start of the
+//  file):
+//
+//   MeshFileHeader
+//   MeshFileAttribute[attribute_count]   at attributes_offset
+//   MeshFileSubmesh[submesh_count]       at submeshes_offset
+//   vertex blob                          at vertex_data_offset
+//   index blob                           at index_data_offset
+//
+// Blobs start at multiples of kMeshFileAlignment and are zero-padded to a
+//  multiple of 4 bytes, so each one can be copied to a GPU buffer in one go
+//  straight from a mapping of the file.
+inline constexpr uint32_t kMeshFileMagic = 0x48534D49u;  // "IMSH"
+inline constexpr uint32_t kMeshFileVersion = 1u;
+inline constexpr uint64_t kMeshFileAlignment = 256u;
+
+enum class MeshAttributeFormat : uint32_t {
+  Float32,
+  Float32x2,
+  Float32x3,
+  Float32x4,
+  Unorm8x4,
+  Snorm8x4,
+  Uint32,
+};
+
+enum class MeshAttributeSemantic : uint32_t {
+  Position,
+  Normal,
+  Tangent,
+  TexCoord0,
+  TexCoord1,
+  Color,
+  Custom,
+};
+
+enum class MeshIndexFormat : uint32_t {
+  Uint16,
+  Uint32,
+};
+
+struct MeshFileHeader {
+  uint32_t magic;
+  uint32_t version;
+
+  uint32_t vertex_stride;
+  uint32_t vertex_count;
+  uint32_t index_count;
+  MeshIndexFormat index_format;
+  uint32_t attribute_count;
+  uint32_t submesh_count;
+
+  uint64_t attributes_offset;
+  uint64_t submeshes_offset;
+  uint64_t vertex_data_offset;
+  uint64_t vertex_data_size;
+  uint64_t index_data_offset;
+  uint64_t index_data_size;
+
+  // Bounding box of all vertices (zero without a Float32x3 position)
+  float bounds_min[3];
+  float bounds_max[3];
+};
+static_assert(sizeof(MeshFileHeader) == 104u);
+
+struct MeshFileAttribute {
+  MeshAttributeSemantic semantic;
+  MeshAttributeFormat format;
+
+  // Byte offset within a vertex
+  uint32_t offset;
+  uint32_t shader_location;
+};
+static_assert(sizeof(MeshFileAttribute) == 16u);
+
+// A range of the index buffer, e.g. the triangles of one material
+struct MeshFileSubmesh {
+  uint32_t first_index;
+  uint32_t index_count;
+  int32_t base_vertex;
+  uint32_t material;
+
+  // Bounding sphere of the submesh's vertices - center (xyz) and radius (w),
+  //  as used by GpuCullObject::bounds
+  float bounds[4];
+};
+static_assert(sizeof(MeshFileSubmesh) == 32u);
+
+enum class MeshFileError {
+  OpenFailed,
+  ReadFailed,
+  WriteFailed,
+  // Bad magic, or sizes and offsets that don't fit in the file
+  InvalidFile,
+  UnsupportedVersion,
+  BufferCreationFailed,
+};
+
+uint32_t mesh_attribute_size(MeshAttributeFormat format);
+wgpu::VertexFormat to_vertex_format(MeshAttributeFormat format);
+
+// Validated view of an .igmesh file in memory - blobs point into the data
+//  it was parsed from
+struct MeshFileView {
+  MeshFileHeader header;
+  std::vector<MeshFileAttribute> attributes;
+  std::vector<MeshFileSubmesh> submeshes;
+
+  // Padded to a multiple of 4 bytes
+  std::span<const uint8_t> vertex_data;
+  std::span<const uint8_t> index_data;
+};
+
+using MeshFileParseRsl = std::variant<MeshFileView, MeshFileError>;
+MeshFileParseRsl parse_mesh_file(std::span<const uint8_t> data);
+
+// Input of write_mesh_file. Indices are written as Uint16 when every stored
+//  index value fits - base_vertex is added at draw time and doesn't count.
+//  Submesh and file bounds are computed from the Float32x3 Position
+//  attribute, if there is one - the bounds of the given submeshes are ignored.
+struct MeshFileDesc {
+  uint32_t vertex_stride;
+  std::vector<MeshFileAttribute> attributes;
+  std::span<const uint8_t> vertex_data;
+  std::span<const uint32_t> indices;
+  std::vector<MeshFileSubmesh> submeshes;
+};
+
+// Returns the size of the written file
+using MeshFileWriteRsl = std::variant<uint64_t, MeshFileError>;
+MeshFileWriteRsl write_mesh_file(const std::string& path,
+                                 const MeshFileDesc& desc);
+
+// GPU buffers of a loaded mesh, plus the file's tables. Buffers come from
+//  iggpu::create_buffer with the tag given to the loader (a string literal) -
+//  release them with destroy().
+struct LoadedMesh {
+  // Vertex | CopyDst
+  wgpu::Buffer vertex_buffer;
+  // Index | CopyDst
+  wgpu::Buffer index_buffer;
+  wgpu::IndexFormat index_format;
+
+  uint32_t vertex_stride;
+  uint32_t vertex_count;
+  uint32_t index_count;
+  std::vector<MeshFileAttribute> attributes;
+  std::vector<MeshFileSubmesh> submeshes;
+  float bounds_min[3];
+  float bounds_max[3];
+
+  // Attributes for a wgpu::VertexBufferLayout with vertex_stride
+  std::vector<wgpu::VertexAttribute> vertex_attributes() const;
+
+  void destroy();
+};
+
+using MeshLoadRsl = std::variant<LoadedMesh, MeshFileError>;
+
+// Creates the mesh's buffers from a file already in memory. On native the
+//  buffers are created mappedAtCreation and filled with one copy per blob;
+//  on web the blobs go through Queue.WriteBuffer, which copies straight out
+//  of the wasm heap (a mapped range there is a second heap allocation).
+MeshLoadRsl load_mesh_from_memory(AppBase* app_base,
+                                  std::span<const uint8_t> data,
+                                  const char* tag = "mesh");
+
+#ifndef __EMSCRIPTEN__
+// Maps the file (mmap, or a file mapping on Windows) and loads it with
+//  load_mesh_from_memory, so the only copy of each blob is the one from the
+//  page cache into the GPU buffer. Blocks on disk reads.
+MeshLoadRsl load_mesh_file(AppBase* app_base, const std::string& path,
+                           const char* tag = "mesh");
+#endif
+
+// On web, fetches the URL into the wasm heap with emscripten_fetch and
+//  uploads from there. On native, loads the file with load_mesh_file before
+//  returning.
+std::shared_ptr<igasync::Promise<MeshLoadRsl>> load_mesh_file_async(
+    AppBase* app_base, const std::string& path, const char* tag = "mesh");
+
+inline constexpr std::string mesh_file_error_text(MeshFileError err) {
+  switch (err) {
+    case MeshFileError::OpenFailed:
+      return "OpenFailed";
+    case MeshFileError::ReadFailed:
+      return "ReadFailed";
+    case MeshFileError::WriteFailed:
+      return "WriteFailed";
+    case MeshFileError::InvalidFile:
+      return "InvalidFile";
+    case MeshFileError::UnsupportedVersion:
+      return "UnsupportedVersion";
+    case MeshFileError::BufferCreationFailed:
+      return "BufferCreationFailed";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+}  // namespace iggpu
+
+#endif
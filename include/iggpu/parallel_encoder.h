@@ -0,0 +1,94 @@
+#ifndef IGGPU_PARALLEL_ENCODER_H
+#define IGGPU_PARALLEL_ENCODER_H
+
+#include <igasync/task_list.h>
+#include <iggpu/app_base.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace iggpu {
+
+struct ParallelEncoderStats {
+  uint64_t batches;
+  uint64_t jobs;
+
+  // Jobs run by worker threads (the rest ran on the calling thread)
+  uint64_t worker_jobs;
+
+  double last_batch_ms;
+};
+
+// Records a frame's commands on several threads at once.
+//
+// Each job gets its own CommandEncoder (record) or RenderBundleEncoder
+//  (record_bundles). Jobs are scheduled on an igasync::TaskList drained by
+//  worker threads and by the calling thread, which blocks until every job in
+//  the batch is done. Results are returned in the order the jobs were given,
+//  so command buffers can go into a single ordered Queue.Submit.
+//
+// Native builds need the device to have ImplicitDeviceSynchronization (AppBase
+//  requests it when available) - without it, and on web, jobs run one after
+//  another on the calling thread.
+//
+// Draws for one render pass can be split across threads with record_bundles,
+//  then replayed with RenderPassEncoder.ExecuteBundles.
+class ParallelEncoder {
+ public:
+  using EncoderJob = std::function<void(wgpu::CommandEncoder&)>;
+  using BundleJob = std::function<void(wgpu::RenderBundleEncoder&)>;
+
+  // worker_count of 0 runs every job on the calling thread
+  ParallelEncoder(AppBase* app_base, uint32_t worker_count);
+  ~ParallelEncoder();
+  ParallelEncoder(const ParallelEncoder&) = delete;
+  ParallelEncoder& operator=(const ParallelEncoder&) = delete;
+
+  // One worker per hardware thread, minus the calling thread
+  static uint32_t default_worker_count();
+
+  std::vector<wgpu::CommandBuffer> record(const std::vector<EncoderJob>& jobs);
+
+  std::vector<wgpu::RenderBundle> record_bundles(
+      const wgpu::RenderBundleEncoderDescriptor& desc,
+      const std::vector<BundleJob>& jobs);
+
+  // Records the jobs and submits every command buffer in one Queue.Submit
+  void submit(const std::vector<EncoderJob>& jobs);
+
+  uint32_t worker_count() const {
+    return static_cast<uint32_t>(workers_.size());
+  }
+  ParallelEncoderStats stats() const { return stats_; }
+
+ private:
+  // Runs job(i) for i in [0, job_count) and returns once all have finished
+  void run_batch(uint32_t job_count, const std::function<void(uint32_t)>& job);
+  void worker_loop();
+
+  AppBase* app_base_;
+  std::shared_ptr<igasync::TaskList> task_list_;
+  std::vector<std::thread> workers_;
+
+  // Workers sleep until batch_generation_ changes (or shutdown_ is set)
+  std::mutex mut_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  uint64_t batch_generation_;
+  bool shutdown_;
+  uint32_t jobs_remaining_;
+
+  std::atomic<uint64_t> worker_jobs_;
+  ParallelEncoderStats stats_;
+};
+
+}  // namespace iggpu
+
+#endif
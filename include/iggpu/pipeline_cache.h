@@ -0,0 +1,84 @@
+#ifndef IGGPU_PIPELINE_CACHE_H
+#define IGGPU_PIPELINE_CACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace iggpu {
+
+struct PipelineCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t stores;
+  uint64_t bytes_loaded;
+  uint64_t bytes_stored;
+
+  // Time spent inside the cache itself (file I/O)
+  double load_ms;
+  double store_ms;
+};
+
+// Key/value store for compiled shader and pipeline blobs.
+//
+// On native builds AppBase wires this up to Dawn's blob cache, so compiled
+//  backend shaders and pipelines are persisted across launches. Entries live
+//  in <cache_dir>/v<version>/<adapter key>/, so caches from different
+//  adapters or drivers never mix. Without a cache_dir, entries are kept in
+//  memory only.
+//
+// Browsers do not expose their shader cache (and cache compiled pipelines
+//  themselves), so on web builds this is only a memory store.
+class PipelineCache {
+ public:
+  // Bump to invalidate all existing on-disk caches
+  static constexpr uint32_t kCacheVersion = 1u;
+
+  explicit PipelineCache(std::string cache_dir);
+  PipelineCache(const PipelineCache&) = delete;
+  PipelineCache& operator=(const PipelineCache&) = delete;
+
+  // Selects the per-adapter cache subdirectory. Entries are only persisted
+  //  once this has been called (AppBase does this after adapter selection).
+  void set_adapter_key(const std::string& adapter_key);
+
+  // Dawn CachingInterface semantics: if value is null (or value_size is 0),
+  //  returns the size of the stored value (0 if missing). Otherwise copies up
+  //  to value_size bytes into value and returns the number copied.
+  size_t load(const void* key, size_t key_size, void* value,
+              size_t value_size);
+  void store(const void* key, size_t key_size, const void* value,
+             size_t value_size);
+
+  PipelineCacheStats stats() const;
+  bool is_persistent() const { return !adapter_dir_.empty(); }
+
+  // Records how long app startup (e.g. shader/pipeline creation) took. The
+  //  first startup that only missed the cache is saved as the cold baseline,
+  //  and later startups are compared against it (see startup_time_saved_ms)
+  void report_startup_time(double startup_ms);
+  std::optional<double> startup_time_saved_ms() const;
+
+ private:
+  std::string entry_path(const std::string& key) const;
+  bool read_entry(const std::string& key, std::vector<uint8_t>& out) const;
+  void write_entry(const std::string& key, const void* value,
+                   size_t value_size) const;
+
+  std::string cache_dir_;
+  std::string adapter_dir_;
+
+  mutable std::mutex mut_;
+  std::unordered_map<std::string, std::vector<uint8_t>> entries_;
+  std::unordered_set<std::string> known_missing_;
+  PipelineCacheStats stats_;
+  std::optional<double> startup_time_saved_ms_;
+};
+
+}  // namespace iggpu
+
+#endif
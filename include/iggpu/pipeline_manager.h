@@ -0,0 +1,103 @@
+#ifndef IGGPU_PIPELINE_MANAGER_H
+#define IGGPU_PIPELINE_MANAGER_H
+
+#include <igasync/promise.h>
+#include <iggpu/app_base.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace iggpu {
+
+struct PipelineManagerStats {
+  uint64_t requests;
+  // Requests that matched a pipeline already built or building
+  uint64_t deduplicated;
+  uint64_t builds_started;
+  uint64_t builds_completed;
+  uint64_t builds_failed;
+  double total_build_ms;
+  double max_build_ms;
+};
+
+// Builds render and compute pipelines off the main thread with
+//  Create*PipelineAsync, deduplicating identical descriptors.
+//
+// Descriptors are keyed by their contents (shader modules, entry points,
+//  constants, vertex layouts, formats, blend/depth-stencil/primitive state and
+//  pipeline layout), so materials that request the same pipeline share one
+//  build and one wgpu::RenderPipeline. Labels are not part of the key.
+//  Descriptors with extension structs (any nextInChain set) are never
+//  deduplicated - each request builds its own pipeline. Failed builds are
+//  not remembered either, so requesting the descriptor again retries.
+//
+// Requests return an id (render and compute ids are separate) that can be
+//  polled cheaply every frame with render_pipeline(id, fallback), so frames
+//  keep rendering (with a fallback pipeline, or skipping the draw) while the
+//  real pipeline compiles.
+class PipelineManager {
+ public:
+  using PipelineId = uint32_t;
+  using RenderPipelinePromise =
+      std::shared_ptr<igasync::Promise<wgpu::RenderPipeline>>;
+  using ComputePipelinePromise =
+      std::shared_ptr<igasync::Promise<wgpu::ComputePipeline>>;
+
+  explicit PipelineManager(AppBase* app_base);
+  PipelineManager(const PipelineManager&) = delete;
+  PipelineManager& operator=(const PipelineManager&) = delete;
+
+  PipelineId request_render_pipeline(
+      const wgpu::RenderPipelineDescriptor& desc);
+  PipelineId request_compute_pipeline(
+      const wgpu::ComputePipelineDescriptor& desc);
+
+  // Resolves with the pipeline (or a null pipeline if creation failed)
+  RenderPipelinePromise render_pipeline_promise(PipelineId id) const;
+  ComputePipelinePromise compute_pipeline_promise(PipelineId id) const;
+
+  // Returns the pipeline if it has finished building, otherwise the fallback
+  wgpu::RenderPipeline render_pipeline(
+      PipelineId id, wgpu::RenderPipeline fallback = nullptr) const;
+  wgpu::ComputePipeline compute_pipeline(
+      PipelineId id, wgpu::ComputePipeline fallback = nullptr) const;
+
+  PipelineManagerStats stats() const { return stats_; }
+
+ private:
+  // key is empty for descriptors that are not deduplicated
+  struct RenderEntry {
+    wgpu::RenderPipeline pipeline;
+    RenderPipelinePromise promise;
+    std::string key;
+  };
+
+  struct ComputeEntry {
+    wgpu::ComputePipeline pipeline;
+    ComputePipelinePromise promise;
+    std::string key;
+  };
+
+  void on_build_finished(bool success,
+                         std::chrono::steady_clock::time_point start);
+
+  AppBase* app_base_;
+
+  // Render and compute pipelines have separate id spaces
+  std::unordered_map<std::string, PipelineId> render_ids_;
+  std::unordered_map<std::string, PipelineId> compute_ids_;
+  std::vector<RenderEntry> render_entries_;
+  std::vector<ComputeEntry> compute_entries_;
+
+  PipelineManagerStats stats_;
+  std::shared_ptr<bool> alive_token_;
+};
+
+}  // namespace iggpu
+
+#endif
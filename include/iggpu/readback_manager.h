@@ -0,0 +1,155 @@
+#ifndef IGGPU_READBACK_MANAGER_H
+#define IGGPU_READBACK_MANAGER_H
+
+#include <igasync/promise.h>
+#include <iggpu/app_base.h>
+#include <iggpu/rolling_stats.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace iggpu {
+
+struct ReadbackResult {
+  bool success;
+
+  // Tightly packed - texture rows have their copy padding removed, so rows
+  //  are width * bytes-per-texel apart
+  std::vector<uint8_t> data;
+
+  // Texture readbacks only (0 for buffers)
+  uint32_t width;
+  uint32_t height;
+  uint32_t bytes_per_row;
+
+  // Frames (on_submitted calls) between the copy being recorded and the
+  //  result being delivered
+  uint64_t latency_frames;
+};
+
+struct ReadbackStats {
+  uint64_t requests;
+  uint64_t completed;
+  uint64_t failed;
+  uint64_t bytes_read;
+
+  // Requests refused because max_in_flight readbacks were already pending
+  uint64_t exhausted_count;
+
+  uint32_t in_flight;
+  uint32_t pool_buffer_count;
+};
+
+// GPU->CPU readback (screenshots, compute results, picking...) without
+//  stalling the frame.
+//
+// Copies are recorded into the frame's command encoder, into MapRead|CopyDst
+//  staging buffers taken from a pool. After submission the staging buffers
+//  are mapped asynchronously, and results are delivered through the callback
+//  (or promise) once the GPU has retired the copy - usually a frame or two
+//  later. Up to max_in_flight readbacks may be pending at once.
+//
+// Per frame:
+//   readback.read_texture(encoder, texture, {0, 0}, {w, h}, on_pixels);
+//   queue.Submit(...);
+//   readback.on_submitted();
+class ReadbackManager {
+ public:
+  // Row pitch alignment of texture to buffer copies (WebGPU rule)
+  static constexpr uint32_t kBytesPerRowAlignment = 256u;
+
+  using Callback = std::function<void(ReadbackResult)>;
+
+  explicit ReadbackManager(AppBase* app_base, uint32_t max_in_flight = 4u);
+  ~ReadbackManager();
+  ReadbackManager(const ReadbackManager&) = delete;
+  ReadbackManager& operator=(const ReadbackManager&) = delete;
+
+  // Records a copy of size bytes of src (which needs CopySrc usage) at
+  //  offset. offset and size must be multiples of 4. Returns false (and never
+  //  invokes cb) if the request is invalid or the pool is exhausted.
+  bool read_buffer(wgpu::CommandEncoder& encoder, wgpu::Buffer src,
+                   uint64_t offset, uint64_t size, Callback cb);
+
+  // Records a copy of a 2D region of one mip level of src (which needs
+  //  CopySrc usage). Only uncompressed color formats (and Depth32Float) are
+  //  supported.
+  bool read_texture(wgpu::CommandEncoder& encoder, wgpu::Texture src,
+                    wgpu::Origin3D origin, wgpu::Extent3D extent, Callback cb,
+                    uint32_t mip_level = 0u);
+
+  // Promise versions - if the request is refused, the promise resolves
+  //  immediately with success = false
+  std::shared_ptr<igasync::Promise<ReadbackResult>> read_buffer_async(
+      wgpu::CommandEncoder& encoder, wgpu::Buffer src, uint64_t offset,
+      uint64_t size);
+  std::shared_ptr<igasync::Promise<ReadbackResult>> read_texture_async(
+      wgpu::CommandEncoder& encoder, wgpu::Texture src, wgpu::Origin3D origin,
+      wgpu::Extent3D extent, uint32_t mip_level = 0u);
+
+  // Call after the command buffer passed to read_* has been submitted (once
+  //  per frame - latency_frames counts these calls)
+  void on_submitted();
+
+  bool can_read() const { return pending_count_ < max_in_flight_; }
+
+  // Blocks until a submitted readback completes and can_read() is true, or
+  //  nothing submitted is left to wait for. Results are delivered from here.
+  //  No-op on web, which cannot block.
+  void wait_for_capacity();
+
+  // Blocks until every submitted readback has been delivered (native only)
+  void wait_for_all();
+
+  ReadbackStats stats() const { return stats_; }
+  const RollingStats& latency_stats() const { return latency_frames_; }
+
+ private:
+  struct Request {
+    wgpu::Buffer buffer;
+    uint64_t size;
+    Callback cb;
+    uint64_t frame;
+
+    // Texture copies only - rows are padded to kBytesPerRowAlignment
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytes_per_row;
+    uint32_t padded_bytes_per_row;
+
+    GpuFuture map_future;
+  };
+
+  bool begin_request(uint64_t size);
+  bool wait_for_any_mapping();
+  wgpu::Buffer acquire_buffer(uint64_t size);
+  void on_mapped(Request& request, bool success);
+
+  AppBase* app_base_;
+  uint32_t max_in_flight_;
+
+  // Recorded this frame, mapped in on_submitted
+  std::vector<std::shared_ptr<Request>> recorded_;
+
+  // Submitted, waiting for MapAsync
+  std::vector<std::shared_ptr<Request>> mapping_;
+
+  // Recorded or mapping
+  uint32_t pending_count_;
+
+  // Unmapped staging buffers, ready for reuse
+  std::vector<wgpu::Buffer> free_buffers_;
+
+  uint64_t frame_;
+  ReadbackStats stats_;
+  RollingStats latency_frames_;
+
+  std::shared_ptr<bool> alive_token_;
+};
+
+}  // namespace iggpu
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef IGGPU_RENDER_TARGET_POOL_H
+#define IGGPU_RENDER_TARGET_POOL_H
+
+#include <iggpu/app_base.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace iggpu {
+
+// A width or height of 0 means "same as the surface" - those targets are
+//  recreated after the surface is resized.
+struct RenderTargetDesc {
+  uint32_t width = 0u;
+  uint32_t height = 0u;
+  wgpu::TextureFormat format = wgpu::TextureFormat::Undefined;
+  wgpu::TextureUsage usage = wgpu::TextureUsage::RenderAttachment;
+  uint32_t sample_count = 1u;
+};
+
+struct RenderTarget {
+  wgpu::Texture texture;
+  wgpu::TextureView view;
+};
+
+struct RenderTargetPoolStats {
+  uint64_t acquires;
+  uint64_t reuses;
+  uint64_t textures_created;
+  uint64_t textures_released;
+  uint64_t invalidations;
+
+  uint32_t texture_count;
+  uint32_t high_water_texture_count;
+};
+
+// Transient render targets (depth buffers, intermediate color targets...)
+//  shared between everything that renders with the same AppBase.
+//
+// Targets are handed out for a single frame and returned to the pool once
+//  the GPU has finished that frame, so a target is never shared by two frames
+//  in flight. Surface-sized targets are dropped in bulk when the surface is
+//  resized, and targets left unused for a while are released.
+//
+// Per frame:
+//   auto depth = pool.acquire({0, 0, wgpu::TextureFormat::Depth24Plus});
+//   ... render with depth.view ...
+//   queue.Submit(...);
+//   pool.end_frame();
+class RenderTargetPool {
+ public:
+  // Must not be used once app_base is destroyed, but may still be destroyed
+  //  after it.
+  explicit RenderTargetPool(AppBase* app_base,
+                            uint32_t max_idle_frames = 120u);
+  ~RenderTargetPool();
+  RenderTargetPool(const RenderTargetPool&) = delete;
+  RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+  // Returns a target matching desc, valid until end_frame(). Returns an
+  //  empty target if texture creation fails.
+  RenderTarget acquire(const RenderTargetDesc& desc);
+
+  // Call after the last command buffer using this frame's targets has been
+  //  submitted
+  void end_frame();
+
+  // Releases every pooled target (targets already handed out this frame
+  //  stay valid until the caller drops them)
+  void invalidate();
+
+  RenderTargetPoolStats stats() const { return stats_; }
+
+ private:
+  struct Key {
+    uint32_t width;
+    uint32_t height;
+    wgpu::TextureFormat format;
+    wgpu::TextureUsage usage;
+    uint32_t sample_count;
+    bool surface_sized;
+
+    bool operator<(const Key& o) const;
+  };
+
+  struct Entry {
+    RenderTarget target;
+
+    // Frame that last acquired this target - it is free once that frame
+    //  has completed on the GPU
+    uint64_t last_used_frame;
+  };
+
+  // Shared with pending GPU callbacks, which may outlive the pool
+  struct SharedState {
+    uint64_t completed_frame = 0u;
+  };
+
+  void on_resize();
+  void release_idle();
+  void update_texture_count();
+
+  AppBase* app_base_;
+  uint32_t max_idle_frames_;
+  ResizeListener resize_listener_;
+
+  std::map<Key, std::vector<Entry>> entries_;
+  uint64_t frame_index_;
+  std::shared_ptr<SharedState> shared_;
+
+  RenderTargetPoolStats stats_;
+};
+
+}  // namespace iggpu
+
+#endif
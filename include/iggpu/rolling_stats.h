@@ -0,0 +1,39 @@
+#ifndef IGGPU_ROLLING_STATS_H
+#define IGGPU_ROLLING_STATS_H
+
+#include <cstdint>
+#include <vector>
+
+namespace iggpu {
+
+struct Percentiles {
+  double p50;
+  double p95;
+  double p99;
+  double min;
+  double max;
+  double mean;
+  uint32_t sample_count;
+};
+
+// Fixed-size window of the most recent samples (e.g. frame times in ms), with
+//  percentile queries over that window. Adding a sample never allocates.
+class RollingStats {
+ public:
+  explicit RollingStats(uint32_t capacity = 240u);
+
+  void add(double sample);
+  void clear();
+
+  Percentiles percentiles() const;
+  uint32_t sample_count() const { return count_; }
+
+ private:
+  std::vector<double> samples_;
+  uint32_t next_;
+  uint32_t count_;
+};
+
+}  // namespace iggpu
+
+#endif
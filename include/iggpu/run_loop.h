@@ -0,0 +1,90 @@
+#ifndef IGGPU_RUN_LOOP_H
+#define IGGPU_RUN_LOOP_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace iggpu {
+
+struct RunLoopConfig {
+  // Simulation step for RunLoopCallbacks::update, in seconds. 0 calls update
+  //  once per frame with the (variable) frame time instead.
+  double fixed_timestep_s = 0.;
+
+  // Caps simulation catch-up after a long frame - further steps are dropped
+  //  instead of making the next frame even longer
+  uint32_t max_updates_per_frame = 8u;
+
+  // 0 for no cap. Frames are still paced by the present mode and frame pacer.
+  double max_fps = 0.;
+
+  // Longest the loop sleeps while idle (see RunLoopCallbacks::needs_frame)
+  //  before checking for work again. Input wakes it up immediately. Native
+  //  only - browsers already throttle animation frames.
+  double idle_wait_s = 0.25;
+};
+
+struct RunLoopCallbacks {
+  // Advances the simulation by dt_s seconds. Optional.
+  std::function<void(double dt_s)> update;
+
+  // Renders (and presents) one frame. With a fixed timestep, alpha in [0, 1)
+  //  is how far the frame falls between the last simulation step and the
+  //  next, for interpolating between the two states. Otherwise always 1.
+  std::function<void(double alpha)> render;
+
+  // Returns false if nothing changed since the last frame, in which case the
+  //  loop sleeps (no updates, no rendering) until input, a resize or
+  //  request_frame. Null to render continuously.
+  std::function<bool()> needs_frame;
+};
+
+// Timekeeping for AppBase::run - fixed timestep accumulation, frame rate cap
+//  and idle tracking. Owns no platform state, so both platforms share it.
+class RunLoop {
+ public:
+  RunLoop(RunLoopConfig config, RunLoopCallbacks callbacks);
+
+  RunLoop(const RunLoop&) = delete;
+  RunLoop& operator=(const RunLoop&) = delete;
+
+  const RunLoopConfig& config() const { return config_; }
+
+  // True if the app has work, or a frame was requested since the last one
+  bool wants_frame() const;
+
+  // Time until the frame rate cap allows the next frame (0 if it already does)
+  double seconds_until_next_frame() const;
+
+  // Runs the update steps due and renders one frame
+  void run_frame();
+
+  // Call after sleeping while idle - restarts the simulation clock, so the
+  //  idle time is not simulated in one burst when work resumes
+  void on_idle();
+
+  // Safe to call from any thread
+  void request_frame() { frame_requested_.store(true); }
+  void request_stop() { stop_requested_.store(true); }
+  bool stop_requested() const { return stop_requested_.load(); }
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  RunLoopConfig config_;
+  RunLoopCallbacks callbacks_;
+
+  bool has_last_frame_;
+  clock::time_point last_frame_;
+  clock::time_point next_frame_;
+  double accumulator_s_;
+
+  std::atomic<bool> frame_requested_;
+  std::atomic<bool> stop_requested_;
+};
+
+}  // namespace iggpu
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef IGGPU_UNIFORM_ARENA_H
+#define IGGPU_UNIFORM_ARENA_H
+
+#include <iggpu/app_base.h>
+#include <iggpu/upload_ring.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace iggpu {
+
+struct UniformArenaDesc {
+  // Size of each GPU buffer that allocations are carved from
+  uint64_t page_size = 1024u * 1024u;
+
+  // Bytes visible to a draw at its dynamic offset (the size of the bind group
+  //  entry) - the largest allocation the arena can make
+  uint32_t binding_size = 256u;
+
+  // Bind as read-only storage instead of uniform, e.g. for per-draw data
+  //  larger than maxUniformBufferBindingSize
+  bool storage = false;
+
+  wgpu::ShaderStage visibility =
+      wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
+
+  // Sets of pages rotated through, one per frame - should be at least the
+  //  frame pacer's max frames in flight + 1
+  uint32_t frame_count = 3u;
+};
+
+struct UniformArenaStats {
+  uint64_t allocations;
+  uint64_t bytes_allocated;
+
+  // Buffer writes (or UploadRing uploads) - one per page used per frame
+  uint64_t uploads;
+
+  // Largest number of bytes (including alignment padding) used in a frame
+  uint64_t high_water_bytes;
+
+  uint32_t page_count;
+
+  // allocate() calls refused for their size - only the first one is logged
+  uint64_t rejected_allocations;
+};
+
+struct UniformAllocation {
+  // Write the draw's constants here - copied to the GPU by upload()
+  uint8_t* data;
+  uint64_t size;
+
+  // Pass to SetBindGroup along with the bind group. Consecutive allocations
+  //  share a bind group until a page fills up.
+  uint32_t dynamic_offset;
+  wgpu::BindGroup bind_group;
+
+  explicit operator bool() const { return data != nullptr; }
+};
+
+// Per-frame suballocator for per-draw constants, as an alternative to one
+//  buffer (and one WriteBuffer) per object.
+//
+// Allocations are bump-allocated from CPU-side copies of a few large
+//  uniform (or storage) buffers, at minUniformBufferOffsetAlignment. Each
+//  buffer is bound once with a hasDynamicOffset layout, and draws select
+//  their constants with the dynamic offset - so thousands of small writes
+//  become one upload per page and one bind group per frame.
+//
+// Pages are rotated over frame_count frames, so a frame's upload never
+//  targets a buffer that frames still in flight are reading.
+//
+// Per frame:
+//   auto a = arena.push(object_constants);
+//   pass.SetBindGroup(1, a.bind_group, 1, &a.dynamic_offset);
+//   pass.Draw(...);
+//   ...
+//   arena.upload();  // before submitting
+//   queue.Submit(...);
+//   arena.end_frame();
+class UniformArena {
+ public:
+  explicit UniformArena(AppBase* app_base, UniformArenaDesc desc = {});
+  ~UniformArena();
+  UniformArena(const UniformArena&) = delete;
+  UniformArena& operator=(const UniformArena&) = delete;
+
+  // One entry at binding 0, with hasDynamicOffset - use in pipeline layouts
+  wgpu::BindGroupLayout bind_group_layout() const { return layout_; }
+
+  // Offset alignment of allocations (the device's minimum dynamic offset
+  //  alignment for the binding type)
+  uint32_t alignment() const { return alignment_; }
+
+  // Returns an empty allocation if size is 0 or larger than binding_size, or
+  //  if a page could not be created
+  UniformAllocation allocate(uint64_t size);
+
+  template <typename T>
+  UniformAllocation push(const T& value) {
+    UniformAllocation a = allocate(sizeof(T));
+    if (a) {
+      std::memcpy(a.data, &value, sizeof(T));
+    }
+    return a;
+  }
+
+  // Uploads this frame's allocations with one Queue.WriteBuffer per page
+  //  used, or stages them in upload_ring (whose record_copies must then run
+  //  before the passes that draw with them)
+  void upload(UploadRing* upload_ring = nullptr);
+
+  // Call once per frame, after submitting - moves on to the next frame's
+  //  pages
+  void end_frame();
+
+  UniformArenaStats stats() const { return stats_; }
+
+ private:
+  struct Page {
+    wgpu::Buffer buffer;
+    wgpu::BindGroup bind_group;
+    std::vector<uint8_t> data;
+    uint64_t used;
+  };
+
+  bool add_page(std::vector<Page>& pages);
+
+  AppBase* app_base_;
+  UniformArenaDesc desc_;
+  uint32_t alignment_;
+  wgpu::BindGroupLayout layout_;
+
+  // Pages of each frame in the rotation
+  std::vector<std::vector<Page>> frames_;
+  uint32_t frame_slot_;
+  uint32_t current_page_;
+
+  UniformArenaStats stats_;
+};
+
+}  // namespace iggpu
+
+#endif
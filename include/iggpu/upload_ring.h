@@ -0,0 +1,132 @@
+#ifndef IGGPU_UPLOAD_RING_H
+#define IGGPU_UPLOAD_RING_H
+
+#include <iggpu/app_base.h>
+#include <webgpu/webgpu_cpp.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace iggpu {
+
+struct UploadRingStats {
+  uint64_t bytes_uploaded;
+  uint64_t upload_count;
+
+  // Number of times an allocation had to wait for the GPU to retire a staging
+  //  buffer (native), or grew the ring past max_slots because none were free
+  //  (web, which cannot block)
+  uint64_t stall_count;
+
+  // Largest number of staged bytes not yet retired by the GPU
+  uint64_t high_water_bytes;
+
+  uint32_t slot_count;
+  uint32_t high_water_slots;
+};
+
+// Staging memory for CPU->GPU uploads, as an alternative to Queue.WriteBuffer.
+//
+// Allocations are bump-allocated from a ring of MapWrite|CopySrc staging
+//  buffers, and written directly by the caller. The copies into destination
+//  buffers are recorded into the frame's command encoder by record_copies().
+//  Staging buffers are recycled (re-mapped with MapAsync) once the GPU has
+//  retired the frame that used them.
+//
+// Per frame:
+//   auto data = ring.allocate(vertex_buffer, 0, size);  // write into data
+//   ring.record_copies(encoder);  // before passes that read vertex_buffer
+//   queue.Submit(...);
+//   ring.on_submitted();
+class UploadRing {
+ public:
+  // Offsets and sizes of copies must be multiples of this (WebGPU rule)
+  static constexpr uint64_t kCopyAlignment = 4u;
+
+  UploadRing(AppBase* app_base, uint64_t slot_size = 4u * 1024u * 1024u,
+             uint32_t max_slots = 8u);
+  ~UploadRing();
+  UploadRing(const UploadRing&) = delete;
+  UploadRing& operator=(const UploadRing&) = delete;
+
+  // Returns writable staging memory that will be copied to dst at dst_offset.
+  //  dst_offset and size must be multiples of kCopyAlignment. Returns an
+  //  empty span on error. The memory is valid until record_copies().
+  std::span<uint8_t> allocate(wgpu::Buffer dst, uint64_t dst_offset,
+                              uint64_t size);
+
+  // Copies data into staging memory (see allocate)
+  bool upload(wgpu::Buffer dst, uint64_t dst_offset, const void* data,
+              uint64_t size);
+
+  // Records copies for all pending allocations into the encoder. Call before
+  //  any pass that reads the destination buffers.
+  void record_copies(wgpu::CommandEncoder& encoder);
+
+  // Call after the command buffer passed to record_copies has been submitted
+  void on_submitted();
+
+  UploadRingStats stats() const;
+
+ private:
+  enum class SlotState {
+    // Mapped, ready to be allocated from
+    Free,
+    // Mapped, allocations in the current frame are coming from this slot
+    Active,
+    // Unmapped with copies recorded, waiting for submission
+    Recorded,
+    // Submitted, waiting for MapAsync to complete
+    InFlight,
+    // Could not be re-mapped or replaced - never used again, and not counted
+    //  against max_slots
+    Dead,
+  };
+
+  struct Slot {
+    wgpu::Buffer buffer;
+    uint8_t* mapped_data;
+    uint64_t offset;
+    SlotState state;
+
+    // MapAsync of an InFlight slot
+    GpuFuture map_future;
+  };
+
+  struct PendingCopy {
+    wgpu::Buffer src;
+    uint64_t src_offset;
+    wgpu::Buffer dst;
+    uint64_t dst_offset;
+    uint64_t size;
+  };
+
+  int32_t acquire_slot();
+  int32_t create_slot();
+  uint32_t live_slot_count() const;
+  void count_staged(uint64_t size);
+  void on_slot_mapped(uint32_t slot_idx, bool success);
+
+  AppBase* app_base_;
+  uint64_t slot_size_;
+  uint32_t max_slots_;
+
+  std::vector<Slot> slots_;
+  int32_t active_slot_;
+  std::vector<PendingCopy> pending_copies_;
+
+  // Oversized allocations get a dedicated staging buffer, released once the
+  //  copy has been recorded (WebGPU keeps it alive until the copy finishes)
+  std::vector<wgpu::Buffer> oversized_buffers_;
+
+  UploadRingStats stats_;
+  uint64_t staged_bytes_;
+
+  std::shared_ptr<bool> alive_token_;
+};
+
+}  // namespace iggpu
+
+#endif
@@ -1,6 +1,7 @@
 #include <iggpu/app_base.h>
 
 #include <iostream>
+#include <utility>
 
 int main() {
   auto app_create_rsl = iggpu::AppBase::Create();
@@ -16,10 +17,11 @@ int main() {
   std::unique_ptr<iggpu::AppBase> app =
       std::move(std::get<std::unique_ptr<iggpu::AppBase>>(app_create_rsl));
 
-  while (!glfwWindowShouldClose(app->Window)) {
-    app->process_events();
-    glfwPollEvents();
-  }
+  // Nothing is drawn, so there is never work to do - the loop just sleeps
+  //  until the window is closed
+  iggpu::RunLoopCallbacks callbacks{};
+  callbacks.needs_frame = []() { return false; };
+  app->run(iggpu::RunLoopConfig{}, std::move(callbacks));
 
   return 0;
 }
\ No newline at end of file
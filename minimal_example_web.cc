@@ -1,12 +1,10 @@
-#include <emscripten.h>
 #include <iggpu/app_base.h>
 
 #include <iostream>
+#include <utility>
 
 std::unique_ptr<iggpu::AppBase> gApp;
 
-void main_loop() {}
-
 int main(int, char**) {
   iggpu::AppBase::Create("#canvas")->consume([](auto app_create_rsl) {
     if (std::holds_alternative<iggpu::AppBaseCreateError>(app_create_rsl)) {
@@ -18,7 +16,9 @@ int main(int, char**) {
 
     gApp = std::move(std::get<std::unique_ptr<iggpu::AppBase>>(app_create_rsl));
 
-    emscripten_set_main_loop(main_loop, 0, 1);
+    iggpu::RunLoopCallbacks callbacks{};
+    callbacks.needs_frame = []() { return false; };
+    gApp->run(iggpu::RunLoopConfig{}, std::move(callbacks));
 
     std::cout << "Success!" << std::endl;
   });
@@ -2,15 +2,28 @@
 #define IGGPU_PLATFORM_APP_BASE_H
 
 #include <GLFW/glfw3.h>
+#include <iggpu/frame_pacer.h>
+#include <iggpu/pipeline_cache.h>
+#include <iggpu/run_loop.h>
 #include <webgpu/webgpu_cpp.h>
 
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
-#ifdef __EMSCRIPTEN__
+#include <igasync/execution_context.h>
 #include <igasync/promise.h>
-#else
+
+#ifndef __EMSCRIPTEN__
 #include <dawn/native/DawnNative.h>
 #endif
 
@@ -22,6 +35,73 @@ enum class AppBaseCreateError {
   WGPUDeviceCreationFailed,
   WGPUNoSuitableAdapters,
   WGPUSurfaceCreateFailed,
+  WGPUOffscreenTargetCreateFailed,
+};
+
+// Adapter selection for headless (windowless) apps. CPU prefers a software
+//  adapter (SwiftShader) so that apps run on machines with no display or GPU,
+//  Default prefers hardware adapters in the same order as windowed apps, and
+//  Null uses Dawn's Null backend (no rendering happens, useful for measuring
+//  CPU-side overhead only). CPU and Default fall back to Null if no other
+//  adapter is available.
+enum class HeadlessAdapterType {
+  Default,
+  CPU,
+  Null,
+};
+
+// Handle for waiting on an async GPU operation (see AppBase::wait). Web
+//  callbacks fire from the browser event loop, which can't be blocked, so
+//  web futures are empty placeholders and wait/wait_any don't exist there -
+//  code shared with web should use the callbacks or iggpu::as_promise.
+#ifdef __EMSCRIPTEN__
+struct GpuFuture {};
+#else
+using GpuFuture = wgpu::Future;
+#endif
+
+// Resize callbacks registered with an AppBase. Heap allocated and shared
+//  with ResizeListener handles, which may outlive the AppBase.
+struct ResizeListenerList {
+  std::vector<std::pair<uint32_t, std::function<void(uint32_t, uint32_t)>>>
+      listeners;
+  uint32_t next_id = 1u;
+};
+
+// Keeps a resize listener registered until destroyed or reset. Safe to
+//  destroy after the AppBase that issued it (it does nothing then).
+class ResizeListener {
+ public:
+  ResizeListener() = default;
+  ResizeListener(std::weak_ptr<ResizeListenerList> list, uint32_t id)
+      : list_(std::move(list)), id_(id) {}
+  ~ResizeListener() { reset(); }
+
+  ResizeListener(const ResizeListener&) = delete;
+  ResizeListener& operator=(const ResizeListener&) = delete;
+  ResizeListener(ResizeListener&& o) noexcept
+      : list_(std::move(o.list_)), id_(std::exchange(o.id_, 0u)) {}
+  ResizeListener& operator=(ResizeListener&& o) noexcept {
+    if (this != &o) {
+      reset();
+      list_ = std::move(o.list_);
+      id_ = std::exchange(o.id_, 0u);
+    }
+    return *this;
+  }
+
+  void reset() {
+    if (auto list = list_.lock()) {
+      std::erase_if(list->listeners,
+                    [this](const auto& l) { return l.first == id_; });
+    }
+    list_.reset();
+    id_ = 0u;
+  }
+
+ private:
+  std::weak_ptr<ResizeListenerList> list_;
+  uint32_t id_ = 0u;
 };
 
 struct AppBase {
@@ -44,22 +124,184 @@ struct AppBase {
       std::string canvas_name,
       wgpu::TextureFormat preferred_format = wgpu::TextureFormat::BGRA8Unorm,
       bool prefer_high_power = true);
+
+  // Web creation is always asynchronous
+  using AppBaseCreatePromise = AppBaseCreateRsl;
 #else
   using AppBaseCreateRsl =
       std::variant<std::unique_ptr<AppBase>, AppBaseCreateError>;
   static AppBaseCreateRsl Create(
       uint32_t width = 0u, uint32_t height = 0u,
       wgpu::TextureFormat preferred_format = wgpu::TextureFormat::BGRA8Unorm,
-      const char* window_title = "IGGPU App");
+      const char* window_title = "IGGPU App",
+      const char* pipeline_cache_dir = nullptr);
+
+  // Same as Create, but returns immediately with the same promise type as the
+  //  web build. Adapter enumeration and device creation run on a worker
+  //  thread, overlapping window creation and whatever the caller does next
+  //  (e.g. loading assets). The final step (surface creation) is scheduled on
+  //  main_thread_tasks, which must be executed on the calling thread - GLFW
+  //  windows may only be used from the main thread.
+  using AppBaseCreatePromise = std::shared_ptr<igasync::Promise<
+      std::variant<std::unique_ptr<AppBase>, AppBaseCreateError>>>;
+  static AppBaseCreatePromise CreateAsync(
+      std::shared_ptr<igasync::ExecutionContext> main_thread_tasks,
+      uint32_t width = 0u, uint32_t height = 0u,
+      wgpu::TextureFormat preferred_format = wgpu::TextureFormat::BGRA8Unorm,
+      const char* window_title = "IGGPU App",
+      const char* pipeline_cache_dir = nullptr);
+
+  // Creates an app with no window and no surface - frames are rendered into a
+  //  small ring of offscreen textures instead (see get_current_texture).
+  static AppBaseCreateRsl CreateHeadless(
+      uint32_t width, uint32_t height,
+      wgpu::TextureFormat format = wgpu::TextureFormat::BGRA8Unorm,
+      HeadlessAdapterType adapter_type = HeadlessAdapterType::CPU,
+      const char* pipeline_cache_dir = nullptr);
 
  private:
+  // Instance, adapter and device - everything that does not need a window
+  struct DeviceSetup;
+  using DeviceSetupRsl =
+      std::variant<std::unique_ptr<DeviceSetup>, AppBaseCreateError>;
+  static DeviceSetupRsl create_device_setup(
+      const char* pipeline_cache_dir, bool headless,
+      HeadlessAdapterType headless_adapter_type);
+  static AppBaseCreateRsl finish_create(std::unique_ptr<DeviceSetup> setup,
+                                        GLFWwindow* window,
+                                        wgpu::TextureFormat preferred_format,
+                                        uint32_t width, uint32_t height);
+
+  bool create_offscreen_targets(uint32_t width, uint32_t height);
+
+  // Declared before instance_ - Dawn may use the cache until the instance is
+  //  destroyed.
+  std::unique_ptr<PipelineCache> pipeline_cache_;
+  std::unique_ptr<dawn::platform::Platform> platform_;
   std::unique_ptr<dawn::native::Instance> instance_;
+  std::vector<wgpu::Texture> offscreen_targets_;
+  uint32_t offscreen_target_index_;
+
+  // Work-done futures of frames still in flight, oldest first - begin_frame
+  //  waits on these instead of polling
+  std::deque<GpuFuture> frame_done_futures_;
 
  public:
+  // Runs callbacks for GPU work that has completed, without blocking
   void process_events();
+
+  static constexpr uint64_t kWaitForever =
+      std::numeric_limits<uint64_t>::max();
+
+  // Blocks the calling thread until the future completes (its callback runs
+  //  on this thread before returning) or timeout_ns passes. Returns false on
+  //  timeout. Unlike polling process_events, the thread sleeps until the GPU
+  //  signals completion. Callbacks of other completed operations still wait
+  //  for the next process_events.
+  bool wait(GpuFuture future, uint64_t timeout_ns = kWaitForever);
+
+  // Same, for whichever future completes first. Returns its index, or -1 on
+  //  timeout (or if there are more futures than Dawn can wait on at once).
+  int32_t wait_any(std::span<const GpuFuture> futures,
+                   uint64_t timeout_ns = kWaitForever);
 #endif
   void resize_surface(uint32_t width, uint32_t height);
 
+  // Callbacks invoked with the new size after the surface (or offscreen
+  //  targets) are resized, e.g. to recreate size-dependent textures. Called
+  //  at most once per frame for window resizes (see begin_frame). The
+  //  callback stays registered for as long as the returned handle lives.
+  [[nodiscard]] ResizeListener add_resize_listener(
+      std::function<void(uint32_t width, uint32_t height)> cb);
+
+  // Texture to render the current frame into - the surface texture for
+  //  windowed apps, or the current offscreen target for headless apps.
+  wgpu::Texture get_current_texture();
+
+  // Starts a frame - call before sampling input for the frame. Waits until
+  //  the frame pacer allows another frame in flight (see frame_pacer()). Web
+  //  apps cannot wait, so this instead returns false if the frame should be
+  //  skipped. Apps that never call begin_frame are not throttled.
+  //
+  // Window/canvas resizes since the last frame are also applied here, as a
+  //  single resize_surface call however many resize events arrived.
+  //  Summaries of repeated GPU errors are logged from here (see
+  //  iggpu/gpu_errors.h).
+  bool begin_frame();
+
+  // Finishes the current frame (presents the surface, or advances the
+  //  offscreen target ring for headless apps)
+  void present();
+
+  // Runs the main loop - begin_frame, input polling, update and render -
+  //  until the window closes or stop_run is called. While needs_frame says
+  //  there is nothing to do, the loop sleeps on input instead of spinning,
+  //  so idle apps use next to no CPU.
+  //
+  // On web the browser owns the loop: run schedules it on animation frames
+  //  and returns immediately. The AppBase must not move while it runs.
+  void run(RunLoopConfig config, RunLoopCallbacks callbacks);
+  void stop_run();
+
+  // Renders a frame even if needs_frame says nothing changed. Safe to call
+  //  from other threads while run is active (wakes up an idle native loop).
+  void request_frame();
+
+  FramePacer& frame_pacer() { return frame_pacer_; }
+  const FramePacer& frame_pacer() const { return frame_pacer_; }
+
+  // Reconfigures the surface with a new present mode. Returns false (and
+  //  keeps the current mode) if the surface does not support it. Fifo is
+  //  always supported.
+  bool set_present_mode(wgpu::PresentMode present_mode);
+  wgpu::PresentMode present_mode() const { return present_mode_; }
+  const std::vector<wgpu::PresentMode>& supported_present_modes() const {
+    return supported_present_modes_;
+  }
+
+  // Surface capabilities, queried once at creation (empty for headless apps)
+  const std::vector<wgpu::TextureFormat>& supported_surface_formats() const {
+    return supported_surface_formats_;
+  }
+  const std::vector<wgpu::CompositeAlphaMode>& supported_alpha_modes() const {
+    return supported_alpha_modes_;
+  }
+
+  bool is_headless() const { return !Surface; }
+
+  // Persistent shader/pipeline cache - null unless a pipeline_cache_dir was
+  //  given at creation time (always null on web, see PipelineCache)
+  PipelineCache* pipeline_cache() const;
+
+  // Invokes the callback once all work submitted to Queue so far has been
+  //  completed by the GPU. Native callbacks fire from process_events() or
+  //  wait() on the returned future.
+  GpuFuture on_submitted_work_done(std::function<void()> cb);
+
+  // Maps a buffer and invokes the callback with the result (true on success)
+  //  once the GPU is done with it. Native callbacks fire from process_events()
+  //  or wait().
+  GpuFuture map_buffer_async(wgpu::Buffer buffer, wgpu::MapMode mode,
+                             size_t offset, size_t size,
+                             std::function<void(bool)> cb);
+
+  // Builds a pipeline without blocking the calling thread, and invokes the
+  //  callback with the result (null on failure). Native callbacks fire from
+  //  process_events() or wait(). See also iggpu::PipelineManager.
+  GpuFuture create_render_pipeline_async(
+      const wgpu::RenderPipelineDescriptor& desc,
+      std::function<void(wgpu::RenderPipeline)> cb);
+  GpuFuture create_compute_pipeline_async(
+      const wgpu::ComputePipelineDescriptor& desc,
+      std::function<void(wgpu::ComputePipeline)> cb);
+
+  // Device error scopes - prefer iggpu::GpuErrorScope. The callback gets
+  //  NoError if nothing in the scope failed. Native callbacks fire from
+  //  process_events().
+  void push_error_scope(wgpu::ErrorFilter filter);
+  void pop_error_scope(
+      std::function<void(wgpu::ErrorType, std::string_view)> cb);
+
  public:
   GLFWwindow* Window;
   wgpu::Adapter Adapter;
@@ -70,8 +312,75 @@ struct AppBase {
   wgpu::Queue Queue;
   uint32_t Width;
   uint32_t Height;
+
+ private:
+  // Written by window system resize callbacks and applied by begin_frame.
+  //  Heap allocated, since callbacks hold its address and AppBase can move.
+  struct PendingResize {
+    bool pending = false;
+    uint32_t width = 0u;
+    uint32_t height = 0u;
+#ifdef __EMSCRIPTEN__
+    std::string canvas_name;
+#endif
+  };
+
+  void configure_surface();
+  void notify_resize_listeners();
+  void apply_pending_resize();
+
+  // Minimized windows report 0x0, which can't be applied - those stay
+  //  pending without counting as work for run()
+  bool has_pending_resize() const {
+    return pending_resize_ && pending_resize_->pending &&
+           pending_resize_->width > 0u && pending_resize_->height > 0u;
+  }
+
+  FramePacer frame_pacer_;
+  wgpu::PresentMode present_mode_ = wgpu::PresentMode::Fifo;
+  std::vector<wgpu::PresentMode> supported_present_modes_;
+  std::vector<wgpu::TextureFormat> supported_surface_formats_;
+  std::vector<wgpu::CompositeAlphaMode> supported_alpha_modes_;
+
+  std::shared_ptr<ResizeListenerList> resize_listeners_ =
+      std::make_shared<ResizeListenerList>();
+  std::unique_ptr<PendingResize> pending_resize_ =
+      std::make_unique<PendingResize>();
+
+  // Only set while run() is active
+  std::unique_ptr<RunLoop> run_loop_;
 };
 
+// Adapts a callback-style async call (e.g. AppBase::map_buffer_async) to an
+//  igasync promise, resolved with the callback's argument (T = void for
+//  callbacks that take none):
+//
+//   auto mapped = iggpu::as_promise<bool>([&](auto resolve) {
+//     app_base->map_buffer_async(buffer, wgpu::MapMode::Read, 0, size,
+//                                resolve);
+//   });
+//
+// Works the same on web, where the promise resolves from the browser event
+//  loop. Natively it resolves from process_events() or wait().
+template <typename T, typename StartFn>
+std::shared_ptr<igasync::Promise<T>> as_promise(StartFn&& start) {
+  auto promise = igasync::Promise<T>::Create();
+  if constexpr (std::is_void_v<T>) {
+    start([promise]() { promise->resolve(); });
+  } else {
+    start([promise](T value) { promise->resolve(std::move(value)); });
+  }
+  return promise;
+}
+
+// Promise form of AppBase::on_submitted_work_done
+inline std::shared_ptr<igasync::Promise<void>> submitted_work_done_promise(
+    AppBase& app_base) {
+  return iggpu::as_promise<void>([&app_base](auto resolve) {
+    app_base.on_submitted_work_done(std::move(resolve));
+  });
+}
+
 inline constexpr std::string app_base_create_error_text(
     AppBaseCreateError err) {
   switch (err) {
@@ -85,6 +394,8 @@ inline constexpr std::string app_base_create_error_text(
       return "WGPUNoSuitableAdapters";
     case AppBaseCreateError::WGPUSurfaceCreateFailed:
       return "WGPUSurfaceCreateFailed";
+    case AppBaseCreateError::WGPUOffscreenTargetCreateFailed:
+      return "WGPUOffscreenTargetCreateFailed";
     default:
       return "UNKNOWN";
   }
@@ -1,81 +1,74 @@
 #include <dawn/dawn_proc.h>
 #include <dawn/native/DawnNative.h>
+#include <dawn/platform/DawnPlatform.h>
+#include <igasync/task.h>
 #include <iggpu/app_base.h>
+#include <iggpu/gpu_errors.h>
+#include <iggpu/gpu_memory.h>
 #include <iggpu/iggpu_config.h>
 #include <iggpu/log.h>
 #include <webgpu/webgpu_glfw.h>
 
+#include <algorithm>
+#include <chrono>
 #include <format>
+#include <optional>
+#include <string_view>
+#include <thread>
 
 namespace {
 
+// WGPU_STRLEN means null-terminated
+std::string_view to_string_view(const char* data, size_t length) {
+  if (data == nullptr) {
+    return {};
+  }
+  return length == WGPU_STRLEN ? std::string_view(data)
+                               : std::string_view(data, length);
+}
+
 void print_wgpu_device_error(WGPUErrorType error_type, WGPUStringView message,
                              void*) {
-  const char* error_type_name = "";
-  switch (error_type) {
-    case WGPUErrorType_Validation:
-      error_type_name = "Validation";
-      break;
-    case WGPUErrorType_OutOfMemory:
-      error_type_name = "OutOfMemory";
-      break;
-    case WGPUErrorType_DeviceLost:
-      error_type_name = "DeviceLost";
-      break;
-    case WGPUErrorType_Unknown:
-      error_type_name = "Unknown";
-      break;
-    default:
-      error_type_name = "UNEXPECTED (this is bad)";
-      break;
+  // Deduplicated and rate limited - errors tend to repeat every draw call
+  iggpu::report_gpu_error(static_cast<wgpu::ErrorType>(error_type),
+                          ::to_string_view(message.data, message.length));
+  if (error_type == WGPUErrorType_OutOfMemory) {
+    iggpu::report_gpu_out_of_memory();
   }
-
-  iggpu::log(iggpu::LogLevel::Error,
-             std::format("[IGGPU] Dawn error - {} - {}", error_type_name,
-                         std::string_view(message.data, message.length)));
 }
 
 void device_lost_callback(WGPUDevice const* device, WGPUDeviceLostReason reason,
                           WGPUStringView msg, void*) {
-  const char* lost_reason = "";
-  switch (reason) {
-    case WGPUDeviceLostReason_Destroyed:
-      lost_reason = "WGPUDeviceLostReason_Destroyed";
-      break;
-    default:
-      lost_reason = "WGPUDeviceLostReason_Unknown";
-      break;
+  if (reason == WGPUDeviceLostReason_Destroyed) {
+    IGGPU_LOG_INFO("[IGGPU] Dawn device destroyed");
+    return;
   }
 
-  auto formatted_string =
-      std::format("[IGGPU] Dawn device lost - {} - {}", lost_reason,
-                  std::string_view(msg.data, msg.length));
-  iggpu::log(iggpu::LogLevel::Error, formatted_string);
+  iggpu::report_gpu_error(wgpu::ErrorType::DeviceLost,
+                          ::to_string_view(msg.data, msg.length));
 }
 
 void glfw_error(int code, const char* msg) {
-  iggpu::log(iggpu::LogLevel::Error,
-             std::format("[IGGPU] GLFW error {}: {}", code, msg));
+  IGGPU_LOG_ERROR("[IGGPU] GLFW error %d: %s", code, msg);
 }
 
 void device_log_callback(WGPULoggingType type, WGPUStringView msg, void*) {
+  std::string_view message = ::to_string_view(msg.data, msg.length);
   switch (type) {
     case WGPULoggingType_Error:
-      iggpu::log(iggpu::LogLevel::Error,
-                 std::format("[IGGPU/Dawn] {}",
-                             std::string_view(msg.data, msg.length)));
+      iggpu::report_gpu_log_message(iggpu::LogLevel::Error, message);
       return;
     case WGPULoggingType_Warning:
-      iggpu::log(iggpu::LogLevel::Warning,
-                 std::format("[IGGPU/Dawn] {}",
-                             std::string_view(msg.data, msg.length)));
+      iggpu::report_gpu_log_message(iggpu::LogLevel::Warning, message);
       return;
     case WGPULoggingType_Info:
-      iggpu::log(iggpu::LogLevel::Info,
-                 std::format("[IGGPU/Dawn] {}",
-                             std::string_view(msg.data, msg.length)));
+      IGGPU_LOG_INFO("[IGGPU/Dawn] %.*s", static_cast<int>(message.size()),
+                     message.data());
       return;
-    default:  // Do not log verbose messages (by default)
+    default:
+      // Off unless enabled with iggpu::set_log_level(LogLevel::Verbose)
+      IGGPU_LOG_VERBOSE("[IGGPU/Dawn] %.*s", static_cast<int>(message.size()),
+                        message.data());
       return;
   }
 }
@@ -123,6 +116,208 @@ dawn::native::Adapter get_adapter(
   return {};
 }
 
+dawn::native::Adapter get_headless_adapter(
+    dawn::native::Instance* instance, iggpu::HeadlessAdapterType adapter_type) {
+  if (adapter_type == iggpu::HeadlessAdapterType::Default) {
+    wgpu::RequestAdapterOptions options = {};
+    options.powerPreference = wgpu::PowerPreference::HighPerformance;
+    auto adapter = ::get_adapter(instance->EnumerateAdapters(&options));
+    if (adapter) {
+      return adapter;
+    }
+  }
+
+  if (adapter_type != iggpu::HeadlessAdapterType::Null) {
+    wgpu::RequestAdapterOptions options = {};
+    options.forceFallbackAdapter = true;
+    auto adapters = instance->EnumerateAdapters(&options);
+    for (const auto& adapter : adapters) {
+      wgpu::AdapterInfo adapterInfo{};
+      adapter.GetInfo(&adapterInfo);
+      if (adapterInfo.adapterType == wgpu::AdapterType::CPU) {
+        return adapter;
+      }
+    }
+  }
+
+  wgpu::RequestAdapterOptions null_options = {};
+  null_options.backendType = wgpu::BackendType::Null;
+  auto null_adapters = instance->EnumerateAdapters(&null_options);
+  if (null_adapters.size() > 0) {
+    return null_adapters[0];
+  }
+
+  // No suitable adapter found!
+  return {};
+}
+
+// Routes Dawn's blob cache (compiled backend shaders and pipelines) to an
+//  iggpu::PipelineCache
+class PipelineCachingInterface : public dawn::platform::CachingInterface {
+ public:
+  explicit PipelineCachingInterface(iggpu::PipelineCache* cache)
+      : cache_(cache) {}
+
+  size_t LoadData(const void* key, size_t keySize, void* value,
+                  size_t valueSize) override {
+    return cache_->load(key, keySize, value, valueSize);
+  }
+
+  void StoreData(const void* key, size_t keySize, const void* value,
+                 size_t valueSize) override {
+    cache_->store(key, keySize, value, valueSize);
+  }
+
+ private:
+  iggpu::PipelineCache* cache_;
+};
+
+class CachingPlatform : public dawn::platform::Platform {
+ public:
+  explicit CachingPlatform(iggpu::PipelineCache* cache)
+      : caching_interface_(cache) {}
+
+  dawn::platform::CachingInterface* GetCachingInterface() override {
+    return &caching_interface_;
+  }
+
+ private:
+  PipelineCachingInterface caching_interface_;
+};
+
+std::string to_string(wgpu::StringView sv) {
+  if (sv.data == nullptr) {
+    return "";
+  }
+  if (sv.length == WGPU_STRLEN) {
+    return std::string(sv.data);
+  }
+  return std::string(sv.data, sv.length);
+}
+
+// Pipeline cache entries are only valid for the adapter (and driver) that
+//  produced them
+std::string pipeline_cache_adapter_key(const dawn::native::Adapter& adapter) {
+  wgpu::AdapterInfo info{};
+  adapter.GetInfo(&info);
+  return std::format("{:04x}-{:04x}-{}-{}", info.vendorID, info.deviceID,
+                     static_cast<uint32_t>(info.backendType),
+                     ::to_string(info.description));
+}
+
+std::unique_ptr<dawn::native::Instance> create_instance(
+    dawn::platform::Platform* platform) {
+  DawnProcTable procs_table = dawn::native::GetProcs();
+  dawnProcSetProcs(&procs_table);
+
+  dawn::native::DawnInstanceDescriptor dawn_instance_descriptor{};
+  dawn_instance_descriptor.platform = platform;
+
+  WGPUInstanceDescriptor instance_descriptor{};
+  instance_descriptor.features.timedWaitAnyEnable = true;
+  if (platform != nullptr) {
+    instance_descriptor.nextInChain =
+        reinterpret_cast<WGPUChainedStruct*>(&dawn_instance_descriptor);
+  }
+  return std::make_unique<dawn::native::Instance>(&instance_descriptor);
+}
+
+wgpu::Device create_device(dawn::native::Adapter& adapter) {
+  // Feature toggles
+  wgpu::DawnTogglesDescriptor feature_toggles{};
+  std::vector<const char*> enabled_toggles;
+
+  // Prevents accidental use of SPIR-V, since that isn't supported in
+  //  web targets, allegedly because Apple is a piece of shit company that
+  //  doesn't give a flying fuck about graphics developers.
+  enabled_toggles.push_back("disallow_spirv");
+
+#ifdef IGGPU_GRAPHICS_DEBUGGING
+  enabled_toggles.push_back("emit_hlsl_debug_symbols");
+  enabled_toggles.push_back("disable_symbol_renaming");
+#endif
+
+  feature_toggles.enabledToggleCount = enabled_toggles.size();
+  feature_toggles.enabledToggles = &enabled_toggles[0];
+
+  // Optional features (used by iggpu subsystems if present)
+  std::vector<wgpu::FeatureName> required_features;
+  wgpu::Adapter wgpu_adapter(adapter.Get());
+  if (wgpu_adapter.HasFeature(wgpu::FeatureName::TimestampQuery)) {
+    required_features.push_back(wgpu::FeatureName::TimestampQuery);
+  }
+
+  // Lets the device be used from several threads at once (see
+  //  iggpu::ParallelEncoder)
+  if (wgpu_adapter.HasFeature(
+          wgpu::FeatureName::ImplicitDeviceSynchronization)) {
+    required_features.push_back(
+        wgpu::FeatureName::ImplicitDeviceSynchronization);
+  }
+
+  wgpu::DeviceDescriptor device_desc = {};
+  device_desc.nextInChain =
+      reinterpret_cast<wgpu::ChainedStruct*>(&feature_toggles);
+  device_desc.requiredFeatureCount = required_features.size();
+  device_desc.requiredFeatures = required_features.data();
+  device_desc.deviceLostCallbackInfo.mode =
+      wgpu::CallbackMode::AllowSpontaneous;
+  device_desc.deviceLostCallbackInfo.callback = ::device_lost_callback;
+  device_desc.deviceLostCallbackInfo.userdata = nullptr;
+
+  device_desc.uncapturedErrorCallbackInfo.callback = ::print_wgpu_device_error;
+  device_desc.uncapturedErrorCallbackInfo.userdata = nullptr;
+
+  WGPUDevice raw_device = adapter.CreateDevice(&device_desc);
+  if (!raw_device) {
+    return nullptr;
+  }
+
+  wgpu::Device device = wgpu::Device::Acquire(raw_device);
+  device.SetLoggingCallback(::device_log_callback, nullptr);
+  return device;
+}
+
+// Picks a window size that fits on the primary monitor, if none was given
+void pick_window_size(uint32_t& width, uint32_t& height) {
+  if (width != 0u && height != 0u) {
+    return;
+  }
+
+  int i_width = 0, i_height = 0;
+  auto primary_monitor = glfwGetPrimaryMonitor();
+  glfwGetMonitorWorkarea(primary_monitor, nullptr, nullptr, &i_width,
+                         &i_height);
+
+  if (i_width > 1980 && i_height >= 1080) {
+    width = 1980u;
+    height = 1080u;
+  } else if (i_width >= 1280 && i_height >= 720) {
+    width = 1280u;
+    height = 720u;
+  } else if (i_width >= 640 && i_height >= 480) {
+    width = 640u;
+    height = 480u;
+  } else {
+    width = 320u;
+    height = 200u;
+  }
+}
+
+// Sleeps until input arrives or timeout_s passes
+void wait_for_events(GLFWwindow* window, double timeout_s) {
+  if (window) {
+    glfwWaitEventsTimeout(timeout_s);
+  } else {
+    std::this_thread::sleep_for(std::chrono::duration<double>(timeout_s));
+  }
+}
+
+// Number of offscreen textures that stand in for the surface swap chain in
+//  headless apps - enough that the CPU can record frame N+2 while frame N is
+//  still in use by the GPU.
+const uint32_t kOffscreenTargetCount = 3u;
+
 // Later: Return the adapter's preferred format (see TODO(dawn:1362))
 wgpu::TextureFormat kDefaultPreferredTextureFormat =
     wgpu::TextureFormat::BGRA8Unorm;
@@ -134,7 +329,8 @@ namespace iggpu {
 AppBase::AppBase(GLFWwindow* window, wgpu::Device device, wgpu::Adapter adapter,
                  wgpu::Surface surface, wgpu::TextureFormat surface_format,
                  wgpu::Queue queue, uint32_t width, uint32_t height)
-    : Window(window),
+    : offscreen_target_index_(0u),
+      Window(window),
       Adapter(adapter),
       Device(device),
       Surface(surface),
@@ -144,6 +340,10 @@ AppBase::AppBase(GLFWwindow* window, wgpu::Device device, wgpu::Adapter adapter,
       Height(height) {}
 
 AppBase::~AppBase() {
+  for (auto& texture : offscreen_targets_) {
+    iggpu::destroy_texture(texture);
+  }
+
   if (Window != nullptr) {
     glfwDestroyWindow(Window);
     Window = nullptr;
@@ -152,34 +352,136 @@ AppBase::~AppBase() {
   glfwTerminate();
 }
 
+struct AppBase::DeviceSetup {
+  std::unique_ptr<PipelineCache> pipeline_cache;
+  std::unique_ptr<dawn::platform::Platform> platform;
+  std::unique_ptr<dawn::native::Instance> instance;
+  dawn::native::Adapter adapter;
+  wgpu::Device device;
+};
+
+AppBase::DeviceSetupRsl AppBase::create_device_setup(
+    const char* pipeline_cache_dir, bool headless,
+    HeadlessAdapterType headless_adapter_type) {
+  auto setup = std::make_unique<DeviceSetup>();
+  if (pipeline_cache_dir != nullptr) {
+    setup->pipeline_cache = std::make_unique<PipelineCache>(pipeline_cache_dir);
+    setup->platform =
+        std::make_unique<::CachingPlatform>(setup->pipeline_cache.get());
+  }
+
+  setup->instance = ::create_instance(setup->platform.get());
+
+  if (headless) {
+    setup->adapter = ::get_headless_adapter(setup->instance.get(),
+                                            headless_adapter_type);
+  } else {
+    wgpu::RequestAdapterOptions options = {};
+    options.powerPreference = wgpu::PowerPreference::HighPerformance;
+    setup->adapter =
+        ::get_adapter(setup->instance->EnumerateAdapters(&options));
+  }
+
+  if (!setup->adapter) {
+    return AppBaseCreateError::WGPUNoSuitableAdapters;
+  }
+
+  if (setup->pipeline_cache) {
+    setup->pipeline_cache->set_adapter_key(
+        ::pipeline_cache_adapter_key(setup->adapter));
+  }
+
+  setup->device = ::create_device(setup->adapter);
+  if (!setup->device) {
+    return AppBaseCreateError::WGPUDeviceCreationFailed;
+  }
+
+  return std::move(setup);
+}
+
+AppBase::AppBaseCreateRsl AppBase::finish_create(
+    std::unique_ptr<DeviceSetup> setup, GLFWwindow* window,
+    wgpu::TextureFormat preferred_format, uint32_t width, uint32_t height) {
+  // Queue (easy)
+  wgpu::Queue queue = setup->device.GetQueue();
+
+  wgpu::Surface surface = nullptr;
+  wgpu::TextureFormat surfaceFormat = preferred_format;
+  std::vector<wgpu::PresentMode> present_modes;
+  std::vector<wgpu::TextureFormat> surface_formats;
+  std::vector<wgpu::CompositeAlphaMode> alpha_modes;
+  if (window != nullptr) {
+    // Surface creation (replaces old swap chain creation flow)
+    surface =
+        wgpu::glfw::CreateSurfaceForWindow(setup->instance->Get(), window);
+    if (!surface) {
+      return AppBaseCreateError::WGPUSurfaceCreateFailed;
+    }
+
+    // Configure the surface
+    wgpu::SurfaceCapabilities surfaceCaps{};
+    surface.GetCapabilities(setup->adapter.Get(), &surfaceCaps);
+
+    surfaceFormat = surfaceCaps.formats[0];
+    for (size_t i = 1; i < surfaceCaps.formatCount; i++) {
+      if (surfaceCaps.formats[i] == preferred_format) {
+        surfaceFormat = surfaceCaps.formats[i];
+      }
+    }
+
+    present_modes.assign(
+        surfaceCaps.presentModes,
+        surfaceCaps.presentModes + surfaceCaps.presentModeCount);
+    surface_formats.assign(surfaceCaps.formats,
+                           surfaceCaps.formats + surfaceCaps.formatCount);
+    alpha_modes.assign(surfaceCaps.alphaModes,
+                       surfaceCaps.alphaModes + surfaceCaps.alphaModeCount);
+  }
+
+  auto rsl = std::make_unique<AppBase>(
+      window, setup->device, wgpu::Adapter(setup->adapter.Get()), surface,
+      surfaceFormat, queue, width, height);
+  rsl->pipeline_cache_ = std::move(setup->pipeline_cache);
+  rsl->platform_ = std::move(setup->platform);
+  rsl->instance_ = std::move(setup->instance);
+  rsl->Instance = wgpu::Instance(rsl->instance_->Get());
+  rsl->supported_present_modes_ = std::move(present_modes);
+  rsl->supported_surface_formats_ = std::move(surface_formats);
+  rsl->supported_alpha_modes_ = std::move(alpha_modes);
+
+  if (window != nullptr) {
+    rsl->configure_surface();
+
+    // Resize events only record the new size - a window drag fires one per
+    //  mouse move, and only the last one matters
+    glfwSetWindowUserPointer(window, rsl->pending_resize_.get());
+    glfwSetFramebufferSizeCallback(
+        window, [](GLFWwindow* resized_window, int width, int height) {
+          auto* pending_resize = static_cast<PendingResize*>(
+              glfwGetWindowUserPointer(resized_window));
+          pending_resize->pending = true;
+          pending_resize->width = static_cast<uint32_t>(width);
+          pending_resize->height = static_cast<uint32_t>(height);
+        });
+  }
+
+  if (window == nullptr && !rsl->create_offscreen_targets(width, height)) {
+    return AppBaseCreateError::WGPUOffscreenTargetCreateFailed;
+  }
+
+  return std::move(rsl);
+}
+
 AppBase::AppBaseCreateRsl AppBase::Create(uint32_t width, uint32_t height,
                                           wgpu::TextureFormat preferred_format,
-                                          const char* window_title) {
+                                          const char* window_title,
+                                          const char* pipeline_cache_dir) {
   glfwSetErrorCallback(::glfw_error);
   if (!glfwInit()) {
     return AppBaseCreateError::GLFWInitError;
   }
 
-  if (width == 0u || height == 0u) {
-    int i_width = 0, i_height = 0;
-    auto primary_monitor = glfwGetPrimaryMonitor();
-    glfwGetMonitorWorkarea(primary_monitor, nullptr, nullptr, &i_width,
-                           &i_height);
-
-    if (i_width > 1980 && i_height >= 1080) {
-      width = 1980u;
-      height = 1080u;
-    } else if (i_width >= 1280 && i_height >= 720) {
-      width = 1280u;
-      height = 720u;
-    } else if (i_width >= 640 && i_height >= 480) {
-      width = 640u;
-      height = 480u;
-    } else {
-      width = 320u;
-      height = 200u;
-    }
-  }
+  ::pick_window_size(width, height);
 
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
   glfwWindowHint(GLFW_COCOA_RETINA_FRAMEBUFFER, GLFW_FALSE);
@@ -189,114 +491,446 @@ AppBase::AppBaseCreateRsl AppBase::Create(uint32_t width, uint32_t height,
     return AppBaseCreateError::WindowCreationError;
   }
 
-  DawnProcTable procs_table = dawn::native::GetProcs();
-  dawnProcSetProcs(&procs_table);
+  auto setup_rsl = create_device_setup(pipeline_cache_dir, false,
+                                       HeadlessAdapterType::Default);
+  if (std::holds_alternative<AppBaseCreateError>(setup_rsl)) {
+    glfwTerminate();
+    return std::get<AppBaseCreateError>(setup_rsl);
+  }
 
-  WGPUInstanceDescriptor instance_descriptor{};
-  instance_descriptor.features.timedWaitAnyEnable = true;
-  auto instance =
-      std::make_unique<dawn::native::Instance>(&instance_descriptor);
+  auto rsl = finish_create(
+      std::move(std::get<std::unique_ptr<DeviceSetup>>(setup_rsl)), window,
+      preferred_format, width, height);
+  if (std::holds_alternative<AppBaseCreateError>(rsl)) {
+    glfwTerminate();
+  }
+  return rsl;
+}
 
-  wgpu::RequestAdapterOptions options = {};
-  options.powerPreference = wgpu::PowerPreference::HighPerformance;
-  auto adapters = instance->EnumerateAdapters(&options);
+AppBase::AppBaseCreatePromise AppBase::CreateAsync(
+    std::shared_ptr<igasync::ExecutionContext> main_thread_tasks,
+    uint32_t width, uint32_t height, wgpu::TextureFormat preferred_format,
+    const char* window_title, const char* pipeline_cache_dir) {
+  using promise_t = std::variant<std::unique_ptr<AppBase>, AppBaseCreateError>;
+  auto result_promise = igasync::Promise<promise_t>::Create();
 
-  auto adapter = ::get_adapter(adapters);
-  if (!adapter) {
-    glfwTerminate();
-    return AppBaseCreateError::WGPUNoSuitableAdapters;
+  glfwSetErrorCallback(::glfw_error);
+  if (!glfwInit()) {
+    result_promise->resolve(AppBaseCreateError::GLFWInitError);
+    return result_promise;
   }
 
-  // Feature toggles
-  wgpu::DawnTogglesDescriptor feature_toggles{};
-  std::vector<const char*> enabled_toggles;
+  // Joins the device setup worker if finish_task is dropped without running
+  struct AsyncCreateState {
+    GLFWwindow* window = nullptr;
+    bool window_failed = false;
+    std::thread worker;
+    DeviceSetupRsl setup_rsl = AppBaseCreateError::WGPUDeviceCreationFailed;
 
-  // Prevents accidental use of SPIR-V, since that isn't supported in
-  //  web targets, allegedly because Apple is a piece of shit company that
-  //  doesn't give a flying fuck about graphics developers.
-  enabled_toggles.push_back("disallow_spirv");
+    ~AsyncCreateState() {
+      if (worker.joinable()) {
+        worker.join();
+      }
+    }
+  };
+  auto state = std::make_shared<AsyncCreateState>();
+
+  // Adapter enumeration and device creation never touch GLFW, so they run on
+  //  a worker thread while the window is created on this one. Surface
+  //  creation needs both, and is scheduled back onto main_thread_tasks.
+  std::optional<std::string> cache_dir;
+  if (pipeline_cache_dir != nullptr) {
+    cache_dir = pipeline_cache_dir;
+  }
 
-#ifdef IGGPU_GRAPHICS_DEBUGGING
-  enabled_toggles.push_back("emit_hlsl_debug_symbols");
-  enabled_toggles.push_back("disable_symbol_renaming");
-#endif
+  ::pick_window_size(width, height);
 
-  feature_toggles.enabledToggleCount = enabled_toggles.size();
-  feature_toggles.enabledToggles = &enabled_toggles[0];
+  auto finish_task = igasync::Task::Of([state, result_promise,
+                                        preferred_format, width, height]() {
+    state->worker.join();
+    if (state->window_failed) {
+      // Already resolved with WindowCreationError
+      return;
+    }
 
-  wgpu::DeviceDescriptor device_desc = {};
-  device_desc.nextInChain =
-      reinterpret_cast<wgpu::ChainedStruct*>(&feature_toggles);
-  device_desc.deviceLostCallbackInfo.mode =
-      wgpu::CallbackMode::AllowSpontaneous;
-  device_desc.deviceLostCallbackInfo.callback = ::device_lost_callback;
-  device_desc.deviceLostCallbackInfo.userdata = nullptr;
+    if (std::holds_alternative<AppBaseCreateError>(state->setup_rsl)) {
+      glfwTerminate();
+      result_promise->resolve(std::get<AppBaseCreateError>(state->setup_rsl));
+      return;
+    }
 
-  device_desc.uncapturedErrorCallbackInfo.callback = ::print_wgpu_device_error;
-  device_desc.uncapturedErrorCallbackInfo.userdata = nullptr;
+    auto rsl = finish_create(
+        std::move(std::get<std::unique_ptr<DeviceSetup>>(state->setup_rsl)),
+        state->window, preferred_format, width, height);
+    if (std::holds_alternative<AppBaseCreateError>(rsl)) {
+      glfwTerminate();
+    }
+    result_promise->resolve(std::move(rsl));
+  });
+
+  // The worker only holds state through finish_task, which it hands over to
+  //  main_thread_tasks - so state is never released (and the worker never
+  //  joined) from the worker itself
+  AsyncCreateState* raw_state = state.get();
+  state->worker =
+      std::thread([raw_state, main_thread_tasks, cache_dir,
+                   finish_task = std::move(finish_task)]() mutable {
+        raw_state->setup_rsl = create_device_setup(
+            cache_dir ? cache_dir->c_str() : nullptr, false,
+            HeadlessAdapterType::Default);
+        main_thread_tasks->schedule(std::move(finish_task));
+      });
 
-  WGPUDevice raw_device = adapter.CreateDevice(&device_desc);
-  if (!raw_device) {
+  glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+  glfwWindowHint(GLFW_COCOA_RETINA_FRAMEBUFFER, GLFW_FALSE);
+  state->window =
+      glfwCreateWindow(width, height, window_title, nullptr, nullptr);
+  if (!state->window) {
+    state->window_failed = true;
     glfwTerminate();
-    return AppBaseCreateError::WGPUDeviceCreationFailed;
+    result_promise->resolve(AppBaseCreateError::WindowCreationError);
   }
 
-  wgpu::Device device = wgpu::Device::Acquire(raw_device);
-  device.SetLoggingCallback(::device_log_callback, nullptr);
-
-  // Queue (easy)
-  wgpu::Queue queue = device.GetQueue();
+  return result_promise;
+}
 
-  // Surface creation (replaces old swap chain creation flow)
-  wgpu::Surface surface =
-      wgpu::glfw::CreateSurfaceForWindow(instance->Get(), window);
-  if (!surface) {
-    glfwTerminate();
-    return AppBaseCreateError::WGPUSurfaceCreateFailed;
+AppBase::AppBaseCreateRsl AppBase::CreateHeadless(
+    uint32_t width, uint32_t height, wgpu::TextureFormat format,
+    HeadlessAdapterType adapter_type, const char* pipeline_cache_dir) {
+  auto setup_rsl = create_device_setup(pipeline_cache_dir, true, adapter_type);
+  if (std::holds_alternative<AppBaseCreateError>(setup_rsl)) {
+    return std::get<AppBaseCreateError>(setup_rsl);
   }
 
-  // Configure the surface
-  wgpu::SurfaceCapabilities surfaceCaps{};
-  surface.GetCapabilities(adapter.Get(), &surfaceCaps);
+  return finish_create(
+      std::move(std::get<std::unique_ptr<DeviceSetup>>(setup_rsl)), nullptr,
+      format, width, height);
+}
 
-  wgpu::TextureFormat surfaceFormat = surfaceCaps.formats[0];
-  for (size_t i = 1; i < surfaceCaps.formatCount; i++) {
-    if (surfaceCaps.formats[i] == preferred_format) {
-      surfaceFormat = surfaceCaps.formats[i];
+bool AppBase::create_offscreen_targets(uint32_t width, uint32_t height) {
+  for (auto& texture : offscreen_targets_) {
+    iggpu::destroy_texture(texture);
+  }
+  offscreen_targets_.clear();
+  offscreen_target_index_ = 0u;
+
+  wgpu::TextureDescriptor td{};
+  td.dimension = wgpu::TextureDimension::e2D;
+  td.size.width = width;
+  td.size.height = height;
+  td.size.depthOrArrayLayers = 1;
+  td.sampleCount = 1;
+  td.format = SurfaceFormat;
+  td.mipLevelCount = 1;
+  td.usage = wgpu::TextureUsage::RenderAttachment |
+             wgpu::TextureUsage::CopySrc | wgpu::TextureUsage::TextureBinding;
+
+  for (uint32_t i = 0; i < ::kOffscreenTargetCount; i++) {
+    wgpu::Texture texture =
+        iggpu::create_texture(Device, td, "AppBase offscreen targets");
+    if (!texture) {
+      for (auto& created : offscreen_targets_) {
+        iggpu::destroy_texture(created);
+      }
+      offscreen_targets_.clear();
+      return false;
     }
+    offscreen_targets_.push_back(texture);
   }
 
-  wgpu::SurfaceConfiguration surfaceConfig = {};
-  surfaceConfig.device = device;
-  surfaceConfig.format = surfaceFormat;
-  surfaceConfig.width = width;
-  surfaceConfig.height = height;
-  surface.Configure(&surfaceConfig);
-
-  auto rsl = std::make_unique<AppBase>(
-      window, device, wgpu::Adapter::Acquire(adapter.Get()), surface,
-      surfaceFormat, queue, width, height);
-  rsl->instance_ = std::move(instance);
-  return std::move(rsl);
+  return true;
 }
 
 void AppBase::resize_surface(uint32_t width, uint32_t height) {
-  auto surfaceChainedDesc =
-      wgpu::glfw::SetupWindowAndGetSurfaceDescriptor(Window);
+  Width = width;
+  Height = height;
 
-  WGPUSurfaceDescriptor desc = {};
-  desc.nextInChain = reinterpret_cast<WGPUChainedStruct*>(&surfaceChainedDesc);
+  if (is_headless()) {
+    if (!create_offscreen_targets(width, height)) {
+      iggpu::log(iggpu::LogLevel::Error,
+                 "[IGGPU] Failed to recreate offscreen targets on resize");
+    }
+  } else {
+    configure_surface();
+  }
+
+  notify_resize_listeners();
+}
 
-  wgpu::SurfaceCapabilities surfaceCaps{};
-  Surface.GetCapabilities(Adapter.Get(), &surfaceCaps);
+ResizeListener AppBase::add_resize_listener(
+    std::function<void(uint32_t width, uint32_t height)> cb) {
+  uint32_t id = resize_listeners_->next_id++;
+  resize_listeners_->listeners.emplace_back(id, std::move(cb));
+  return ResizeListener(resize_listeners_, id);
+}
+
+void AppBase::notify_resize_listeners() {
+  // Copied - listeners may add or remove listeners
+  auto listeners = resize_listeners_->listeners;
+  for (auto& [id, cb] : listeners) {
+    cb(Width, Height);
+  }
+}
+
+void AppBase::configure_surface() {
   wgpu::SurfaceConfiguration surfaceConfig = {};
   surfaceConfig.device = Device;
   surfaceConfig.format = SurfaceFormat;
-  surfaceConfig.width = width;
-  surfaceConfig.height = height;
+  surfaceConfig.width = Width;
+  surfaceConfig.height = Height;
+  surfaceConfig.presentMode = present_mode_;
   Surface.Configure(&surfaceConfig);
 }
 
+bool AppBase::set_present_mode(wgpu::PresentMode present_mode) {
+  if (is_headless()) {
+    return false;
+  }
+
+  if (std::find(supported_present_modes_.begin(),
+                supported_present_modes_.end(),
+                present_mode) == supported_present_modes_.end()) {
+    IGGPU_LOG_WARNING("[IGGPU] Present mode %u not supported by surface",
+                      static_cast<uint32_t>(present_mode));
+    return false;
+  }
+
+  present_mode_ = present_mode;
+  configure_surface();
+  return true;
+}
+
+bool AppBase::begin_frame() {
+  auto wait_start = std::chrono::steady_clock::now();
+
+  // present() records a work-done future for every frame it ends, and frames
+  //  complete in order - sleep on the oldest until the pacer has room. Each
+  //  wait runs that frame's callback, which is what frees up the slot.
+  while (!frame_pacer_.can_begin_frame() && !frame_done_futures_.empty()) {
+    wait(frame_done_futures_.front());
+    frame_done_futures_.pop_front();
+  }
+
+  apply_pending_resize();
+  iggpu::flush_gpu_error_reports();
+
+  frame_pacer_.begin_frame(std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - wait_start)
+                               .count());
+  return true;
+}
+
+void AppBase::run(RunLoopConfig config, RunLoopCallbacks callbacks) {
+  run_loop_ = std::make_unique<RunLoop>(config, std::move(callbacks));
+  RunLoop& loop = *run_loop_;
+
+  while (!loop.stop_requested() &&
+         (Window == nullptr || !glfwWindowShouldClose(Window))) {
+    process_events();
+
+    // Nothing changed - block until input instead of spinning. The timeout
+    //  keeps GPU callbacks and needs_frame polled.
+    if (!loop.wants_frame() && !has_pending_resize()) {
+      ::wait_for_events(Window, config.idle_wait_s);
+      loop.on_idle();
+      continue;
+    }
+
+    double wait_s = loop.seconds_until_next_frame();
+    if (wait_s > 0.) {
+      ::wait_for_events(Window, wait_s);
+      continue;
+    }
+
+    // Input is polled after waiting for the frame pacer, so the input
+    //  rendered this frame is as fresh as possible
+    begin_frame();
+    if (Window) {
+      glfwPollEvents();
+    }
+    loop.run_frame();
+  }
+
+  run_loop_ = nullptr;
+}
+
+void AppBase::stop_run() {
+  if (run_loop_) {
+    run_loop_->request_stop();
+  }
+}
+
+void AppBase::request_frame() {
+  if (!run_loop_) {
+    return;
+  }
+
+  run_loop_->request_frame();
+  if (Window) {
+    glfwPostEmptyEvent();
+  }
+}
+
+void AppBase::apply_pending_resize() {
+  if (!pending_resize_ || !pending_resize_->pending) {
+    return;
+  }
+
+  // Minimized windows have a 0x0 framebuffer, which can't be configured -
+  //  keep the resize pending until the window is restored
+  if (pending_resize_->width == 0u || pending_resize_->height == 0u) {
+    return;
+  }
+
+  pending_resize_->pending = false;
+  if (pending_resize_->width == Width && pending_resize_->height == Height) {
+    return;
+  }
+
+  resize_surface(pending_resize_->width, pending_resize_->height);
+}
+
+wgpu::Texture AppBase::get_current_texture() {
+  if (is_headless()) {
+    if (offscreen_targets_.empty()) {
+      return nullptr;
+    }
+    return offscreen_targets_[offscreen_target_index_];
+  }
+
+  wgpu::SurfaceTexture surface_texture{};
+  Surface.GetCurrentTexture(&surface_texture);
+  return surface_texture.texture;
+}
+
+void AppBase::present() {
+  if (is_headless()) {
+    if (!offscreen_targets_.empty()) {
+      offscreen_target_index_ =
+          (offscreen_target_index_ + 1u) % offscreen_targets_.size();
+    }
+  } else {
+    Surface.Present();
+  }
+
+  if (auto frame_done = frame_pacer_.end_frame()) {
+    frame_done_futures_.push_back(
+        on_submitted_work_done(std::move(frame_done)));
+  }
+
+  // Drop futures of frames that already finished (a zero timeout only checks,
+  //  and runs their callbacks if so) - they pile up if nothing ever waits
+  while (frame_done_futures_.size() > 1u &&
+         wait(frame_done_futures_.front(), 0u)) {
+    frame_done_futures_.pop_front();
+  }
+}
+
+PipelineCache* AppBase::pipeline_cache() const { return pipeline_cache_.get(); }
+
+bool AppBase::wait(GpuFuture future, uint64_t timeout_ns) {
+  wgpu::FutureWaitInfo wait_info{};
+  wait_info.future = future;
+  return Instance.WaitAny(1u, &wait_info, timeout_ns) ==
+             wgpu::WaitStatus::Success &&
+         wait_info.completed;
+}
+
+int32_t AppBase::wait_any(std::span<const GpuFuture> futures,
+                          uint64_t timeout_ns) {
+  std::vector<wgpu::FutureWaitInfo> wait_infos(futures.size());
+  for (size_t i = 0; i < futures.size(); i++) {
+    wait_infos[i].future = futures[i];
+  }
+
+  wgpu::WaitStatus status =
+      Instance.WaitAny(wait_infos.size(), wait_infos.data(), timeout_ns);
+  if (status != wgpu::WaitStatus::Success) {
+    return -1;
+  }
+
+  for (size_t i = 0; i < wait_infos.size(); i++) {
+    if (wait_infos[i].completed) {
+      return static_cast<int32_t>(i);
+    }
+  }
+  return -1;
+}
+
+GpuFuture AppBase::on_submitted_work_done(std::function<void()> cb) {
+  return Queue.OnSubmittedWorkDone(
+      wgpu::CallbackMode::AllowProcessEvents,
+      [cb = std::move(cb)](wgpu::QueueWorkDoneStatus) { cb(); });
+}
+
+GpuFuture AppBase::map_buffer_async(wgpu::Buffer buffer, wgpu::MapMode mode,
+                                    size_t offset, size_t size,
+                                    std::function<void(bool)> cb) {
+  return buffer.MapAsync(
+      mode, offset, size, wgpu::CallbackMode::AllowProcessEvents,
+      [cb = std::move(cb)](wgpu::MapAsyncStatus status, wgpu::StringView) {
+        cb(status == wgpu::MapAsyncStatus::Success);
+      });
+}
+
+GpuFuture AppBase::create_render_pipeline_async(
+    const wgpu::RenderPipelineDescriptor& desc,
+    std::function<void(wgpu::RenderPipeline)> cb) {
+  return Device.CreateRenderPipelineAsync(
+      &desc, wgpu::CallbackMode::AllowProcessEvents,
+      [cb = std::move(cb)](wgpu::CreatePipelineAsyncStatus status,
+                           wgpu::RenderPipeline pipeline,
+                           wgpu::StringView message) {
+        if (status != wgpu::CreatePipelineAsyncStatus::Success) {
+          std::string_view msg =
+              ::to_string_view(message.data, message.length);
+          IGGPU_LOG_ERROR("[IGGPU] Render pipeline creation failed - %.*s",
+                          static_cast<int>(msg.size()), msg.data());
+          cb(nullptr);
+          return;
+        }
+        cb(std::move(pipeline));
+      });
+}
+
+GpuFuture AppBase::create_compute_pipeline_async(
+    const wgpu::ComputePipelineDescriptor& desc,
+    std::function<void(wgpu::ComputePipeline)> cb) {
+  return Device.CreateComputePipelineAsync(
+      &desc, wgpu::CallbackMode::AllowProcessEvents,
+      [cb = std::move(cb)](wgpu::CreatePipelineAsyncStatus status,
+                           wgpu::ComputePipeline pipeline,
+                           wgpu::StringView message) {
+        if (status != wgpu::CreatePipelineAsyncStatus::Success) {
+          std::string_view msg =
+              ::to_string_view(message.data, message.length);
+          IGGPU_LOG_ERROR("[IGGPU] Compute pipeline creation failed - %.*s",
+                          static_cast<int>(msg.size()), msg.data());
+          cb(nullptr);
+          return;
+        }
+        cb(std::move(pipeline));
+      });
+}
+
+void AppBase::push_error_scope(wgpu::ErrorFilter filter) {
+  Device.PushErrorScope(filter);
+}
+
+void AppBase::pop_error_scope(
+    std::function<void(wgpu::ErrorType, std::string_view)> cb) {
+  Device.PopErrorScope(
+      wgpu::CallbackMode::AllowProcessEvents,
+      [cb = std::move(cb)](wgpu::PopErrorScopeStatus status,
+                           wgpu::ErrorType type, wgpu::StringView message) {
+        if (status != wgpu::PopErrorScopeStatus::Success) {
+          cb(wgpu::ErrorType::NoError, {});
+          return;
+        }
+        cb(type, ::to_string_view(message.data, message.length));
+      });
+}
+
 void AppBase::process_events() {
   dawn::native::InstanceProcessEvents(instance_->Get());
 }
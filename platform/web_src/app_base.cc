@@ -1,8 +1,11 @@
 #include <iggpu/app_base.h>
+#include <iggpu/gpu_errors.h>
+#include <iggpu/gpu_memory.h>
 #include <iggpu/log.h>
 
-#include <cstdio>
-#include <sstream>
+#include <algorithm>
+#include <string_view>
+#include <vector>
 
 /**
  * Make sure Emscripten is up to date enough to support WebGPU
@@ -18,10 +21,12 @@
 
 namespace {
 
+// AppBase whose resize handler is installed on the window, if any - only
+//  that AppBase clears it again
+void* gInstalledResizeTarget = nullptr;
+
 void glfw_error(int code, const char* msg) {
-  char buff[256];
-  std::sprintf(buff, "[IGGPU] GLFW error %d: %s", code, msg);
-  iggpu::log(iggpu::LogLevel::Error, buff);
+  IGGPU_LOG_ERROR("[IGGPU] GLFW error %d: %s", code, msg);
 }
 
 wgpu::TextureFormat kDefaultPreferredTextureFormat =
@@ -44,6 +49,17 @@ AppBase::AppBase(GLFWwindow* window, wgpu::Device device, wgpu::Adapter adapter,
       Height(height) {}
 
 AppBase::~AppBase() {
+  if (run_loop_) {
+    emscripten_cancel_main_loop();
+  }
+
+  // Another AppBase may have replaced the handler since - leave that one
+  if (pending_resize_ && ::gInstalledResizeTarget == pending_resize_.get()) {
+    emscripten_set_resize_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, nullptr,
+                                   false, nullptr);
+    ::gInstalledResizeTarget = nullptr;
+  }
+
   if (Window != nullptr) {
     glfwDestroyWindow(Window);
     Window = nullptr;
@@ -105,9 +121,7 @@ AppBase::AppBaseCreateRsl AppBase::Create(std::string canvas_name,
             reinterpret_cast<RequestAdapterUserData*>(user_data);
 
         if (msg) {
-          std::stringstream ss;
-          ss << "[iggpu] Request adapter message: " << msg << std::endl;
-          iggpu::log(LogLevel::Warning, ss.str());
+          IGGPU_LOG_WARNING("[iggpu] Request adapter message: %s", msg);
         }
 
         if (status == WGPURequestAdapterStatus_Unavailable) {
@@ -147,23 +161,30 @@ AppBase::AppBaseCreateRsl AppBase::Create(std::string canvas_name,
             };
         delete ud;
 
+        // Optional features (used by iggpu subsystems if present)
+        std::vector<wgpu::FeatureName> required_features;
+        if (adapter.HasFeature(wgpu::FeatureName::TimestampQuery)) {
+          required_features.push_back(wgpu::FeatureName::TimestampQuery);
+        }
+
+        wgpu::DeviceDescriptor device_desc = {};
+        device_desc.requiredFeatureCount = required_features.size();
+        device_desc.requiredFeatures = required_features.data();
+
         adapter.RequestDevice(
-            nullptr,
+            &device_desc,
             [](WGPURequestDeviceStatus status, WGPUDevice raw_device,
                const char* msg, void* user_data) -> void {
               RequestDeviceUserData* ud =
                   reinterpret_cast<RequestDeviceUserData*>(user_data);
 
               if (msg) {
-                std::stringstream ss;
-                ss << "[iggpu] Request device message: " << msg << std::endl;
-                iggpu::log(LogLevel::Error, ss.str());
+                IGGPU_LOG_ERROR("[iggpu] Request device message: %s", msg);
               }
 
               if (status != WGPURequestDeviceStatus_Success) {
-                std::stringstream ss;
-                ss << "[iggpu] Failed to request device." << std::endl;
-                iggpu::log(LogLevel::Error, ss.str());
+                iggpu::log(LogLevel::Error,
+                           "[iggpu] Failed to request device.");
                 glfwTerminate();
                 ud->result_promise->resolve(
                     AppBaseCreateError::WGPUDeviceCreationFailed);
@@ -171,6 +192,16 @@ AppBase::AppBaseCreateRsl AppBase::Create(std::string canvas_name,
               }
 
               wgpu::Device device = wgpu::Device::Acquire(raw_device);
+              device.SetUncapturedErrorCallback(
+                  [](WGPUErrorType type, const char* msg, void*) {
+                    iggpu::report_gpu_error(
+                        static_cast<wgpu::ErrorType>(type),
+                        msg ? std::string_view(msg) : std::string_view());
+                    if (type == WGPUErrorType_OutOfMemory) {
+                      iggpu::report_gpu_out_of_memory();
+                    }
+                  },
+                  nullptr);
 
               wgpu::SurfaceDescriptorFromCanvasHTMLSelector canv_desc = {};
               canv_desc.selector = ud->canvas_name.c_str();
@@ -191,18 +222,51 @@ AppBase::AppBaseCreateRsl AppBase::Create(std::string canvas_name,
                 }
               }
 
-              wgpu::SurfaceConfiguration surfaceConfig = {};
-              surfaceConfig.device = device;
-              surfaceConfig.format = surfaceFormat;
-              surfaceConfig.width = ud->width;
-              surfaceConfig.height = ud->height;
-              surface.Configure(&surfaceConfig);
-
               wgpu::Queue queue = device.GetQueue();
 
-              ud->result_promise->resolve(std::make_unique<AppBase>(
+              auto app_base = std::make_unique<AppBase>(
                   ud->window, device, ud->adapter, surface, surfaceFormat,
-                  queue, ud->width, ud->height));
+                  queue, ud->width, ud->height);
+              app_base->supported_present_modes_.assign(
+                  surfaceCaps.presentModes,
+                  surfaceCaps.presentModes + surfaceCaps.presentModeCount);
+              app_base->supported_surface_formats_.assign(
+                  surfaceCaps.formats,
+                  surfaceCaps.formats + surfaceCaps.formatCount);
+              app_base->supported_alpha_modes_.assign(
+                  surfaceCaps.alphaModes,
+                  surfaceCaps.alphaModes + surfaceCaps.alphaModeCount);
+              app_base->configure_surface();
+
+              // Resize events only record the new canvas size - they can
+              //  fire many times per frame while the window is dragged
+              app_base->pending_resize_->canvas_name = ud->canvas_name;
+              ::gInstalledResizeTarget = app_base->pending_resize_.get();
+              emscripten_set_resize_callback(
+                  EMSCRIPTEN_EVENT_TARGET_WINDOW,
+                  app_base->pending_resize_.get(), false,
+                  [](int, const EmscriptenUiEvent*,
+                     void* user_data) -> EM_BOOL {
+                    auto* pending_resize =
+                        reinterpret_cast<PendingResize*>(user_data);
+
+                    double css_width = 0., css_height = 0.;
+                    if (emscripten_get_element_css_size(
+                            pending_resize->canvas_name.c_str(), &css_width,
+                            &css_height) != EMSCRIPTEN_RESULT_SUCCESS) {
+                      return EM_FALSE;
+                    }
+
+                    double dpr = emscripten_get_device_pixel_ratio();
+                    pending_resize->pending = true;
+                    pending_resize->width =
+                        static_cast<uint32_t>(css_width * dpr);
+                    pending_resize->height =
+                        static_cast<uint32_t>(css_height * dpr);
+                    return EM_FALSE;
+                  });
+
+              ud->result_promise->resolve(std::move(app_base));
 
               delete ud;
             },
@@ -214,14 +278,242 @@ AppBase::AppBaseCreateRsl AppBase::Create(std::string canvas_name,
 }
 
 void AppBase::resize_surface(uint32_t width, uint32_t height) {
-  wgpu::SurfaceCapabilities surfaceCaps{};
-  Surface.GetCapabilities(Adapter.Get(), &surfaceCaps);
+  Width = width;
+  Height = height;
+  configure_surface();
+  notify_resize_listeners();
+}
+
+ResizeListener AppBase::add_resize_listener(
+    std::function<void(uint32_t width, uint32_t height)> cb) {
+  uint32_t id = resize_listeners_->next_id++;
+  resize_listeners_->listeners.emplace_back(id, std::move(cb));
+  return ResizeListener(resize_listeners_, id);
+}
+
+void AppBase::notify_resize_listeners() {
+  // Copied - listeners may add or remove listeners
+  auto listeners = resize_listeners_->listeners;
+  for (auto& [id, cb] : listeners) {
+    cb(Width, Height);
+  }
+}
+
+void AppBase::configure_surface() {
+  // A hidden or minimized canvas reports 0x0, which can't be configured
+  if (Width == 0u || Height == 0u) {
+    return;
+  }
+
   wgpu::SurfaceConfiguration surfaceConfig = {};
   surfaceConfig.device = Device;
   surfaceConfig.format = SurfaceFormat;
-  surfaceConfig.width = width;
-  surfaceConfig.height = height;
+  surfaceConfig.width = Width;
+  surfaceConfig.height = Height;
+  surfaceConfig.presentMode = present_mode_;
   Surface.Configure(&surfaceConfig);
 }
 
+bool AppBase::set_present_mode(wgpu::PresentMode present_mode) {
+  if (std::find(supported_present_modes_.begin(),
+                supported_present_modes_.end(),
+                present_mode) == supported_present_modes_.end()) {
+    IGGPU_LOG_WARNING("[IGGPU] Present mode %u not supported by surface",
+                      static_cast<uint32_t>(present_mode));
+    return false;
+  }
+
+  present_mode_ = present_mode;
+  configure_surface();
+  return true;
+}
+
+void AppBase::apply_pending_resize() {
+  if (!pending_resize_ || !pending_resize_->pending) {
+    return;
+  }
+
+  if (pending_resize_->width == 0u || pending_resize_->height == 0u) {
+    return;
+  }
+
+  pending_resize_->pending = false;
+  if (pending_resize_->width == Width && pending_resize_->height == Height) {
+    return;
+  }
+
+  emscripten_set_canvas_element_size(pending_resize_->canvas_name.c_str(),
+                                     pending_resize_->width,
+                                     pending_resize_->height);
+  resize_surface(pending_resize_->width, pending_resize_->height);
+}
+
+bool AppBase::begin_frame() {
+  apply_pending_resize();
+  iggpu::flush_gpu_error_reports();
+
+  // Nothing is visible while the canvas is minimized (a 0x0 resize stays
+  //  pending) - skip the frame rather than render and present into it
+  if (Width == 0u || Height == 0u ||
+      (pending_resize_ && pending_resize_->pending)) {
+    return false;
+  }
+
+  // The browser event loop can't be blocked to wait for the GPU - skip the
+  //  frame instead, and try again on the next animation frame.
+  if (!frame_pacer_.can_begin_frame()) {
+    return false;
+  }
+
+  frame_pacer_.begin_frame(0.0);
+  return true;
+}
+
+void AppBase::run(RunLoopConfig config, RunLoopCallbacks callbacks) {
+  run_loop_ = std::make_unique<RunLoop>(config, std::move(callbacks));
+
+  // Runs once per animation frame - idle and frame-capped ticks return
+  //  without touching the GPU
+  emscripten_set_main_loop_arg(
+      [](void* user_data) {
+        auto* app_base = reinterpret_cast<AppBase*>(user_data);
+        RunLoop& loop = *app_base->run_loop_;
+        if (loop.stop_requested()) {
+          emscripten_cancel_main_loop();
+          app_base->run_loop_ = nullptr;
+          return;
+        }
+
+        if (!loop.wants_frame() && !app_base->has_pending_resize()) {
+          loop.on_idle();
+          return;
+        }
+
+        if (loop.seconds_until_next_frame() > 0. ||
+            !app_base->begin_frame()) {
+          return;
+        }
+
+        loop.run_frame();
+      },
+      this, 0, false);
+}
+
+void AppBase::stop_run() {
+  if (run_loop_) {
+    run_loop_->request_stop();
+  }
+}
+
+void AppBase::request_frame() {
+  if (run_loop_) {
+    run_loop_->request_frame();
+  }
+}
+
+wgpu::Texture AppBase::get_current_texture() {
+  wgpu::SurfaceTexture surface_texture{};
+  Surface.GetCurrentTexture(&surface_texture);
+  return surface_texture.texture;
+}
+
+PipelineCache* AppBase::pipeline_cache() const { return nullptr; }
+
+GpuFuture AppBase::on_submitted_work_done(std::function<void()> cb) {
+  Queue.OnSubmittedWorkDone(
+      [](WGPUQueueWorkDoneStatus, void* user_data) {
+        auto* cb = reinterpret_cast<std::function<void()>*>(user_data);
+        (*cb)();
+        delete cb;
+      },
+      new std::function<void()>(std::move(cb)));
+  return {};
+}
+
+GpuFuture AppBase::map_buffer_async(wgpu::Buffer buffer, wgpu::MapMode mode,
+                                    size_t offset, size_t size,
+                                    std::function<void(bool)> cb) {
+  buffer.MapAsync(
+      mode, offset, size,
+      [](WGPUBufferMapAsyncStatus status, void* user_data) {
+        auto* cb = reinterpret_cast<std::function<void(bool)>*>(user_data);
+        (*cb)(status == WGPUBufferMapAsyncStatus_Success);
+        delete cb;
+      },
+      new std::function<void(bool)>(std::move(cb)));
+  return {};
+}
+
+GpuFuture AppBase::create_render_pipeline_async(
+    const wgpu::RenderPipelineDescriptor& desc,
+    std::function<void(wgpu::RenderPipeline)> cb) {
+  Device.CreateRenderPipelineAsync(
+      &desc,
+      [](WGPUCreatePipelineAsyncStatus status, WGPURenderPipeline pipeline,
+         const char* msg, void* user_data) {
+        auto* cb = reinterpret_cast<std::function<void(wgpu::RenderPipeline)>*>(
+            user_data);
+        if (status != WGPUCreatePipelineAsyncStatus_Success) {
+          IGGPU_LOG_ERROR("[iggpu] Render pipeline creation failed - %s",
+                          msg ? msg : "");
+          (*cb)(nullptr);
+        } else {
+          (*cb)(wgpu::RenderPipeline::Acquire(pipeline));
+        }
+        delete cb;
+      },
+      new std::function<void(wgpu::RenderPipeline)>(std::move(cb)));
+  return {};
+}
+
+GpuFuture AppBase::create_compute_pipeline_async(
+    const wgpu::ComputePipelineDescriptor& desc,
+    std::function<void(wgpu::ComputePipeline)> cb) {
+  Device.CreateComputePipelineAsync(
+      &desc,
+      [](WGPUCreatePipelineAsyncStatus status, WGPUComputePipeline pipeline,
+         const char* msg, void* user_data) {
+        auto* cb =
+            reinterpret_cast<std::function<void(wgpu::ComputePipeline)>*>(
+                user_data);
+        if (status != WGPUCreatePipelineAsyncStatus_Success) {
+          IGGPU_LOG_ERROR("[iggpu] Compute pipeline creation failed - %s",
+                          msg ? msg : "");
+          (*cb)(nullptr);
+        } else {
+          (*cb)(wgpu::ComputePipeline::Acquire(pipeline));
+        }
+        delete cb;
+      },
+      new std::function<void(wgpu::ComputePipeline)>(std::move(cb)));
+  return {};
+}
+
+void AppBase::push_error_scope(wgpu::ErrorFilter filter) {
+  Device.PushErrorScope(filter);
+}
+
+void AppBase::pop_error_scope(
+    std::function<void(wgpu::ErrorType, std::string_view)> cb) {
+  Device.PopErrorScope(
+      [](WGPUErrorType type, const char* msg, void* user_data) {
+        auto* cb = reinterpret_cast<
+            std::function<void(wgpu::ErrorType, std::string_view)>*>(
+            user_data);
+        (*cb)(static_cast<wgpu::ErrorType>(type),
+              msg ? std::string_view(msg) : std::string_view());
+        delete cb;
+      },
+      new std::function<void(wgpu::ErrorType, std::string_view)>(
+          std::move(cb)));
+}
+
+void AppBase::present() {
+  // Browsers present the canvas automatically once control returns to the
+  //  event loop - calling Surface.Present() is not supported on web.
+  if (auto frame_done = frame_pacer_.end_frame()) {
+    on_submitted_work_done(std::move(frame_done));
+  }
+}
+
 }  // namespace iggpu
@@ -0,0 +1,394 @@
+#include "gpu_culling_app.h"
+
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <glm/gtc/matrix_access.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// Print frame timing percentiles every N frames
+const uint32_t kTimingReportInterval = 300u;
+
+// Read back visible counts every N frames when verifying
+const uint32_t kVerifyInterval = 30u;
+
+// The camera stays above every object, so rows further away always peek
+//  over the ones in front - Hi-Z only hides the lower objects behind taller
+//  ones, never most of the field. Fewer visible than this fraction (1/N) of
+//  the frustum count means Hi-Z culled visible objects.
+const uint32_t kHizMinVisibleDivisor = 10u;
+
+const float kSpacing = 3.f;
+
+// Both meshes fit in a sphere of this radius around the origin
+const float kMeshRadius = 1.7320508f;
+
+const char kShaderCode[] = R"(
+struct Object {
+  transform: mat4x4<f32>,
+  bounds: vec4<f32>,
+  draw: u32,
+  pad0: u32,
+  pad1: u32,
+  pad2: u32,
+}
+
+@group(0) @binding(0) var<uniform> view_proj: mat4x4<f32>;
+@group(0) @binding(1) var<storage, read> objects: array<Object>;
+
+struct VertexOut {
+  @builtin(position) position: vec4<f32>,
+  @location(0) color: vec3<f32>,
+}
+
+@vertex
+fn vs_main(@location(0) pos: vec3<f32>,
+           @location(1) object_index: u32) -> VertexOut {
+  let object = objects[object_index];
+  let hue = f32(object_index % 7u) / 7.0;
+  let light = 0.6 + 0.2 * pos.y + 0.1 * pos.x;
+
+  var out: VertexOut;
+  out.position = view_proj * object.transform * vec4<f32>(pos, 1.0);
+  out.color = vec3<f32>(0.3 + 0.6 * hue, 0.5, 0.9 - 0.6 * hue) * light;
+  return out;
+}
+
+@fragment
+fn fs_main(in: VertexOut) -> @location(0) vec4<f32> {
+  return vec4<f32>(in.color, 1.0);
+}
+)";
+
+// Cube (vertices 0-7) and square pyramid (vertices 8-12)
+const float kVertices[] = {
+    -1.f, -1.f, -1.f,  //
+    1.f,  -1.f, -1.f,  //
+    1.f,  1.f,  -1.f,  //
+    -1.f, 1.f,  -1.f,  //
+    -1.f, -1.f, 1.f,   //
+    1.f,  -1.f, 1.f,   //
+    1.f,  1.f,  1.f,   //
+    -1.f, 1.f,  1.f,   //
+    -1.f, -1.f, -1.f,  //
+    1.f,  -1.f, -1.f,  //
+    1.f,  -1.f, 1.f,   //
+    -1.f, -1.f, 1.f,   //
+    0.f,  1.f,  0.f,
+};
+const uint16_t kCubeIndices[] = {
+    0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+    3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5,
+};
+const uint16_t kPyramidIndices[] = {
+    0, 2, 1, 0, 3, 2, 0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4,
+};
+
+const uint32_t kCubeIndexCount = 36u;
+const uint32_t kPyramidIndexCount = 18u;
+const int32_t kPyramidBaseVertex = 8;
+
+// Same test as the culling shader, written separately as a reference
+bool sphere_in_frustum(const glm::mat4& view_proj, glm::vec3 center,
+                       float radius) {
+  glm::vec4 r0 = glm::row(view_proj, 0);
+  glm::vec4 r1 = glm::row(view_proj, 1);
+  glm::vec4 r2 = glm::row(view_proj, 2);
+  glm::vec4 r3 = glm::row(view_proj, 3);
+  glm::vec4 planes[6] = {r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2};
+  for (const glm::vec4& plane : planes) {
+    float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+    if (distance < -radius * glm::length(glm::vec3(plane))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace iggpu::sample {
+
+GpuCullingApp::~GpuCullingApp() {
+  iggpu::destroy_buffer(vertex_buffer_);
+  iggpu::destroy_buffer(index_buffer_);
+  iggpu::destroy_buffer(camera_buffer_);
+}
+
+bool GpuCullingApp::load_app() {
+  wgpu::Device device = app_base_->Device;
+
+  GpuCullerDesc culler_desc{};
+  culler_desc.max_objects = instance_count_;
+  culler_desc.hiz = hiz_;
+  culler_ = std::make_unique<GpuCuller>(app_base_, culler_desc);
+
+  // Objects alternate between the two meshes
+  uint32_t cube_count = (instance_count_ + 1u) / 2u;
+  uint32_t pyramid_count = instance_count_ / 2u;
+  culler_->add_draw(::kCubeIndexCount, cube_count);
+  culler_->add_draw(::kPyramidIndexCount, pyramid_count, ::kCubeIndexCount,
+                    ::kPyramidBaseVertex);
+
+  uint32_t side = static_cast<uint32_t>(
+      std::ceil(std::sqrt(static_cast<double>(instance_count_))));
+  objects_.resize(instance_count_);
+  for (uint32_t i = 0; i < instance_count_; i++) {
+    float scale = 0.5f + 0.5f * ((i * 2654435761u >> 16) % 100u) / 100.f;
+    float x = (static_cast<float>(i % side) - side * 0.5f) * ::kSpacing;
+    float z = (static_cast<float>(i / side) - side * 0.5f) * ::kSpacing;
+
+    GpuCullObject& object = objects_[i];
+    object = {};
+    object.transform[0] = scale;
+    object.transform[5] = scale;
+    object.transform[10] = scale;
+    object.transform[12] = x;
+    object.transform[13] = scale;
+    object.transform[14] = z;
+    object.transform[15] = 1.f;
+    object.bounds[3] = ::kMeshRadius;
+    object.draw = i % 2u;
+  }
+  if (!culler_->set_objects(objects_)) {
+    return false;
+  }
+
+  wgpu::BufferDescriptor bd{};
+  bd.size = sizeof(::kVertices);
+  bd.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
+  vertex_buffer_ = iggpu::create_buffer(device, bd, "gpu_culling sample");
+  app_base_->Queue.WriteBuffer(vertex_buffer_, 0, ::kVertices, bd.size);
+
+  std::vector<uint16_t> indices(std::begin(::kCubeIndices),
+                                std::end(::kCubeIndices));
+  indices.insert(indices.end(), std::begin(::kPyramidIndices),
+                 std::end(::kPyramidIndices));
+  bd.size = indices.size() * sizeof(uint16_t);
+  bd.usage = wgpu::BufferUsage::Index | wgpu::BufferUsage::CopyDst;
+  index_buffer_ = iggpu::create_buffer(device, bd, "gpu_culling sample");
+  app_base_->Queue.WriteBuffer(index_buffer_, 0, indices.data(), bd.size);
+
+  bd.size = sizeof(glm::mat4);
+  bd.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+  camera_buffer_ = iggpu::create_buffer(device, bd, "gpu_culling sample");
+
+  wgpu::ShaderModuleWGSLDescriptor wgslDesc{};
+  wgslDesc.code = ::kShaderCode;
+  wgpu::ShaderModuleDescriptor moduleDesc{};
+  moduleDesc.nextInChain = &wgslDesc;
+  wgpu::ShaderModule module = device.CreateShaderModule(&moduleDesc);
+
+  wgpu::VertexAttribute position_attribute{};
+  position_attribute.format = wgpu::VertexFormat::Float32x3;
+  position_attribute.shaderLocation = 0;
+
+  // Object indices written by the culler - one per instance
+  wgpu::VertexAttribute object_attribute{};
+  object_attribute.format = wgpu::VertexFormat::Uint32;
+  object_attribute.shaderLocation = 1;
+
+  wgpu::VertexBufferLayout buffers[2]{};
+  buffers[0].arrayStride = 3 * sizeof(float);
+  buffers[0].stepMode = wgpu::VertexStepMode::Vertex;
+  buffers[0].attributeCount = 1;
+  buffers[0].attributes = &position_attribute;
+  buffers[1].arrayStride = sizeof(uint32_t);
+  buffers[1].stepMode = wgpu::VertexStepMode::Instance;
+  buffers[1].attributeCount = 1;
+  buffers[1].attributes = &object_attribute;
+
+  wgpu::ColorTargetState colorTargetState{};
+  colorTargetState.format = app_base_->SurfaceFormat;
+
+  wgpu::FragmentState fragmentState{};
+  fragmentState.module = module;
+  fragmentState.entryPoint = "fs_main";
+  fragmentState.targetCount = 1;
+  fragmentState.targets = &colorTargetState;
+
+  wgpu::DepthStencilState dss{};
+  dss.format = wgpu::TextureFormat::Depth32Float;
+  dss.depthWriteEnabled = true;
+  dss.depthCompare = wgpu::CompareFunction::Less;
+
+  wgpu::RenderPipelineDescriptor rpd{};
+  rpd.vertex.module = module;
+  rpd.vertex.entryPoint = "vs_main";
+  rpd.vertex.bufferCount = 2;
+  rpd.vertex.buffers = buffers;
+  rpd.fragment = &fragmentState;
+  rpd.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+  rpd.depthStencil = &dss;
+  pipeline_ = device.CreateRenderPipeline(&rpd);
+  if (!pipeline_) {
+    return false;
+  }
+
+  wgpu::BindGroupEntry entries[2]{};
+  entries[0].binding = 0;
+  entries[0].buffer = camera_buffer_;
+  entries[1].binding = 1;
+  entries[1].buffer = culler_->objects_buffer();
+
+  wgpu::BindGroupDescriptor bgd{};
+  bgd.layout = pipeline_.GetBindGroupLayout(0);
+  bgd.entryCount = 2;
+  bgd.entries = entries;
+  bind_group_ = device.CreateBindGroup(&bgd);
+
+  return static_cast<bool>(bind_group_);
+}
+
+glm::mat4 GpuCullingApp::camera_view_proj(uint32_t frame) const {
+  // Circles the middle of the field just above the objects, looking along
+  //  its path so that near objects hide most of the field behind them
+  float t = frame * 0.005f;
+  glm::vec3 eye(40.f * std::cos(t), 4.f, 40.f * std::sin(t));
+  glm::vec3 forward(-std::sin(t), -0.08f, std::cos(t));
+
+  float aspect = static_cast<float>(app_base_->Width) /
+                 static_cast<float>(std::max(app_base_->Height, 1u));
+  glm::mat4 proj =
+      glm::perspectiveRH_ZO(glm::radians(60.f), aspect, 0.1f, 2000.f);
+  glm::mat4 view =
+      glm::lookAtRH(eye, eye + forward, glm::vec3(0.f, 1.f, 0.f));
+  return proj * view;
+}
+
+uint32_t GpuCullingApp::cpu_visible_count(const glm::mat4& view_proj) const {
+  uint32_t count = 0u;
+  for (const GpuCullObject& object : objects_) {
+    glm::vec3 center(object.transform[12], object.transform[13],
+                     object.transform[14]);
+    if (::sphere_in_frustum(view_proj, center,
+                            object.bounds[3] * object.transform[0])) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void GpuCullingApp::check_visible_counts(ReadbackResult result,
+                                         uint32_t frame, uint32_t expected) {
+  if (!result.success || result.data.size() < 2u * 5u * sizeof(uint32_t)) {
+    iggpu::log(LogLevel::Error,
+               "[IGGPU] gpu_culling sample: visible count readback failed");
+    verify_failures_++;
+    return;
+  }
+
+  uint32_t visible = 0u;
+  for (uint32_t draw = 0; draw < 2u; draw++) {
+    uint32_t count = 0u;
+    std::memcpy(&count,
+                result.data.data() + GpuCuller::instance_count_offset(draw),
+                sizeof(count));
+    visible += count;
+  }
+
+  // Objects right on a frustum plane may go either way between CPU and GPU
+  //  float math. Hi-Z only ever culls more, except on the first frame, which
+  //  has no previous depth to build the pyramid from.
+  uint32_t tolerance = std::max(2u, expected / 10000u);
+  bool ok = std::abs(static_cast<int64_t>(visible) -
+                     static_cast<int64_t>(expected)) <= tolerance;
+  if (hiz_ && frame > 0u) {
+    ok = visible <= expected + tolerance &&
+         visible >= expected / ::kHizMinVisibleDivisor &&
+         (visible > 0u || expected == 0u);
+  }
+  verify_count_++;
+  if (!ok) {
+    verify_failures_++;
+  }
+
+  IGGPU_LOG_INFO(
+      "[IGGPU] Frame %u: %u of %u instances drawn (CPU frustum cull: %u)%s",
+      frame, visible, instance_count_, expected, ok ? "" : " - MISMATCH");
+}
+
+void GpuCullingApp::render() {
+  wgpu::Device device = app_base_->Device;
+
+  frame_timer_.begin_frame();
+
+  wgpu::Texture backbuffer = app_base_->get_current_texture();
+  if (!backbuffer) return;
+
+  // Sampled by the Hi-Z build after the pass
+  RenderTargetDesc depth_desc{};
+  depth_desc.format = wgpu::TextureFormat::Depth32Float;
+  depth_desc.usage = wgpu::TextureUsage::RenderAttachment |
+                     wgpu::TextureUsage::TextureBinding;
+  RenderTarget depth = render_targets_.acquire(depth_desc);
+  if (!depth.texture) return;
+
+  uint32_t frame = frame_count_;
+  glm::mat4 view_proj = camera_view_proj(frame);
+  app_base_->Queue.WriteBuffer(camera_buffer_, 0, &view_proj,
+                               sizeof(view_proj));
+
+  wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+  culler_->cull(encoder, view_proj);
+  {
+    wgpu::RenderPassColorAttachment colorAttachment{};
+    colorAttachment.clearValue = {0.55f, 0.7f, 0.85f, 1.f};
+    colorAttachment.loadOp = wgpu::LoadOp::Clear;
+    colorAttachment.storeOp = wgpu::StoreOp::Store;
+    colorAttachment.view = backbuffer.CreateView();
+
+    wgpu::RenderPassDepthStencilAttachment dsa{};
+    dsa.view = depth.view;
+    dsa.depthClearValue = 1.f;
+    dsa.depthLoadOp = wgpu::LoadOp::Clear;
+    dsa.depthStoreOp = wgpu::StoreOp::Store;
+
+    wgpu::RenderPassDescriptor rpd{};
+    rpd.colorAttachmentCount = 1;
+    rpd.colorAttachments = &colorAttachment;
+    rpd.depthStencilAttachment = &dsa;
+    rpd.timestampWrites = frame_timer_.render_pass_timestamps("objects");
+
+    wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&rpd);
+    pass.SetPipeline(pipeline_);
+    pass.SetBindGroup(0, bind_group_);
+    pass.SetVertexBuffer(0, vertex_buffer_);
+    pass.SetIndexBuffer(index_buffer_, wgpu::IndexFormat::Uint16);
+    culler_->draw(pass, 0u, 1u);
+    culler_->draw(pass, 1u, 1u);
+    pass.End();
+  }
+  culler_->build_hiz(encoder, depth.view, app_base_->Width,
+                     app_base_->Height, view_proj);
+
+  if (verify_ && frame % ::kVerifyInterval == 0u && readback_.can_read()) {
+    uint32_t expected = cpu_visible_count(view_proj);
+    readback_.read_buffer(encoder, culler_->indirect_buffer(), 0u,
+                          2u * 5u * sizeof(uint32_t),
+                          [this, frame, expected](ReadbackResult result) {
+                            check_visible_counts(std::move(result), frame,
+                                                 expected);
+                          });
+  }
+
+  frame_timer_.end_encode(encoder);
+  frame_timer_.submit(encoder.Finish());
+  readback_.on_submitted();
+  render_targets_.end_frame();
+  frame_timer_.present();
+
+  if (++frame_count_ % ::kTimingReportInterval == 0u) {
+    iggpu::log(LogLevel::Info, frame_timer_.summary());
+  }
+}
+
+}  // namespace iggpu::sample
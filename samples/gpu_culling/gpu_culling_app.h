@@ -0,0 +1,82 @@
+#ifndef IGGPU_SAMPLES_GPU_CULLING_APP_H
+#define IGGPU_SAMPLES_GPU_CULLING_APP_H
+
+#include <iggpu/app_base.h>
+#include <iggpu/frame_timer.h>
+#include <iggpu/gpu_culler.h>
+#include <iggpu/readback_manager.h>
+#include <iggpu/render_target_pool.h>
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+namespace iggpu::sample {
+
+// A field of cubes and pyramids, culled on the GPU and drawn with two
+//  DrawIndexedIndirect calls per frame regardless of the instance count.
+//  The camera flies low over the field, so with Hi-Z enabled the lower
+//  objects behind taller ones are also culled as occluded.
+class GpuCullingApp {
+ public:
+  GpuCullingApp(AppBase* app_base, uint32_t instance_count, bool hiz)
+      : app_base_(app_base),
+        instance_count_(instance_count),
+        hiz_(hiz),
+        verify_(false),
+        render_targets_(app_base),
+        frame_timer_(app_base),
+        readback_(app_base),
+        frame_count_(0u),
+        verify_count_(0u),
+        verify_failures_(0u) {}
+  ~GpuCullingApp();
+
+  bool load_app();
+
+  // Renders and presents one frame (after AppBase::begin_frame)
+  void render();
+
+  // Periodically reads back the visible instance counts and compares them
+  //  with a CPU frustum cull of the same objects. With Hi-Z, the count must
+  //  fall between a fixed fraction of the frustum count and the count itself.
+  void set_verify(bool verify) { verify_ = verify; }
+
+  // Blocks until every pending verification readback has been checked
+  void finish_verify() { readback_.wait_for_all(); }
+  uint32_t verify_count() const { return verify_count_; }
+  uint32_t verify_failures() const { return verify_failures_; }
+
+ private:
+  glm::mat4 camera_view_proj(uint32_t frame) const;
+  uint32_t cpu_visible_count(const glm::mat4& view_proj) const;
+  void check_visible_counts(ReadbackResult result, uint32_t frame,
+                            uint32_t expected);
+
+  AppBase* app_base_;
+  uint32_t instance_count_;
+  bool hiz_;
+  bool verify_;
+
+  std::unique_ptr<GpuCuller> culler_;
+  std::vector<GpuCullObject> objects_;
+
+  wgpu::Buffer vertex_buffer_;
+  wgpu::Buffer index_buffer_;
+  wgpu::Buffer camera_buffer_;
+  wgpu::RenderPipeline pipeline_;
+  wgpu::BindGroup bind_group_;
+
+  RenderTargetPool render_targets_;
+  FrameTimer frame_timer_;
+  ReadbackManager readback_;
+  uint32_t frame_count_;
+
+  uint32_t verify_count_;
+  uint32_t verify_failures_;
+};
+
+}  // namespace iggpu::sample
+
+#endif
@@ -0,0 +1,95 @@
+#include <iggpu/log.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <variant>
+
+#include "gpu_culling_app.h"
+
+int main(int argc, char** argv) {
+  // --headless [frame_count]: render without a window (works with only a CPU
+  //  adapter) and exit after frame_count frames
+  // --instances N: objects in the field (default 1000000 - the objects
+  //  buffer takes 96 bytes per object, and must fit in one storage binding)
+  // --hiz: also cull objects occluded in the previous frame's depth buffer
+  // --verify: read back the visible instance counts every 30 frames and
+  //  compare them with a CPU frustum cull (exit code 1 on a mismatch)
+  bool headless = false;
+  int headless_frame_count = 120;
+  uint32_t instance_count = 1000000u;
+  bool hiz = false;
+  bool verify = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--headless") == 0) {
+      headless = true;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        headless_frame_count = std::atoi(argv[++i]);
+      }
+    } else if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+      instance_count = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--hiz") == 0) {
+      hiz = true;
+    } else if (std::strcmp(argv[i], "--verify") == 0) {
+      verify = true;
+    } else {
+      std::cerr << "Unknown argument: " << argv[i] << std::endl;
+      return -1;
+    }
+  }
+  if (instance_count == 0u) {
+    std::cerr << "Instance count must be non-zero" << std::endl;
+    return -1;
+  }
+
+  iggpu::enable_async_logging();
+
+  iggpu::AppBase::AppBaseCreateRsl app_create_rsl =
+      headless ? iggpu::AppBase::CreateHeadless(1280u, 720u)
+               : iggpu::AppBase::Create(0u, 0u,
+                                        wgpu::TextureFormat::BGRA8Unorm,
+                                        "IGGPU GPU Culling");
+  if (std::holds_alternative<iggpu::AppBaseCreateError>(app_create_rsl)) {
+    std::cerr << "Failed to create app: "
+              << iggpu::app_base_create_error_text(
+                     std::get<iggpu::AppBaseCreateError>(app_create_rsl))
+              << std::endl;
+    return -1;
+  }
+
+  std::unique_ptr<iggpu::AppBase> app_base =
+      std::move(std::get<std::unique_ptr<iggpu::AppBase>>(app_create_rsl));
+
+  iggpu::sample::GpuCullingApp app(app_base.get(), instance_count, hiz);
+  if (!app.load_app()) {
+    std::cerr << "Failed to load app - see console for more info" << std::endl;
+    return -1;
+  }
+  app.set_verify(verify);
+
+  if (headless) {
+    for (int i = 0; i < headless_frame_count; i++) {
+      app_base->process_events();
+      app_base->begin_frame();
+      app.render();
+    }
+    app.finish_verify();
+
+    std::cout << "Rendered " << headless_frame_count << " headless frames of "
+              << instance_count << " instances" << std::endl;
+    if (verify) {
+      std::cout << "Verified " << app.verify_count() << " readbacks, "
+                << app.verify_failures() << " mismatches" << std::endl;
+      return app.verify_failures() == 0u && app.verify_count() > 0u ? 0 : 1;
+    }
+    return 0;
+  }
+
+  iggpu::RunLoopCallbacks callbacks{};
+  callbacks.render = [&app](double) { app.render(); };
+  app_base->run(iggpu::RunLoopConfig{}, std::move(callbacks));
+
+  return 0;
+}
@@ -1,9 +1,126 @@
+#include <igasync/task_list.h>
+#include <iggpu/log.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <thread>
+#include <utility>
 
 #include "simple_triangle_app.h"
 
-int main() {
-  auto app_create_rsl = iggpu::AppBase::Create();
+namespace {
+
+bool parse_present_mode(const char* name, wgpu::PresentMode& out) {
+  if (std::strcmp(name, "fifo") == 0) {
+    out = wgpu::PresentMode::Fifo;
+  } else if (std::strcmp(name, "fifo-relaxed") == 0) {
+    out = wgpu::PresentMode::FifoRelaxed;
+  } else if (std::strcmp(name, "mailbox") == 0) {
+    out = wgpu::PresentMode::Mailbox;
+  } else if (std::strcmp(name, "immediate") == 0) {
+    out = wgpu::PresentMode::Immediate;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // --headless [frame_count]: render without a window (e.g. on CI machines
+  //  with only a CPU adapter) and exit after frame_count frames
+  // --capture PATH: with --headless, stream the frames to PATH as Y4M video
+  //  ("-" for stdout, e.g. piped into ffmpeg)
+  // --present-mode fifo|fifo-relaxed|mailbox|immediate
+  // --frames-in-flight N: 0 for no limit
+  // --low-latency: wait for the GPU to go idle before sampling input
+  // --max-fps N: cap the frame rate
+  // --on-demand: only render when something changed (idles at ~0% CPU once
+  //  the triangle is drawn)
+  bool headless = false;
+  int headless_frame_count = 60;
+  bool has_present_mode = false;
+  wgpu::PresentMode present_mode = wgpu::PresentMode::Fifo;
+  int frames_in_flight = -1;
+  bool low_latency = false;
+  double max_fps = 0.;
+  bool on_demand = false;
+  const char* capture_path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--headless") == 0) {
+      headless = true;
+      if (i + 1 < argc && argv[i + 1][0] != '-') {
+        headless_frame_count = std::atoi(argv[++i]);
+      }
+    } else if (std::strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc) {
+      if (!::parse_present_mode(argv[++i], present_mode)) {
+        std::cerr << "Unknown present mode: " << argv[i] << std::endl;
+        return -1;
+      }
+      has_present_mode = true;
+    } else if (std::strcmp(argv[i], "--frames-in-flight") == 0 &&
+               i + 1 < argc) {
+      frames_in_flight = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--low-latency") == 0) {
+      low_latency = true;
+    } else if (std::strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc) {
+      max_fps = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+      capture_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--on-demand") == 0) {
+      on_demand = true;
+    } else {
+      std::cerr << "Unknown argument: " << argv[i] << std::endl;
+      return -1;
+    }
+  }
+
+  // A capture streamed to stdout must not have log lines mixed into it
+  if (capture_path && std::strcmp(capture_path, "-") == 0) {
+    iggpu::set_log_fn([](iggpu::LogLevel, const std::string& msg) {
+      std::fprintf(stderr, "%s", msg.c_str());
+    });
+  }
+
+  // Dawn can log in bursts (e.g. one validation message per bad draw call) -
+  //  keep stdio writes off the render thread
+  iggpu::enable_async_logging();
+
+  // Compiled shaders and pipelines are cached here, so the second launch
+  //  skips backend shader compilation
+  const char* kPipelineCacheDir = "iggpu_pipeline_cache";
+
+  // Windowed apps are created asynchronously, the same way as on web - the
+  //  adapter and device are created on a worker thread while the window is
+  //  created here. Anything else this app needed to load could also go here.
+  iggpu::AppBase::AppBaseCreateRsl app_create_rsl;
+  if (headless) {
+    app_create_rsl = iggpu::AppBase::CreateHeadless(
+        1280u, 720u, wgpu::TextureFormat::BGRA8Unorm,
+        iggpu::HeadlessAdapterType::CPU, kPipelineCacheDir);
+  } else {
+    auto main_thread_tasks = igasync::TaskList::Create();
+    bool app_created = false;
+    iggpu::AppBase::CreateAsync(main_thread_tasks, 0u, 0u,
+                                wgpu::TextureFormat::BGRA8Unorm, "IGGPU App",
+                                kPipelineCacheDir)
+        ->consume(
+            [&](auto rsl) {
+              app_create_rsl = std::move(rsl);
+              app_created = true;
+            },
+            main_thread_tasks);
+
+    while (!app_created) {
+      if (!main_thread_tasks->execute_next()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
 
   if (std::holds_alternative<iggpu::AppBaseCreateError>(app_create_rsl)) {
     std::cerr << "Failed to create app: "
@@ -16,22 +133,70 @@ int main() {
   std::unique_ptr<iggpu::AppBase> app_base =
       std::move(std::get<std::unique_ptr<iggpu::AppBase>>(app_create_rsl));
 
+  if (has_present_mode && !app_base->set_present_mode(present_mode)) {
+    std::cerr << "Requested present mode is unsupported, using fifo"
+              << std::endl;
+  }
+  if (frames_in_flight >= 0) {
+    app_base->frame_pacer().set_max_frames_in_flight(frames_in_flight);
+  }
+  app_base->frame_pacer().set_low_latency_mode(low_latency);
+
   iggpu::sample::SimpleTriangleApp app(app_base.get());
   if (!app.load_app()) {
     std::cerr << "Failed to load app - see console for more info" << std::endl;
     return -1;
   }
 
+  if (headless) {
+    std::unique_ptr<iggpu::FrameCapture> frame_capture;
+    if (capture_path) {
+      iggpu::FrameCaptureDesc capture_desc{};
+      capture_desc.path = capture_path;
+      auto capture_rsl =
+          iggpu::FrameCapture::Create(app_base.get(), capture_desc);
+      if (std::holds_alternative<iggpu::FrameCaptureError>(capture_rsl)) {
+        std::cerr << "Failed to start frame capture: "
+                  << iggpu::frame_capture_error_text(
+                         std::get<iggpu::FrameCaptureError>(capture_rsl))
+                  << std::endl;
+        return -1;
+      }
+      frame_capture = std::move(
+          std::get<std::unique_ptr<iggpu::FrameCapture>>(capture_rsl));
+      app.set_frame_capture(frame_capture.get());
+    }
+
+    for (int i = 0; i < headless_frame_count; i++) {
+      app_base->process_events();
+      app_base->begin_frame();
+      app.render();
+    }
+
+    // Writes out the last frames, which may still be in flight
+    app.set_frame_capture(nullptr);
+    frame_capture = nullptr;
+
+    // Keep stdout clean when the capture is streamed there
+    (capture_path ? std::cerr : std::cout)
+        << "Rendered " << headless_frame_count << " headless frames"
+        << std::endl;
+    return 0;
+  }
+
   std::cout << "Successfully loaded app - a triangle should be rendering now"
             << std::endl;
 
-  while (!glfwWindowShouldClose(app_base->Window)) {
-    app_base->process_events();
-    app.render();
-    app_base->Surface.Present();
+  iggpu::RunLoopConfig run_config{};
+  run_config.max_fps = max_fps;
 
-    glfwPollEvents();
+  iggpu::RunLoopCallbacks callbacks{};
+  callbacks.render = [&app](double) { app.render(); };
+  if (on_demand) {
+    callbacks.needs_frame = [&app]() { return app.has_pending_work(); };
   }
 
+  app_base->run(run_config, std::move(callbacks));
+
   return 0;
 }
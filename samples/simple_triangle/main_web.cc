@@ -1,15 +1,13 @@
-#include <emscripten.h>
 #include <iggpu/app_base.h>
 
 #include <iostream>
+#include <utility>
 
 #include "simple_triangle_app.h"
 
 std::unique_ptr<iggpu::AppBase> gAppBase;
 std::unique_ptr<iggpu::sample::SimpleTriangleApp> gApp;
 
-void main_loop() { gApp->render(); }
-
 int main(int, char**) {
   iggpu::AppBase::Create("#canvas")->consume([](auto app_create_rsl) {
     if (std::holds_alternative<iggpu::AppBaseCreateError>(app_create_rsl)) {
@@ -29,7 +27,9 @@ int main(int, char**) {
       exit(-1);
     }
 
-    emscripten_set_main_loop(main_loop, 0, 1);
+    iggpu::RunLoopCallbacks callbacks{};
+    callbacks.render = [](double) { gApp->render(); };
+    gAppBase->run(iggpu::RunLoopConfig{}, std::move(callbacks));
 
     std::cout << "Success!" << std::endl;
   });
@@ -1,9 +1,53 @@
 #include "simple_triangle_app.h"
 
+#include <iggpu/log.h>
+
+#include <chrono>
+#include <cstdio>
 #include <sstream>
+#include <string>
 
 namespace {
 
+// Print frame timing percentiles every N frames
+static const uint32_t kTimingReportInterval = 300u;
+
+const char* present_mode_name(wgpu::PresentMode present_mode) {
+  switch (present_mode) {
+    case wgpu::PresentMode::Fifo:
+      return "fifo";
+    case wgpu::PresentMode::FifoRelaxed:
+      return "fifo-relaxed";
+    case wgpu::PresentMode::Mailbox:
+      return "mailbox";
+    case wgpu::PresentMode::Immediate:
+      return "immediate";
+    default:
+      return "unknown";
+  }
+}
+
+// Input-to-GPU-done latency for comparing present mode and frame pacing
+//  configurations (does not include display scanout)
+std::string latency_summary(const iggpu::AppBase& app_base) {
+  const iggpu::FramePacer& pacer = app_base.frame_pacer();
+  iggpu::Percentiles latency = pacer.latency_stats().percentiles();
+  iggpu::Percentiles wait = pacer.wait_stats().percentiles();
+
+  char buff[384];
+  std::snprintf(
+      buff, sizeof(buff),
+      "Frame latency (present=%s, max_in_flight=%u, low_latency=%s):\n"
+      "  %-24s p50=%7.3fms p95=%7.3fms p99=%7.3fms (n=%u)\n"
+      "  %-24s p50=%7.3fms p95=%7.3fms p99=%7.3fms (n=%u)\n",
+      ::present_mode_name(app_base.present_mode()),
+      pacer.max_frames_in_flight(), pacer.low_latency_mode() ? "on" : "off",
+      "input to gpu done", latency.p50, latency.p95, latency.p99,
+      latency.sample_count, "pacing wait", wait.p50, wait.p95, wait.p99,
+      wait.sample_count);
+  return buff;
+}
+
 static const char shaderCode[] = R"SMS(
 @vertex
 fn vs_main(@builtin(vertex_index) idx: u32) -> @builtin(position) vec4<f32> {
@@ -22,6 +66,7 @@ fn fs_main() -> @location(0) vec4<f32> {
 namespace iggpu::sample {
 
 bool SimpleTriangleApp::load_app() {
+  load_start_ = std::chrono::steady_clock::now();
   wgpu::Device device = app_base_->Device;
 
   wgpu::ShaderModule shaderModule{};
@@ -40,7 +85,7 @@ bool SimpleTriangleApp::load_app() {
     pl.bindGroupLayouts = nullptr;
 
     wgpu::ColorTargetState colorTargetState{};
-    colorTargetState.format = wgpu::TextureFormat::BGRA8Unorm;
+    colorTargetState.format = app_base_->SurfaceFormat;
 
     wgpu::FragmentState fragmentState{};
     fragmentState.module = shaderModule;
@@ -61,79 +106,101 @@ bool SimpleTriangleApp::load_app() {
     rpd.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
     rpd.depthStencil = &dss;
 
-    {
-      wgpu::TextureDescriptor td{};
-      td.dimension = wgpu::TextureDimension::e2D;
-      td.size.width = app_base_->Width;
-      td.size.height = app_base_->Height;
-      td.size.depthOrArrayLayers = 1;
-      td.sampleCount = 1;
-      td.format = wgpu::TextureFormat::Depth24PlusStencil8;
-      td.mipLevelCount = 1;
-      td.usage = wgpu::TextureUsage::RenderAttachment;
-      depth_stencil_ = device.CreateTexture(&td);
-      if (!depth_stencil_) {
-        return false;
-      }
-    }
-
-    {
-      depth_stencil_view_ = depth_stencil_.CreateView();
-      if (!depth_stencil_view_) {
-        return false;
-      }
-    }
-
-    render_pipeline_ = device.CreateRenderPipeline(&rpd);
-    if (!render_pipeline_) {
-      return false;
-    }
+    render_pipeline_id_ = pipeline_manager_.request_render_pipeline(rpd);
 
     return true;
   }
 }
 
 void SimpleTriangleApp::render() {
-  if (!render_pipeline_ || !depth_stencil_view_) return;
-
   wgpu::Device device = app_base_->Device;
+  wgpu::RenderPipeline render_pipeline =
+      pipeline_manager_.render_pipeline(render_pipeline_id_);
+
+  if (render_pipeline && !startup_reported_) {
+    startup_reported_ = true;
+    if (auto* pipeline_cache = app_base_->pipeline_cache()) {
+      pipeline_cache->report_startup_time(
+          std::chrono::duration<double, std::milli>(
+              std::chrono::steady_clock::now() - load_start_)
+              .count());
+    }
+  }
 
-  wgpu::SurfaceTexture surfacetexture{};
-  app_base_->Surface.GetCurrentTexture(&surfacetexture);
-  wgpu::TextureView backbufferView = surfacetexture.texture.CreateView();
-
-  wgpu::RenderPassColorAttachment colorAttachment{};
-  colorAttachment.clearValue = {0.f, 0.f, 0.f, 1.f};
-  colorAttachment.loadOp = wgpu::LoadOp::Clear;
-  colorAttachment.storeOp = wgpu::StoreOp::Store;
-  colorAttachment.view = backbufferView;
-
-  wgpu::RenderPassDepthStencilAttachment dsa{};
-  dsa.view = depth_stencil_view_;
-  dsa.depthClearValue = 0;
-  dsa.depthLoadOp = wgpu::LoadOp::Clear;
-  dsa.depthStoreOp = wgpu::StoreOp::Store;
-  dsa.stencilLoadOp = wgpu::LoadOp::Clear;
-  dsa.stencilStoreOp = wgpu::StoreOp::Discard;
-
-  wgpu::RenderPassDescriptor rpd{};
-  rpd.colorAttachmentCount = 1;
-  rpd.colorAttachments = &colorAttachment;
-  rpd.depthStencilAttachment = &dsa;
+  frame_timer_.begin_frame();
+
+  wgpu::Texture backbuffer = app_base_->get_current_texture();
+  if (!backbuffer) return;
+
+  FrameGraph::ResourceHandle backbuffer_handle = frame_graph_.import_texture(
+      "backbuffer", backbuffer, backbuffer.CreateView());
+  FrameGraph::ResourceHandle depth_stencil = FrameGraph::kInvalidResource;
+
+  frame_graph_.add_pass(
+      "triangle",
+      [&](FrameGraph::PassBuilder& builder) {
+        // Surface-sized, so it is recreated automatically after a resize
+        RenderTargetDesc depth_desc{};
+        depth_desc.format = wgpu::TextureFormat::Depth24PlusStencil8;
+        depth_stencil = builder.create("depth_stencil", depth_desc);
+        builder.write(backbuffer_handle);
+      },
+      [&](wgpu::CommandEncoder& encoder,
+          const FrameGraph::Resources& resources) {
+        wgpu::RenderPassColorAttachment colorAttachment{};
+        colorAttachment.clearValue = {0.f, 0.f, 0.f, 1.f};
+        colorAttachment.loadOp = wgpu::LoadOp::Clear;
+        colorAttachment.storeOp = wgpu::StoreOp::Store;
+        colorAttachment.view = resources.view(backbuffer_handle);
+
+        wgpu::RenderPassDepthStencilAttachment dsa{};
+        dsa.view = resources.view(depth_stencil);
+        dsa.depthClearValue = 0;
+        dsa.depthLoadOp = wgpu::LoadOp::Clear;
+        dsa.depthStoreOp = wgpu::StoreOp::Store;
+        dsa.stencilLoadOp = wgpu::LoadOp::Clear;
+        dsa.stencilStoreOp = wgpu::StoreOp::Discard;
+
+        wgpu::RenderPassDescriptor rpd{};
+        rpd.colorAttachmentCount = 1;
+        rpd.colorAttachments = &colorAttachment;
+        rpd.depthStencilAttachment = &dsa;
+        rpd.timestampWrites = frame_timer_.render_pass_timestamps("triangle");
+
+        wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&rpd);
+        if (render_pipeline) {
+          pass.SetPipeline(render_pipeline);
+          pass.Draw(3);
+          drew_pipeline_ = true;
+        }
+        pass.End();
+      });
+
+  if (!frame_graph_.compile()) {
+    frame_graph_.reset();
+    return;
+  }
 
   wgpu::CommandBuffer commands;
   {
     wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
-    {
-      wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&rpd);
-      pass.SetPipeline(render_pipeline_);
-      pass.Draw(3);
-      pass.End();
-    }
+    frame_graph_.execute(encoder);
+    frame_timer_.end_encode(encoder);
     commands = encoder.Finish();
   }
+  frame_graph_.reset();
+
+  frame_timer_.submit(commands);
+  render_targets_.end_frame();
+  if (frame_capture_) {
+    frame_capture_->capture();
+  }
+  frame_timer_.present();
 
-  app_base_->Queue.Submit(1, &commands);
+  if (++frame_count_ % ::kTimingReportInterval == 0u) {
+    iggpu::log(LogLevel::Info, frame_timer_.summary());
+    iggpu::log(LogLevel::Info, ::latency_summary(*app_base_));
+  }
 }
 
 }  // namespace iggpu::sample
\ No newline at end of file
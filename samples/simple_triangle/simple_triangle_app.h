@@ -3,23 +3,62 @@
 
 #include <igasync/promise.h>
 #include <iggpu/app_base.h>
+#include <iggpu/frame_capture.h>
+#include <iggpu/frame_graph.h>
+#include <iggpu/frame_timer.h>
+#include <iggpu/pipeline_manager.h>
+#include <iggpu/render_target_pool.h>
+
+#include <chrono>
 
 namespace iggpu::sample {
 
 class SimpleTriangleApp {
  public:
   SimpleTriangleApp(AppBase* app_base)
-      : app_base_(app_base), render_pipeline_(nullptr) {}
+      : app_base_(app_base),
+        pipeline_manager_(app_base),
+        render_pipeline_id_(0u),
+        startup_reported_(false),
+        drew_pipeline_(false),
+        render_targets_(app_base),
+        frame_graph_(&render_targets_),
+        frame_timer_(app_base),
+        frame_count_(0u),
+        frame_capture_(nullptr) {}
 
   bool load_app();
+
+  // Renders and presents one frame (after AppBase::begin_frame)
   void render();
 
+  // False once the finished triangle has been drawn - nothing animates, so
+  //  later frames would be identical
+  bool has_pending_work() const { return !drew_pipeline_; }
+
+  // Every rendered frame is captured just before it is presented
+  void set_frame_capture(FrameCapture* frame_capture) {
+    frame_capture_ = frame_capture;
+  }
+
  private:
   AppBase* app_base_;
 
-  wgpu::RenderPipeline render_pipeline_;
-  wgpu::Texture depth_stencil_;
-  wgpu::TextureView depth_stencil_view_;
+  // The pipeline is built asynchronously - frames only clear the screen
+  //  until it is ready
+  PipelineManager pipeline_manager_;
+  PipelineManager::PipelineId render_pipeline_id_;
+  std::chrono::steady_clock::time_point load_start_;
+  bool startup_reported_;
+  bool drew_pipeline_;
+
+  RenderTargetPool render_targets_;
+  FrameGraph frame_graph_;
+
+  FrameTimer frame_timer_;
+  uint32_t frame_count_;
+
+  FrameCapture* frame_capture_;
 };
 
 }  // namespace iggpu::sample
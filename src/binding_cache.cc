@@ -0,0 +1,312 @@
+#include <iggpu/binding_cache.h>
+#include <iggpu/gpu_memory.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+// Same scheme as PipelineManager - every field that affects the created
+//  object, in a fixed order, with object handles keyed by identity
+class KeyBuilder {
+ public:
+  template <typename T>
+  void add(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    key_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void add_handle(const void* handle) { add(handle); }
+
+  std::string take() { return std::move(key_); }
+
+ private:
+  std::string key_;
+};
+
+template <typename Map, typename CreateFn>
+auto find_or_create(Map& map, std::string key, uint64_t frame_index,
+                    iggpu::BindingCacheCounters& counters, CreateFn&& create) {
+  auto it = map.find(key);
+  if (it != map.end()) {
+    counters.hits++;
+    it->second.last_used_frame = frame_index;
+    return it->second.object;
+  }
+
+  counters.misses++;
+  auto& entry = map[std::move(key)];
+  create(entry);
+  entry.last_used_frame = frame_index;
+  counters.live = static_cast<uint32_t>(map.size());
+  return entry.object;
+}
+
+template <typename Map, typename Pred>
+void evict_if(Map& map, iggpu::BindingCacheCounters& counters, Pred&& pred) {
+  for (auto it = map.begin(); it != map.end();) {
+    if (pred(it->second)) {
+      it = map.erase(it);
+      counters.evicted++;
+    } else {
+      ++it;
+    }
+  }
+  counters.live = static_cast<uint32_t>(map.size());
+}
+
+}  // namespace
+
+namespace iggpu {
+
+BindingCache::BindingCache(AppBase* app_base, uint32_t max_idle_frames)
+    : app_base_(app_base),
+      max_idle_frames_(max_idle_frames),
+      frame_index_(0u),
+      stats_{},
+      destroyed_(std::make_shared<DestroyedQueue>()),
+      destroyed_listener_id_(0u) {
+  destroyed_listener_id_ = iggpu::add_gpu_resource_destroyed_listener(
+      [queue = destroyed_](const void* handle) {
+        std::lock_guard<std::mutex> l(queue->mutex);
+        queue->handles.push_back(handle);
+        queue->has_pending.store(true, std::memory_order_release);
+      });
+}
+
+BindingCache::~BindingCache() {
+  iggpu::remove_gpu_resource_destroyed_listener(destroyed_listener_id_);
+}
+
+wgpu::BindGroupLayout BindingCache::bind_group_layout(
+    const wgpu::BindGroupLayoutDescriptor& desc) {
+  apply_destroyed();
+
+  bool has_extensions = desc.nextInChain != nullptr;
+  KeyBuilder k;
+  k.add(desc.entryCount);
+  for (size_t i = 0; i < desc.entryCount; i++) {
+    const auto& e = desc.entries[i];
+    has_extensions = has_extensions || e.nextInChain != nullptr;
+    k.add(e.binding);
+    k.add(static_cast<uint32_t>(e.visibility));
+    k.add(static_cast<uint32_t>(e.buffer.type));
+    k.add(e.buffer.hasDynamicOffset);
+    k.add(e.buffer.minBindingSize);
+    k.add(static_cast<uint32_t>(e.sampler.type));
+    k.add(static_cast<uint32_t>(e.texture.sampleType));
+    k.add(static_cast<uint32_t>(e.texture.viewDimension));
+    k.add(e.texture.multisampled);
+    k.add(static_cast<uint32_t>(e.storageTexture.access));
+    k.add(static_cast<uint32_t>(e.storageTexture.format));
+    k.add(static_cast<uint32_t>(e.storageTexture.viewDimension));
+  }
+
+  if (has_extensions) {
+    stats_.bind_group_layouts.uncached++;
+    return app_base_->Device.CreateBindGroupLayout(&desc);
+  }
+
+  return ::find_or_create(
+      layouts_, k.take(), frame_index_, stats_.bind_group_layouts,
+      [&](Entry<wgpu::BindGroupLayout>& entry) {
+        entry.object = app_base_->Device.CreateBindGroupLayout(&desc);
+      });
+}
+
+wgpu::Sampler BindingCache::sampler(const wgpu::SamplerDescriptor& desc) {
+  apply_destroyed();
+
+  if (desc.nextInChain != nullptr) {
+    stats_.samplers.uncached++;
+    return app_base_->Device.CreateSampler(&desc);
+  }
+
+  KeyBuilder k;
+  k.add(static_cast<uint32_t>(desc.addressModeU));
+  k.add(static_cast<uint32_t>(desc.addressModeV));
+  k.add(static_cast<uint32_t>(desc.addressModeW));
+  k.add(static_cast<uint32_t>(desc.magFilter));
+  k.add(static_cast<uint32_t>(desc.minFilter));
+  k.add(static_cast<uint32_t>(desc.mipmapFilter));
+  k.add(desc.lodMinClamp);
+  k.add(desc.lodMaxClamp);
+  k.add(static_cast<uint32_t>(desc.compare));
+  k.add(desc.maxAnisotropy);
+
+  return ::find_or_create(samplers_, k.take(), frame_index_, stats_.samplers,
+                          [&](Entry<wgpu::Sampler>& entry) {
+                            entry.object =
+                                app_base_->Device.CreateSampler(&desc);
+                          });
+}
+
+wgpu::TextureView BindingCache::texture_view(
+    const wgpu::Texture& texture, const wgpu::TextureViewDescriptor* desc) {
+  apply_destroyed();
+
+  if (desc != nullptr && desc->nextInChain != nullptr) {
+    stats_.texture_views.uncached++;
+    return texture.CreateView(desc);
+  }
+
+  KeyBuilder k;
+  k.add_handle(texture.Get());
+  k.add(desc != nullptr);
+  if (desc) {
+    k.add(static_cast<uint32_t>(desc->format));
+    k.add(static_cast<uint32_t>(desc->dimension));
+    k.add(desc->baseMipLevel);
+    k.add(desc->mipLevelCount);
+    k.add(desc->baseArrayLayer);
+    k.add(desc->arrayLayerCount);
+    k.add(static_cast<uint32_t>(desc->aspect));
+  }
+
+  return ::find_or_create(
+      views_, k.take(), frame_index_, stats_.texture_views,
+      [&](Entry<wgpu::TextureView>& entry) {
+        entry.object = texture.CreateView(desc);
+        entry.resources.push_back(texture.Get());
+        view_textures_[entry.object.Get()] = texture.Get();
+      });
+}
+
+wgpu::BindGroup BindingCache::bind_group(
+    const wgpu::BindGroupDescriptor& desc) {
+  apply_destroyed();
+
+  bool has_extensions = desc.nextInChain != nullptr;
+  KeyBuilder k;
+  k.add_handle(desc.layout.Get());
+  k.add(desc.entryCount);
+  for (size_t i = 0; i < desc.entryCount; i++) {
+    const auto& e = desc.entries[i];
+    has_extensions = has_extensions || e.nextInChain != nullptr;
+    k.add(e.binding);
+    k.add_handle(e.buffer.Get());
+    k.add(e.offset);
+    k.add(e.size);
+    k.add_handle(e.sampler.Get());
+    k.add_handle(e.textureView.Get());
+  }
+
+  if (has_extensions) {
+    stats_.bind_groups.uncached++;
+    return app_base_->Device.CreateBindGroup(&desc);
+  }
+
+  return ::find_or_create(
+      bind_groups_, k.take(), frame_index_, stats_.bind_groups,
+      [&](Entry<wgpu::BindGroup>& entry) {
+        entry.object = app_base_->Device.CreateBindGroup(&desc);
+        for (size_t i = 0; i < desc.entryCount; i++) {
+          const auto& e = desc.entries[i];
+          for (const void* handle :
+               {static_cast<const void*>(e.buffer.Get()),
+                static_cast<const void*>(e.sampler.Get()),
+                static_cast<const void*>(e.textureView.Get())}) {
+            if (handle != nullptr) {
+              entry.resources.push_back(handle);
+            }
+          }
+
+          auto texture = view_textures_.find(e.textureView.Get());
+          if (texture != view_textures_.end()) {
+            entry.resources.push_back(texture->second);
+          }
+        }
+      });
+}
+
+void BindingCache::evict_resource(const void* handle) {
+  if (handle == nullptr) {
+    return;
+  }
+
+  std::unordered_set<const void*> handles = {handle};
+
+  // Views of a destroyed texture go too, and so does everything using them
+  for (const auto& [key, entry] : views_) {
+    if (entry.resources.front() == handle) {
+      handles.insert(entry.object.Get());
+    }
+  }
+
+  auto uses_handle = [&handles](const auto& entry) {
+    return std::any_of(
+        entry.resources.begin(), entry.resources.end(),
+        [&handles](const void* r) { return handles.count(r) > 0u; });
+  };
+  ::evict_if(bind_groups_, stats_.bind_groups, uses_handle);
+  ::evict_if(views_, stats_.texture_views, uses_handle);
+
+  for (auto it = view_textures_.begin(); it != view_textures_.end();) {
+    it = handles.count(it->first) > 0u ? view_textures_.erase(it) : ++it;
+  }
+}
+
+void BindingCache::apply_destroyed() {
+  if (!destroyed_->has_pending.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  std::vector<const void*> handles;
+  {
+    std::lock_guard<std::mutex> l(destroyed_->mutex);
+    handles.swap(destroyed_->handles);
+    destroyed_->has_pending.store(false, std::memory_order_relaxed);
+  }
+
+  for (const void* handle : handles) {
+    evict_resource(handle);
+  }
+}
+
+void BindingCache::end_frame() {
+  apply_destroyed();
+  frame_index_++;
+
+  if (max_idle_frames_ == 0u || frame_index_ <= max_idle_frames_) {
+    return;
+  }
+
+  uint64_t oldest_kept_frame = frame_index_ - max_idle_frames_;
+  auto is_idle = [oldest_kept_frame](const auto& entry) {
+    return entry.last_used_frame < oldest_kept_frame;
+  };
+  ::evict_if(bind_groups_, stats_.bind_groups, is_idle);
+  ::evict_if(layouts_, stats_.bind_group_layouts, is_idle);
+  ::evict_if(samplers_, stats_.samplers, is_idle);
+
+  // Bind groups still using an evicted view recorded its texture when they
+  //  were created, so they are still evicted if the texture is destroyed
+  for (auto it = views_.begin(); it != views_.end();) {
+    if (is_idle(it->second)) {
+      view_textures_.erase(it->second.object.Get());
+      it = views_.erase(it);
+      stats_.texture_views.evicted++;
+    } else {
+      ++it;
+    }
+  }
+  stats_.texture_views.live = static_cast<uint32_t>(views_.size());
+}
+
+void BindingCache::clear() {
+  layouts_.clear();
+  samplers_.clear();
+  views_.clear();
+  bind_groups_.clear();
+  view_textures_.clear();
+  stats_.bind_group_layouts.live = 0u;
+  stats_.samplers.live = 0u;
+  stats_.texture_views.live = 0u;
+  stats_.bind_groups.live = 0u;
+}
+
+BindingCacheStats BindingCache::stats() const { return stats_; }
+
+}  // namespace iggpu
@@ -0,0 +1,347 @@
+#include <iggpu/draw_batcher.h>
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+const uint32_t kMaxPipelines = 1u << 16;
+const uint32_t kMaxBindings = 1u << 24;
+const uint32_t kMaxMeshes = 1u << 24;
+
+const uint64_t kIndexedArgsSize = 5u * sizeof(uint32_t);
+const uint64_t kArgsSize = 4u * sizeof(uint32_t);
+
+uint64_t pack_key(uint32_t pipeline, uint32_t bindings, uint32_t mesh) {
+  return (static_cast<uint64_t>(pipeline) << 48) |
+         (static_cast<uint64_t>(bindings) << 24) | mesh;
+}
+
+}  // namespace
+
+namespace iggpu {
+
+size_t DrawBatcher::BindingsHash::operator()(
+    const std::array<const void*, kMaxDrawBindGroups>& h) const {
+  size_t hash = 0u;
+  for (const void* p : h) {
+    hash ^= std::hash<const void*>()(p) + 0x9e3779b9u + (hash << 6) +
+            (hash >> 2);
+  }
+  return hash;
+}
+
+DrawBatcher::DrawBatcher(AppBase* app_base, DrawBatcherDesc desc)
+    : app_base_(app_base),
+      desc_(desc),
+      last_pipeline_(nullptr),
+      last_pipeline_id_(0u),
+      last_bindings_{},
+      last_bindings_id_(0u),
+      instance_capacity_(0u),
+      indirect_capacity_(0u),
+      stats_{} {}
+
+DrawBatcher::~DrawBatcher() {
+  iggpu::destroy_buffer(instance_buffer_);
+  iggpu::destroy_buffer(indirect_buffer_);
+}
+
+uint32_t DrawBatcher::add_mesh(const BatchMesh& mesh) {
+  meshes_.push_back(mesh);
+  return static_cast<uint32_t>(meshes_.size() - 1u);
+}
+
+bool DrawBatcher::add(const DrawItem& item) {
+  if (item.mesh >= meshes_.size() || !item.pipeline) {
+    iggpu::log(LogLevel::Error,
+               "[IGGPU] DrawBatcher items need a pipeline and a mesh from "
+               "add_mesh");
+    return false;
+  }
+  if (item.instance_size % 4u != 0u ||
+      (item.instance_size > 0u && item.instance_data == nullptr)) {
+    iggpu::log(LogLevel::Error,
+               "[IGGPU] DrawBatcher instance data must be a multiple of 4 "
+               "bytes");
+    return false;
+  }
+
+  const void* pipeline = item.pipeline.Get();
+  if (pipeline != last_pipeline_) {
+    auto it = pipeline_ids_.find(pipeline);
+    if (it == pipeline_ids_.end()) {
+      if (pipelines_.size() >= ::kMaxPipelines) {
+        iggpu::log(LogLevel::Error,
+                   "[IGGPU] Too many pipelines in one DrawBatcher frame");
+        return false;
+      }
+      it = pipeline_ids_
+               .emplace(pipeline, static_cast<uint32_t>(pipelines_.size()))
+               .first;
+      pipelines_.push_back({item.pipeline, item.instance_size});
+    }
+    last_pipeline_ = pipeline;
+    last_pipeline_id_ = it->second;
+  }
+  if (pipelines_[last_pipeline_id_].instance_size != item.instance_size) {
+    IGGPU_LOG_ERROR(
+        "[IGGPU] DrawBatcher item has %u bytes of instance data, but its "
+        "pipeline was first used with %u",
+        item.instance_size, pipelines_[last_pipeline_id_].instance_size);
+    return false;
+  }
+
+  std::array<const void*, kMaxDrawBindGroups> bindings;
+  for (uint32_t i = 0; i < kMaxDrawBindGroups; i++) {
+    bindings[i] = item.bind_groups[i].Get();
+  }
+  if (bindings != last_bindings_ || bindings_.empty()) {
+    auto it = binding_ids_.find(bindings);
+    if (it == binding_ids_.end()) {
+      if (bindings_.size() >= ::kMaxBindings) {
+        iggpu::log(LogLevel::Error,
+                   "[IGGPU] Too many bind group combinations in one "
+                   "DrawBatcher frame");
+        return false;
+      }
+      it = binding_ids_
+               .emplace(bindings, static_cast<uint32_t>(bindings_.size()))
+               .first;
+      bindings_.push_back(item.bind_groups);
+    }
+    last_bindings_ = bindings;
+    last_bindings_id_ = it->second;
+  }
+
+  if (item.mesh >= ::kMaxMeshes) {
+    iggpu::log(LogLevel::Error, "[IGGPU] Too many DrawBatcher meshes");
+    return false;
+  }
+
+  Item i{};
+  i.key = ::pack_key(last_pipeline_id_, last_bindings_id_, item.mesh);
+  i.instance_offset = static_cast<uint32_t>(item_data_.size());
+  items_.push_back(i);
+
+  if (item.instance_size > 0u) {
+    const uint8_t* data = static_cast<const uint8_t*>(item.instance_data);
+    item_data_.insert(item_data_.end(), data, data + item.instance_size);
+  }
+  return true;
+}
+
+void DrawBatcher::prepare(UploadRing* upload_ring) {
+  // Ties keep submission order - instance offsets increase with add()
+  auto by_key = [](const Item& a, const Item& b) {
+    return a.key < b.key ||
+           (a.key == b.key && a.instance_offset < b.instance_offset);
+  };
+  if (!std::is_sorted(items_.begin(), items_.end(), by_key)) {
+    std::sort(items_.begin(), items_.end(), by_key);
+  }
+
+  batches_.clear();
+  instance_data_.clear();
+  indirect_args_.clear();
+  instance_data_.reserve(item_data_.size());
+
+  for (const Item& item : items_) {
+    uint32_t pipeline = static_cast<uint32_t>(item.key >> 48);
+    uint32_t bindings = static_cast<uint32_t>(item.key >> 24) & 0xFFFFFFu;
+    uint32_t mesh = static_cast<uint32_t>(item.key) & 0xFFFFFFu;
+
+    if (batches_.empty() || batches_.back().pipeline != pipeline ||
+        batches_.back().bindings != bindings || batches_.back().mesh != mesh) {
+      Batch b{};
+      b.pipeline = pipeline;
+      b.bindings = bindings;
+      b.mesh = mesh;
+      b.instance_count = 0u;
+      b.instance_offset = instance_data_.size();
+      batches_.push_back(b);
+    }
+    batches_.back().instance_count++;
+
+    uint32_t instance_size = pipelines_[pipeline].instance_size;
+    if (instance_size > 0u) {
+      const uint8_t* data = item_data_.data() + item.instance_offset;
+      instance_data_.insert(instance_data_.end(), data, data + instance_size);
+    }
+  }
+
+  if (desc_.indirect) {
+    for (Batch& b : batches_) {
+      const BatchMesh& mesh = meshes_[b.mesh];
+      b.indirect_offset = indirect_args_.size() * sizeof(uint32_t);
+      indirect_args_.push_back(mesh.element_count);
+      indirect_args_.push_back(b.instance_count);
+      indirect_args_.push_back(mesh.first_element);
+      if (mesh.index_buffer) {
+        indirect_args_.push_back(static_cast<uint32_t>(mesh.base_vertex));
+      }
+      indirect_args_.push_back(0u);
+    }
+  }
+
+  if (!instance_data_.empty() &&
+      ensure_buffer(instance_buffer_, instance_capacity_,
+                    instance_data_.size(),
+                    wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst)) {
+    write(instance_buffer_, instance_data_.data(), instance_data_.size(),
+          upload_ring);
+  }
+
+  uint64_t indirect_size = indirect_args_.size() * sizeof(uint32_t);
+  if (indirect_size > 0u &&
+      ensure_buffer(indirect_buffer_, indirect_capacity_, indirect_size,
+                    wgpu::BufferUsage::Indirect | wgpu::BufferUsage::Storage |
+                        wgpu::BufferUsage::CopyDst)) {
+    write(indirect_buffer_, indirect_args_.data(), indirect_size,
+          upload_ring);
+  }
+
+  stats_ = {};
+  stats_.items = static_cast<uint32_t>(items_.size());
+  stats_.batches = static_cast<uint32_t>(batches_.size());
+  stats_.instance_bytes = instance_data_.size();
+  stats_.indirect_bytes = indirect_size;
+  for (size_t i = 0; i < batches_.size(); i++) {
+    const Batch* prev = i > 0u ? &batches_[i - 1u] : nullptr;
+    const Batch& b = batches_[i];
+    if (!prev || prev->pipeline != b.pipeline) {
+      stats_.pipeline_changes++;
+    }
+    for (uint32_t g = 0; g < kMaxDrawBindGroups; g++) {
+      const wgpu::BindGroup& bg = bindings_[b.bindings][g];
+      if (bg && (!prev || bindings_[prev->bindings][g].Get() != bg.Get())) {
+        stats_.bind_group_changes++;
+      }
+    }
+    if (!prev || prev->mesh != b.mesh) {
+      stats_.mesh_changes++;
+    }
+  }
+}
+
+void DrawBatcher::record(wgpu::RenderPassEncoder& pass) const {
+  record_batches(pass);
+}
+
+void DrawBatcher::record(wgpu::RenderBundleEncoder& bundle) const {
+  record_batches(bundle);
+}
+
+template <typename Encoder>
+void DrawBatcher::record_batches(Encoder& encoder) const {
+  const Batch* prev = nullptr;
+  for (const Batch& b : batches_) {
+    const PipelineState& pipeline = pipelines_[b.pipeline];
+    const BatchMesh& mesh = meshes_[b.mesh];
+
+    if (!prev || prev->pipeline != b.pipeline) {
+      encoder.SetPipeline(pipeline.pipeline);
+    }
+    if (!prev || prev->bindings != b.bindings) {
+      for (uint32_t g = 0; g < kMaxDrawBindGroups; g++) {
+        const wgpu::BindGroup& bg = bindings_[b.bindings][g];
+        if (bg && (!prev || bindings_[prev->bindings][g].Get() != bg.Get())) {
+          encoder.SetBindGroup(g, bg);
+        }
+      }
+    }
+    if (!prev || prev->mesh != b.mesh) {
+      // Meshes are often suballocated from shared buffers
+      const BatchMesh* prev_mesh = prev ? &meshes_[prev->mesh] : nullptr;
+      if (mesh.vertex_buffer &&
+          (!prev_mesh ||
+           prev_mesh->vertex_buffer.Get() != mesh.vertex_buffer.Get() ||
+           prev_mesh->vertex_offset != mesh.vertex_offset)) {
+        encoder.SetVertexBuffer(desc_.vertex_slot, mesh.vertex_buffer,
+                                mesh.vertex_offset);
+      }
+      if (mesh.index_buffer &&
+          (!prev_mesh ||
+           prev_mesh->index_buffer.Get() != mesh.index_buffer.Get() ||
+           prev_mesh->index_format != mesh.index_format ||
+           prev_mesh->index_offset != mesh.index_offset)) {
+        encoder.SetIndexBuffer(mesh.index_buffer, mesh.index_format,
+                               mesh.index_offset);
+      }
+    }
+
+    // Rebinding at the batch's offset (rather than drawing with
+    //  firstInstance) keeps indirect draws valid without the
+    //  indirect-first-instance feature
+    if (pipeline.instance_size > 0u) {
+      encoder.SetVertexBuffer(
+          desc_.instance_slot, instance_buffer_, b.instance_offset,
+          static_cast<uint64_t>(b.instance_count) * pipeline.instance_size);
+    }
+
+    if (desc_.indirect) {
+      if (mesh.index_buffer) {
+        encoder.DrawIndexedIndirect(indirect_buffer_, b.indirect_offset);
+      } else {
+        encoder.DrawIndirect(indirect_buffer_, b.indirect_offset);
+      }
+    } else if (mesh.index_buffer) {
+      encoder.DrawIndexed(mesh.element_count, b.instance_count,
+                          mesh.first_element, mesh.base_vertex, 0u);
+    } else {
+      encoder.Draw(mesh.element_count, b.instance_count, mesh.first_element,
+                   0u);
+    }
+    prev = &b;
+  }
+}
+
+void DrawBatcher::clear() {
+  items_.clear();
+  item_data_.clear();
+  batches_.clear();
+  pipelines_.clear();
+  pipeline_ids_.clear();
+  bindings_.clear();
+  binding_ids_.clear();
+  last_pipeline_ = nullptr;
+  last_bindings_ = {};
+}
+
+bool DrawBatcher::ensure_buffer(wgpu::Buffer& buffer, uint64_t& capacity,
+                                uint64_t size, wgpu::BufferUsage usage) {
+  if (buffer && capacity >= size) {
+    return true;
+  }
+
+  // Grow geometrically so that slowly growing scenes don't reallocate every
+  //  frame. Passes recorded earlier (submitted or not) may still use the old
+  //  buffer - drop the reference rather than destroying it, and it is freed
+  //  once that work is done with it.
+  uint64_t new_capacity = std::max<uint64_t>(capacity, 64u * 1024u);
+  while (new_capacity < size) {
+    new_capacity *= 2u;
+  }
+  iggpu::release_buffer(buffer);
+
+  wgpu::BufferDescriptor bd{};
+  bd.size = new_capacity;
+  bd.usage = usage;
+  buffer = iggpu::create_buffer(app_base_->Device, bd, "DrawBatcher");
+  capacity = buffer ? new_capacity : 0u;
+  return static_cast<bool>(buffer);
+}
+
+void DrawBatcher::write(wgpu::Buffer& buffer, const void* data, uint64_t size,
+                        UploadRing* upload_ring) {
+  if (upload_ring) {
+    upload_ring->upload(buffer, 0u, data, size);
+  } else {
+    app_base_->Queue.WriteBuffer(buffer, 0u, data, size);
+  }
+}
+
+}  // namespace iggpu
@@ -0,0 +1,395 @@
+#include <iggpu/frame_capture.h>
+#include <iggpu/log.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
+
+namespace {
+
+struct Rgb {
+  int r;
+  int g;
+  int b;
+};
+
+Rgb read_pixel(const uint8_t* px, bool swap_red_blue) {
+  return swap_red_blue ? Rgb{px[2], px[1], px[0]} : Rgb{px[0], px[1], px[2]};
+}
+
+// BT.601, limited range
+uint8_t luma(const Rgb& c) {
+  return static_cast<uint8_t>(((66 * c.r + 129 * c.g + 25 * c.b + 128) >> 8) +
+                              16);
+}
+
+uint8_t chroma_u(const Rgb& c) {
+  return static_cast<uint8_t>(((-38 * c.r - 74 * c.g + 112 * c.b + 128) >> 8) +
+                              128);
+}
+
+uint8_t chroma_v(const Rgb& c) {
+  return static_cast<uint8_t>(((112 * c.r - 94 * c.g - 18 * c.b + 128) >> 8) +
+                              128);
+}
+
+void convert_rgba(const iggpu::ReadbackResult& frame, bool swap_red_blue,
+                  std::vector<uint8_t>& out) {
+  size_t pixel_count = static_cast<size_t>(frame.width) * frame.height;
+  out.resize(pixel_count * 4u);
+  for (size_t i = 0; i < pixel_count; i++) {
+    const uint8_t* src = frame.data.data() + i * 4u;
+    Rgb c = ::read_pixel(src, swap_red_blue);
+    out[i * 4u + 0u] = static_cast<uint8_t>(c.r);
+    out[i * 4u + 1u] = static_cast<uint8_t>(c.g);
+    out[i * 4u + 2u] = static_cast<uint8_t>(c.b);
+    out[i * 4u + 3u] = src[3];
+  }
+}
+
+void convert_ppm(const iggpu::ReadbackResult& frame, bool swap_red_blue,
+                 std::vector<uint8_t>& out) {
+  char header[64];
+  int header_len = std::snprintf(header, sizeof(header), "P6\n%u %u\n255\n",
+                                 frame.width, frame.height);
+
+  size_t pixel_count = static_cast<size_t>(frame.width) * frame.height;
+  out.assign(header, header + header_len);
+  out.resize(header_len + pixel_count * 3u);
+  uint8_t* dst = out.data() + header_len;
+  for (size_t i = 0; i < pixel_count; i++) {
+    Rgb c = ::read_pixel(frame.data.data() + i * 4u, swap_red_blue);
+    dst[i * 3u + 0u] = static_cast<uint8_t>(c.r);
+    dst[i * 3u + 1u] = static_cast<uint8_t>(c.g);
+    dst[i * 3u + 2u] = static_cast<uint8_t>(c.b);
+  }
+}
+
+// One "FRAME" of 4:2:0 planar YUV - chroma is averaged over 2x2 blocks
+void convert_y4m(const iggpu::ReadbackResult& frame, bool swap_red_blue,
+                 std::vector<uint8_t>& out) {
+  static const char kFrameHeader[] = "FRAME\n";
+  const size_t header_len = sizeof(kFrameHeader) - 1u;
+
+  uint32_t w = frame.width, h = frame.height;
+  uint32_t cw = (w + 1u) / 2u, ch = (h + 1u) / 2u;
+  size_t y_size = static_cast<size_t>(w) * h;
+  size_t c_size = static_cast<size_t>(cw) * ch;
+
+  out.assign(kFrameHeader, kFrameHeader + header_len);
+  out.resize(header_len + y_size + 2u * c_size);
+  uint8_t* y_plane = out.data() + header_len;
+  uint8_t* u_plane = y_plane + y_size;
+  uint8_t* v_plane = u_plane + c_size;
+
+  auto pixel = [&](uint32_t x, uint32_t y) {
+    return ::read_pixel(frame.data.data() + (static_cast<size_t>(y) * w + x) *
+                                                4u,
+                        swap_red_blue);
+  };
+
+  for (uint32_t y = 0; y < h; y++) {
+    for (uint32_t x = 0; x < w; x++) {
+      y_plane[static_cast<size_t>(y) * w + x] = ::luma(pixel(x, y));
+    }
+  }
+
+  for (uint32_t cy = 0; cy < ch; cy++) {
+    for (uint32_t cx = 0; cx < cw; cx++) {
+      Rgb sum{0, 0, 0};
+      int count = 0;
+      for (uint32_t dy = 0; dy < 2u && cy * 2u + dy < h; dy++) {
+        for (uint32_t dx = 0; dx < 2u && cx * 2u + dx < w; dx++) {
+          Rgb c = pixel(cx * 2u + dx, cy * 2u + dy);
+          sum.r += c.r;
+          sum.g += c.g;
+          sum.b += c.b;
+          count++;
+        }
+      }
+      Rgb avg{sum.r / count, sum.g / count, sum.b / count};
+      u_plane[static_cast<size_t>(cy) * cw + cx] = ::chroma_u(avg);
+      v_plane[static_cast<size_t>(cy) * cw + cx] = ::chroma_v(avg);
+    }
+  }
+}
+
+}  // namespace
+
+namespace iggpu {
+
+// Frames read back from the GPU, waiting to be converted and written
+struct FrameCapture::Queue {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<ReadbackResult> frames;
+  bool writing = false;
+  bool stop = false;
+
+  std::FILE* out = nullptr;
+  FrameCaptureFormat format = FrameCaptureFormat::Y4M;
+  uint32_t fps = 30u;
+  bool swap_red_blue = false;
+
+  // Y4M streams have one size - set by the first frame
+  uint32_t stream_width = 0u;
+  uint32_t stream_height = 0u;
+
+  uint64_t frames_written = 0u;
+  uint64_t bytes_written = 0u;
+  uint64_t write_errors = 0u;
+
+  // Writer thread only
+  std::vector<uint8_t> scratch;
+
+#ifndef __EMSCRIPTEN__
+  std::thread writer;
+#endif
+
+  // Returns the number of bytes written, 0 on error. Called without the lock.
+  size_t write(const ReadbackResult& frame) {
+    if (!frame.success || frame.data.size() <
+                              static_cast<size_t>(frame.width) *
+                                  frame.height * 4u) {
+      return 0u;
+    }
+
+    size_t header_bytes = 0u;
+    switch (format) {
+      case FrameCaptureFormat::RawRGBA:
+        ::convert_rgba(frame, swap_red_blue, scratch);
+        break;
+      case FrameCaptureFormat::PPM:
+        ::convert_ppm(frame, swap_red_blue, scratch);
+        break;
+      case FrameCaptureFormat::Y4M:
+        if (stream_width == 0u) {
+          stream_width = frame.width;
+          stream_height = frame.height;
+          char header[128];
+          int len = std::snprintf(header, sizeof(header),
+                                  "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n",
+                                  frame.width, frame.height, fps);
+          if (std::fwrite(header, 1u, len, out) != static_cast<size_t>(len)) {
+            return 0u;
+          }
+          header_bytes = len;
+        } else if (frame.width != stream_width ||
+                   frame.height != stream_height) {
+          // Y4M can't change size mid-stream
+          return 0u;
+        }
+        ::convert_y4m(frame, swap_red_blue, scratch);
+        break;
+    }
+
+    if (std::fwrite(scratch.data(), 1u, scratch.size(), out) !=
+        scratch.size()) {
+      return 0u;
+    }
+    return header_bytes + scratch.size();
+  }
+
+  void write_and_count(const ReadbackResult& frame) {
+    size_t bytes = write(frame);
+
+    std::lock_guard<std::mutex> l(mutex);
+    if (bytes == 0u) {
+      write_errors++;
+    } else {
+      frames_written++;
+      bytes_written += bytes;
+    }
+  }
+
+  void writer_main() {
+    while (true) {
+      ReadbackResult frame;
+      {
+        std::unique_lock<std::mutex> l(mutex);
+        cv.wait(l, [this] { return stop || !frames.empty(); });
+        if (frames.empty()) {
+          break;
+        }
+        frame = std::move(frames.front());
+        frames.pop_front();
+        writing = true;
+      }
+      cv.notify_all();
+
+      write_and_count(frame);
+
+      {
+        std::lock_guard<std::mutex> l(mutex);
+        writing = false;
+      }
+      cv.notify_all();
+    }
+
+    std::fflush(out);
+  }
+};
+
+FrameCapture::CreateRsl FrameCapture::Create(AppBase* app_base,
+                                             FrameCaptureDesc desc) {
+  bool swap_red_blue = false;
+  switch (app_base->SurfaceFormat) {
+    case wgpu::TextureFormat::BGRA8Unorm:
+    case wgpu::TextureFormat::BGRA8UnormSrgb:
+      swap_red_blue = true;
+      break;
+    case wgpu::TextureFormat::RGBA8Unorm:
+    case wgpu::TextureFormat::RGBA8UnormSrgb:
+      break;
+    default:
+      return FrameCaptureError::UnsupportedTargetFormat;
+  }
+
+  std::FILE* out =
+      desc.path == "-" ? stdout : std::fopen(desc.path.c_str(), "wb");
+  if (!out) {
+    return FrameCaptureError::OutputOpenFailed;
+  }
+
+  return std::unique_ptr<FrameCapture>(
+      new FrameCapture(app_base, std::move(desc), out, swap_red_blue));
+}
+
+FrameCapture::FrameCapture(AppBase* app_base, FrameCaptureDesc desc,
+                           std::FILE* out, bool swap_red_blue)
+    : app_base_(app_base),
+      desc_(std::move(desc)),
+      readback_(app_base, desc_.readback_ring_size),
+      frames_captured_(0u),
+      stall_count_(0u),
+      queue_(std::make_unique<Queue>()) {
+  queue_->out = out;
+  queue_->format = desc_.format;
+  queue_->fps = desc_.fps == 0u ? 30u : desc_.fps;
+  queue_->swap_red_blue = swap_red_blue;
+  if (desc_.max_queued_frames == 0u) {
+    desc_.max_queued_frames = 1u;
+  }
+
+#ifndef __EMSCRIPTEN__
+  queue_->writer =
+      std::thread([queue = queue_.get()] { queue->writer_main(); });
+#endif
+}
+
+FrameCapture::~FrameCapture() {
+  flush();
+
+#ifndef __EMSCRIPTEN__
+  {
+    std::lock_guard<std::mutex> l(queue_->mutex);
+    queue_->stop = true;
+  }
+  queue_->cv.notify_all();
+  queue_->writer.join();
+#else
+  std::fflush(queue_->out);
+#endif
+
+  if (queue_->out != stdout) {
+    std::fclose(queue_->out);
+  }
+
+  FrameCaptureStats s = stats();
+  IGGPU_LOG_INFO(
+      "[IGGPU] Frame capture: %llu frames written (%.1f fps, %.1f MB), %llu "
+      "errors, %llu stalls",
+      static_cast<unsigned long long>(s.frames_written), s.write_fps,
+      s.bytes_written / (1024. * 1024.),
+      static_cast<unsigned long long>(s.write_errors),
+      static_cast<unsigned long long>(s.stall_count));
+}
+
+void FrameCapture::capture() {
+  wgpu::Texture texture = app_base_->get_current_texture();
+  if (!texture) {
+    return;
+  }
+
+  if (!readback_.can_read()) {
+    stall_count_++;
+    readback_.wait_for_capacity();
+  }
+
+  wgpu::CommandEncoder encoder = app_base_->Device.CreateCommandEncoder();
+  wgpu::Extent3D extent{};
+  extent.width = texture.GetWidth();
+  extent.height = texture.GetHeight();
+  extent.depthOrArrayLayers = 1u;
+  if (!readback_.read_texture(encoder, texture, wgpu::Origin3D{}, extent,
+                              [this](ReadbackResult result) {
+                                on_frame_read(std::move(result));
+                              })) {
+    // Only on web, where waiting for capacity is impossible
+    return;
+  }
+
+  wgpu::CommandBuffer commands = encoder.Finish();
+  app_base_->Queue.Submit(1, &commands);
+  readback_.on_submitted();
+
+  if (frames_captured_++ == 0u) {
+    start_ = std::chrono::steady_clock::now();
+  }
+}
+
+void FrameCapture::on_frame_read(ReadbackResult result) {
+#ifdef __EMSCRIPTEN__
+  queue_->write_and_count(result);
+#else
+  {
+    std::unique_lock<std::mutex> l(queue_->mutex);
+    if (queue_->frames.size() >= desc_.max_queued_frames) {
+      stall_count_++;
+      queue_->cv.wait(l, [this] {
+        return queue_->frames.size() < desc_.max_queued_frames;
+      });
+    }
+    queue_->frames.push_back(std::move(result));
+  }
+  queue_->cv.notify_all();
+#endif
+}
+
+void FrameCapture::flush() {
+  readback_.wait_for_all();
+
+#ifndef __EMSCRIPTEN__
+  std::unique_lock<std::mutex> l(queue_->mutex);
+  queue_->cv.wait(
+      l, [this] { return queue_->frames.empty() && !queue_->writing; });
+#endif
+}
+
+FrameCaptureStats FrameCapture::stats() const {
+  FrameCaptureStats s{};
+  s.frames_captured = frames_captured_;
+  s.stall_count = stall_count_;
+  {
+    std::lock_guard<std::mutex> l(queue_->mutex);
+    s.frames_written = queue_->frames_written;
+    s.bytes_written = queue_->bytes_written;
+    s.write_errors = queue_->write_errors;
+  }
+
+  if (frames_captured_ > 0u) {
+    double elapsed_s = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+    s.write_fps = elapsed_s > 0. ? s.frames_written / elapsed_s : 0.;
+  }
+  return s;
+}
+
+}  // namespace iggpu
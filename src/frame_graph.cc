@@ -0,0 +1,272 @@
+#include <iggpu/frame_graph.h>
+#include <iggpu/log.h>
+
+#include <algorithm>
+
+namespace {
+
+const uint32_t kUnused = std::numeric_limits<uint32_t>::max();
+
+bool same_desc(const iggpu::RenderTargetDesc& a,
+               const iggpu::RenderTargetDesc& b) {
+  return a.width == b.width && a.height == b.height && a.format == b.format &&
+         a.usage == b.usage && a.sample_count == b.sample_count;
+}
+
+bool contains(const std::vector<uint32_t>& v, uint32_t value) {
+  return std::find(v.begin(), v.end(), value) != v.end();
+}
+
+}  // namespace
+
+namespace iggpu {
+
+FrameGraph::ResourceHandle FrameGraph::PassBuilder::create(
+    std::string name, const RenderTargetDesc& desc) {
+  Resource resource{};
+  resource.name = std::move(name);
+  resource.imported = false;
+  resource.desc = desc;
+  graph_->resources_.push_back(std::move(resource));
+  return write(static_cast<ResourceHandle>(graph_->resources_.size() - 1u));
+}
+
+FrameGraph::ResourceHandle FrameGraph::PassBuilder::read(
+    ResourceHandle resource) {
+  if (resource >= graph_->resources_.size()) {
+    return kInvalidResource;
+  }
+
+  graph_->passes_[pass_idx_].reads.push_back(resource);
+  return resource;
+}
+
+FrameGraph::ResourceHandle FrameGraph::PassBuilder::write(
+    ResourceHandle resource) {
+  if (resource >= graph_->resources_.size()) {
+    return kInvalidResource;
+  }
+
+  graph_->passes_[pass_idx_].writes.push_back(resource);
+  graph_->resources_[resource].writers.push_back(pass_idx_);
+  return resource;
+}
+
+void FrameGraph::PassBuilder::side_effect() {
+  graph_->passes_[pass_idx_].side_effect = true;
+}
+
+wgpu::Texture FrameGraph::Resources::texture(ResourceHandle resource) const {
+  if (resource >= graph_->resources_.size()) {
+    return nullptr;
+  }
+  return graph_->resources_[resource].target.texture;
+}
+
+wgpu::TextureView FrameGraph::Resources::view(ResourceHandle resource) const {
+  if (resource >= graph_->resources_.size()) {
+    return nullptr;
+  }
+  return graph_->resources_[resource].target.view;
+}
+
+FrameGraph::FrameGraph(RenderTargetPool* render_target_pool)
+    : render_target_pool_(render_target_pool), stats_{} {}
+
+FrameGraph::ResourceHandle FrameGraph::import_texture(std::string name,
+                                                      wgpu::Texture texture,
+                                                      wgpu::TextureView view) {
+  Resource resource{};
+  resource.name = std::move(name);
+  resource.imported = true;
+  resource.target.texture = std::move(texture);
+  resource.target.view = std::move(view);
+  resources_.push_back(std::move(resource));
+  return static_cast<ResourceHandle>(resources_.size() - 1u);
+}
+
+void FrameGraph::add_pass(std::string name, const SetupFn& setup,
+                          ExecuteFn execute) {
+  Pass pass{};
+  pass.name = std::move(name);
+  pass.execute = std::move(execute);
+  pass.side_effect = false;
+  pass.culled = false;
+  passes_.push_back(std::move(pass));
+
+  PassBuilder builder(this, static_cast<uint32_t>(passes_.size() - 1u));
+  setup(builder);
+}
+
+bool FrameGraph::compile() {
+  cull_passes();
+  return allocate_transients();
+}
+
+void FrameGraph::cull_passes() {
+  // Reference counting: a pass is referenced by the resources it writes, and
+  //  a resource by the passes that read it. Resources nobody reads release
+  //  their writers, which may in turn release the resources they read.
+  //  Reads of a resource the same pass also writes (read-modify-write) do
+  //  not count, or the pass would keep itself alive.
+  std::vector<uint32_t> pass_refs(passes_.size(), 0u);
+  std::vector<uint32_t> resource_refs(resources_.size(), 0u);
+  std::vector<bool> pass_is_root(passes_.size(), false);
+
+  for (uint32_t i = 0; i < passes_.size(); i++) {
+    Pass& pass = passes_[i];
+    pass.culled = false;
+    pass_refs[i] = static_cast<uint32_t>(pass.writes.size());
+    pass_is_root[i] = pass.side_effect;
+    for (ResourceHandle w : pass.writes) {
+      if (resources_[w].imported) {
+        pass_is_root[i] = true;
+      }
+    }
+    for (ResourceHandle r : pass.reads) {
+      if (!::contains(pass.writes, r)) {
+        resource_refs[r]++;
+      }
+    }
+  }
+
+  std::vector<ResourceHandle> unreferenced;
+  auto cull_pass = [&](uint32_t pass_idx) {
+    Pass& pass = passes_[pass_idx];
+    pass.culled = true;
+    for (ResourceHandle r : pass.reads) {
+      if (::contains(pass.writes, r)) {
+        continue;
+      }
+      if (--resource_refs[r] == 0u && !resources_[r].imported) {
+        unreferenced.push_back(r);
+      }
+    }
+  };
+
+  for (ResourceHandle r = 0; r < resources_.size(); r++) {
+    if (resource_refs[r] == 0u && !resources_[r].imported) {
+      unreferenced.push_back(r);
+    }
+  }
+
+  for (uint32_t i = 0; i < passes_.size(); i++) {
+    if (pass_refs[i] == 0u && !pass_is_root[i]) {
+      cull_pass(i);
+    }
+  }
+
+  while (!unreferenced.empty()) {
+    ResourceHandle r = unreferenced.back();
+    unreferenced.pop_back();
+
+    for (uint32_t writer : resources_[r].writers) {
+      if (pass_is_root[writer] || passes_[writer].culled) {
+        continue;
+      }
+      if (--pass_refs[writer] == 0u) {
+        cull_pass(writer);
+      }
+    }
+  }
+
+  stats_.pass_count = static_cast<uint32_t>(passes_.size());
+  stats_.culled_pass_count = static_cast<uint32_t>(std::count_if(
+      passes_.begin(), passes_.end(), [](const Pass& p) { return p.culled; }));
+}
+
+bool FrameGraph::allocate_transients() {
+  // Lifetime of each transient texture, as [first, last] pass index
+  std::vector<uint32_t> first_use(resources_.size(), ::kUnused);
+  std::vector<uint32_t> last_use(resources_.size(), 0u);
+  std::vector<ResourceHandle> by_first_use;
+
+  for (uint32_t i = 0; i < passes_.size(); i++) {
+    if (passes_[i].culled) {
+      continue;
+    }
+
+    auto touch = [&](ResourceHandle r) {
+      if (resources_[r].imported) {
+        return;
+      }
+      if (first_use[r] == ::kUnused) {
+        first_use[r] = i;
+        by_first_use.push_back(r);
+      }
+      last_use[r] = i;
+    };
+    for (ResourceHandle r : passes_[i].writes) touch(r);
+    for (ResourceHandle r : passes_[i].reads) touch(r);
+  }
+
+  // Greedy aliasing: reuse any physical texture with the same description
+  //  whose last user runs before this texture's first user
+  struct Physical {
+    RenderTargetDesc desc;
+    uint32_t last_use;
+    RenderTarget target;
+  };
+  std::vector<Physical> physical;
+  std::vector<uint32_t> physical_idx(resources_.size(), ::kUnused);
+
+  for (ResourceHandle r : by_first_use) {
+    const RenderTargetDesc& desc = resources_[r].desc;
+    for (uint32_t p = 0; p < physical.size(); p++) {
+      if (physical[p].last_use < first_use[r] &&
+          ::same_desc(physical[p].desc, desc)) {
+        physical_idx[r] = p;
+        break;
+      }
+    }
+
+    if (physical_idx[r] == ::kUnused) {
+      physical_idx[r] = static_cast<uint32_t>(physical.size());
+      physical.push_back(Physical{desc, 0u, {}});
+    }
+    physical[physical_idx[r]].last_use = last_use[r];
+  }
+
+  for (Physical& p : physical) {
+    p.target = render_target_pool_->acquire(p.desc);
+    if (!p.target.texture) {
+      iggpu::log(LogLevel::Error,
+                 "[IGGPU] FrameGraph failed to allocate transient texture");
+      return false;
+    }
+  }
+
+  for (ResourceHandle r : by_first_use) {
+    resources_[r].target = physical[physical_idx[r]].target;
+  }
+
+  stats_.transient_texture_count = static_cast<uint32_t>(by_first_use.size());
+  stats_.physical_texture_count = static_cast<uint32_t>(physical.size());
+  return true;
+}
+
+void FrameGraph::execute(wgpu::CommandEncoder& encoder) {
+  Resources resources(this);
+  for (Pass& pass : passes_) {
+    if (pass.culled || !pass.execute) {
+      continue;
+    }
+    pass.execute(encoder, resources);
+  }
+}
+
+void FrameGraph::reset() {
+  resources_.clear();
+  passes_.clear();
+}
+
+bool FrameGraph::is_culled(const std::string& pass_name) const {
+  for (const Pass& pass : passes_) {
+    if (pass.name == pass_name) {
+      return pass.culled;
+    }
+  }
+  return false;
+}
+
+}  // namespace iggpu
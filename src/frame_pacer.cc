@@ -0,0 +1,59 @@
+#include <iggpu/frame_pacer.h>
+
+namespace iggpu {
+
+FramePacer::SharedState::SharedState(uint32_t sample_count)
+    : frames_completed(0u), latency_ms(sample_count) {}
+
+FramePacer::FramePacer(uint32_t sample_count)
+    : shared_(std::make_shared<SharedState>(sample_count)),
+      max_frames_in_flight_(2u),
+      low_latency_mode_(false),
+      frames_submitted_(0u),
+      frame_open_(false),
+      wait_ms_(sample_count) {}
+
+void FramePacer::set_max_frames_in_flight(uint32_t max_frames_in_flight) {
+  max_frames_in_flight_ = max_frames_in_flight;
+}
+
+void FramePacer::set_low_latency_mode(bool enabled) {
+  low_latency_mode_ = enabled;
+}
+
+uint32_t FramePacer::frames_in_flight() const {
+  return static_cast<uint32_t>(frames_submitted_ - shared_->frames_completed);
+}
+
+bool FramePacer::can_begin_frame() const {
+  uint32_t in_flight = frames_in_flight();
+  if (low_latency_mode_) {
+    return in_flight == 0u;
+  }
+
+  return max_frames_in_flight_ == 0u || in_flight < max_frames_in_flight_;
+}
+
+void FramePacer::begin_frame(double wait_ms) {
+  wait_ms_.add(wait_ms);
+  frame_begin_ = clock::now();
+  frame_open_ = true;
+}
+
+std::function<void()> FramePacer::end_frame() {
+  if (!frame_open_) {
+    return nullptr;
+  }
+
+  frame_open_ = false;
+  frames_submitted_++;
+
+  return [shared = shared_, frame_begin = frame_begin_]() {
+    shared->frames_completed++;
+    shared->latency_ms.add(
+        std::chrono::duration<double, std::milli>(clock::now() - frame_begin)
+            .count());
+  };
+}
+
+}  // namespace iggpu
@@ -0,0 +1,288 @@
+#include <iggpu/frame_timer.h>
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const uint32_t kReadbackSlotCount = 3u;
+const uint64_t kQueryResultSize = sizeof(uint64_t);
+
+double ms_between(std::chrono::steady_clock::time_point start,
+                  std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void append_stats_line(std::string& out, const char* name,
+                       const iggpu::Percentiles& p) {
+  char buff[256];
+  std::snprintf(buff, sizeof(buff),
+                "  %-24s p50=%7.3fms p95=%7.3fms p99=%7.3fms (n=%u)\n", name,
+                p.p50, p.p95, p.p99, p.sample_count);
+  out += buff;
+}
+
+}  // namespace
+
+namespace iggpu {
+
+FrameTimer::FrameTimer(AppBase* app_base, uint32_t sample_count)
+    : app_base_(app_base),
+      sample_count_(sample_count),
+      current_slot_(-1),
+      skipped_gpu_samples_(0u),
+      cpu_frame_(sample_count),
+      cpu_encode_(sample_count),
+      cpu_submit_(sample_count),
+      cpu_present_(sample_count),
+      gpu_frame_(sample_count),
+      alive_token_(std::make_shared<bool>(true)) {
+  frame_start_ = encode_end_ = clock::now();
+
+  if (!app_base_->Device.HasFeature(wgpu::FeatureName::TimestampQuery)) {
+    iggpu::log(LogLevel::Info,
+               "[IGGPU] Timestamp queries unavailable, falling back to "
+               "CPU-side GPU frame timing");
+    return;
+  }
+
+  wgpu::QuerySetDescriptor qsd{};
+  qsd.type = wgpu::QueryType::Timestamp;
+  qsd.count = kMaxPassesPerFrame * 2u;
+  query_set_ = app_base_->Device.CreateQuerySet(&qsd);
+  if (!query_set_) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < ::kReadbackSlotCount; i++) {
+    ReadbackSlot slot{};
+
+    wgpu::BufferDescriptor resolve_desc{};
+    resolve_desc.size = qsd.count * ::kQueryResultSize;
+    resolve_desc.usage =
+        wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+    slot.resolve_buffer =
+        iggpu::create_buffer(app_base_->Device, resolve_desc, "FrameTimer");
+
+    wgpu::BufferDescriptor readback_desc{};
+    readback_desc.size = resolve_desc.size;
+    readback_desc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+    slot.readback_buffer =
+        iggpu::create_buffer(app_base_->Device, readback_desc, "FrameTimer");
+
+    slot.in_flight = false;
+    readback_slots_.push_back(std::move(slot));
+  }
+}
+
+FrameTimer::~FrameTimer() {
+  for (auto& slot : readback_slots_) {
+    iggpu::destroy_buffer(slot.resolve_buffer);
+    iggpu::destroy_buffer(slot.readback_buffer);
+  }
+}
+
+void FrameTimer::begin_frame() {
+  frame_start_ = clock::now();
+
+  current_slot_ = -1;
+  for (uint32_t i = 0; i < readback_slots_.size(); i++) {
+    if (!readback_slots_[i].in_flight) {
+      current_slot_ = static_cast<int32_t>(i);
+      readback_slots_[i].pass_names.clear();
+      break;
+    }
+  }
+  if (current_slot_ < 0 && has_gpu_timestamps()) {
+    skipped_gpu_samples_++;
+  }
+}
+
+int32_t FrameTimer::alloc_pass_queries(const std::string& pass_name) {
+  if (current_slot_ < 0) {
+    return -1;
+  }
+
+  auto& pass_names = readback_slots_[current_slot_].pass_names;
+  if (pass_names.size() >= kMaxPassesPerFrame) {
+    return -1;
+  }
+
+  pass_names.push_back(pass_name);
+  return static_cast<int32_t>(pass_names.size() - 1u) * 2;
+}
+
+const wgpu::RenderPassTimestampWrites* FrameTimer::render_pass_timestamps(
+    const std::string& pass_name) {
+  int32_t query_idx = alloc_pass_queries(pass_name);
+  if (query_idx < 0) {
+    return nullptr;
+  }
+
+  render_pass_writes_ = {};
+  render_pass_writes_.querySet = query_set_;
+  render_pass_writes_.beginningOfPassWriteIndex = query_idx;
+  render_pass_writes_.endOfPassWriteIndex = query_idx + 1;
+  return &render_pass_writes_;
+}
+
+const wgpu::ComputePassTimestampWrites* FrameTimer::compute_pass_timestamps(
+    const std::string& pass_name) {
+  int32_t query_idx = alloc_pass_queries(pass_name);
+  if (query_idx < 0) {
+    return nullptr;
+  }
+
+  compute_pass_writes_ = {};
+  compute_pass_writes_.querySet = query_set_;
+  compute_pass_writes_.beginningOfPassWriteIndex = query_idx;
+  compute_pass_writes_.endOfPassWriteIndex = query_idx + 1;
+  return &compute_pass_writes_;
+}
+
+void FrameTimer::end_encode(wgpu::CommandEncoder& encoder) {
+  if (current_slot_ >= 0) {
+    const auto& slot = readback_slots_[current_slot_];
+    uint32_t query_count = slot.pass_names.size() * 2u;
+    if (query_count > 0u) {
+      encoder.ResolveQuerySet(query_set_, 0, query_count, slot.resolve_buffer,
+                              0);
+      encoder.CopyBufferToBuffer(slot.resolve_buffer, 0, slot.readback_buffer,
+                                 0, query_count * ::kQueryResultSize);
+    }
+  }
+
+  encode_end_ = clock::now();
+  cpu_encode_.add(::ms_between(frame_start_, encode_end_));
+}
+
+void FrameTimer::submit(wgpu::CommandBuffer commands) {
+  auto submit_start = clock::now();
+  app_base_->Queue.Submit(1, &commands);
+  auto submit_end = clock::now();
+  cpu_submit_.add(::ms_between(submit_start, submit_end));
+
+  std::weak_ptr<bool> token = alive_token_;
+
+  if (current_slot_ >= 0 &&
+      readback_slots_[current_slot_].pass_names.size() > 0u) {
+    uint32_t slot_idx = current_slot_;
+    auto& slot = readback_slots_[slot_idx];
+    slot.in_flight = true;
+    app_base_->map_buffer_async(
+        slot.readback_buffer, wgpu::MapMode::Read, 0,
+        slot.pass_names.size() * 2u * ::kQueryResultSize,
+        [this, token, slot_idx](bool success) {
+          if (token.expired()) return;
+          if (!success) {
+            readback_slots_[slot_idx].in_flight = false;
+            return;
+          }
+          on_readback_mapped(slot_idx);
+        });
+    current_slot_ = -1;
+    return;
+  }
+
+  if (!has_gpu_timestamps()) {
+    app_base_->on_submitted_work_done([this, token, submit_start]() {
+      if (token.expired()) return;
+      gpu_frame_.add(::ms_between(submit_start, clock::now()));
+    });
+  }
+  current_slot_ = -1;
+}
+
+void FrameTimer::present() {
+  auto present_start = clock::now();
+  app_base_->present();
+  auto present_end = clock::now();
+
+  cpu_present_.add(::ms_between(present_start, present_end));
+  cpu_frame_.add(::ms_between(frame_start_, present_end));
+}
+
+void FrameTimer::on_readback_mapped(uint32_t slot_idx) {
+  auto& slot = readback_slots_[slot_idx];
+  size_t query_count = slot.pass_names.size() * 2u;
+
+  std::vector<uint64_t> timestamps(query_count);
+  const void* data = slot.readback_buffer.GetConstMappedRange(
+      0, query_count * ::kQueryResultSize);
+  if (data) {
+    std::memcpy(timestamps.data(), data, query_count * ::kQueryResultSize);
+  }
+  slot.readback_buffer.Unmap();
+  slot.in_flight = false;
+
+  if (!data) {
+    return;
+  }
+
+  // Timestamps are in nanoseconds. Passes with an end before their beginning
+  //  (possible with some timestamp quantization/reset schemes) are dropped.
+  uint64_t frame_begin = UINT64_MAX;
+  uint64_t frame_end = 0u;
+  for (size_t i = 0; i < slot.pass_names.size(); i++) {
+    uint64_t begin = timestamps[i * 2u];
+    uint64_t end = timestamps[i * 2u + 1u];
+    if (end < begin) {
+      continue;
+    }
+
+    frame_begin = std::min(frame_begin, begin);
+    frame_end = std::max(frame_end, end);
+
+    auto it = gpu_passes_.find(slot.pass_names[i]);
+    if (it == gpu_passes_.end()) {
+      it = gpu_passes_.emplace(slot.pass_names[i], RollingStats(sample_count_))
+               .first;
+    }
+    it->second.add((end - begin) / 1'000'000.);
+  }
+
+  if (frame_end > frame_begin) {
+    gpu_frame_.add((frame_end - frame_begin) / 1'000'000.);
+  }
+}
+
+Percentiles FrameTimer::gpu_pass_stats(const std::string& pass_name) const {
+  auto it = gpu_passes_.find(pass_name);
+  if (it == gpu_passes_.end()) {
+    return Percentiles{};
+  }
+  return it->second.percentiles();
+}
+
+std::vector<std::string> FrameTimer::pass_names() const {
+  std::vector<std::string> names;
+  for (const auto& [name, _] : gpu_passes_) {
+    names.push_back(name);
+  }
+  return names;
+}
+
+std::string FrameTimer::summary() const {
+  std::string out = has_gpu_timestamps()
+                        ? "[IGGPU] Frame timings (GPU timestamps):\n"
+                        : "[IGGPU] Frame timings (CPU-side GPU timing):\n";
+  ::append_stats_line(out, "cpu frame", cpu_frame_.percentiles());
+  ::append_stats_line(out, "cpu encode", cpu_encode_.percentiles());
+  ::append_stats_line(out, "cpu submit", cpu_submit_.percentiles());
+  ::append_stats_line(out, "cpu present", cpu_present_.percentiles());
+  ::append_stats_line(out, "gpu frame", gpu_frame_.percentiles());
+  for (const auto& [name, stats] : gpu_passes_) {
+    ::append_stats_line(out, ("gpu pass '" + name + "'").c_str(),
+                        stats.percentiles());
+  }
+  if (skipped_gpu_samples_ > 0u) {
+    out += "  " + std::to_string(skipped_gpu_samples_) +
+           " frames without GPU timestamps (readback buffers busy)\n";
+  }
+  return out;
+}
+
+}  // namespace iggpu
@@ -0,0 +1,549 @@
+#include <iggpu/gpu_culler.h>
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <glm/gtc/matrix_access.hpp>
+
+namespace {
+
+const uint32_t kCullWorkgroupSize = 64u;
+const uint32_t kHizWorkgroupSize = 8u;
+
+// Frames a depth view's Hi-Z copy bind group stays cached while unused
+const uint32_t kHizCopyIdleFrames = 8u;
+
+// WebGPU's default maxComputeWorkgroupsPerDimension - larger dispatches
+//  spill into y
+const uint32_t kMaxWorkgroupsPerDimension = 65535u;
+
+const char kCullShader[] = R"(
+struct Object {
+  transform: mat4x4<f32>,
+  bounds: vec4<f32>,
+  draw: u32,
+  pad0: u32,
+  pad1: u32,
+  pad2: u32,
+}
+
+struct DrawArgs {
+  index_count: u32,
+  instance_count: atomic<u32>,
+  first_index: u32,
+  base_vertex: i32,
+  first_instance: u32,
+}
+
+struct Region {
+  offset: u32,
+  capacity: u32,
+}
+
+struct Params {
+  planes: array<vec4<f32>, 6>,
+  hiz_view_proj: mat4x4<f32>,
+  object_count: u32,
+  hiz_enabled: u32,
+  hiz_size: vec2<f32>,
+  hiz_mip_count: u32,
+}
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> objects: array<Object>;
+@group(0) @binding(2) var<storage, read_write> args: array<DrawArgs>;
+@group(0) @binding(3) var<storage, read> regions: array<Region>;
+@group(0) @binding(4) var<storage, read_write> visible: array<u32>;
+@group(0) @binding(5) var hiz: texture_2d<f32>;
+
+// Tests the screen rectangle of the sphere's bounding box (in the Hi-Z
+//  frame) against the farthest depth under it, at the mip where the
+//  rectangle covers at most 2x2 texels. Rectangles reaching off screen are
+//  never occluded - the pyramid has no depth for the part outside.
+fn occluded(center: vec3<f32>, radius: f32) -> bool {
+  var min_px = params.hiz_size;
+  var max_px = vec2<f32>(0.0, 0.0);
+  var nearest = 1.0;
+  for (var c = 0u; c < 8u; c++) {
+    let corner = center + radius * vec3<f32>(
+        select(-1.0, 1.0, (c & 1u) != 0u),
+        select(-1.0, 1.0, (c & 2u) != 0u),
+        select(-1.0, 1.0, (c & 4u) != 0u));
+    let clip = params.hiz_view_proj * vec4<f32>(corner, 1.0);
+    if (clip.w <= 0.0) {
+      return false;
+    }
+    let ndc = clip.xyz / clip.w;
+    let px = vec2<f32>(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5) * params.hiz_size;
+    min_px = min(min_px, px);
+    max_px = max(max_px, px);
+    nearest = min(nearest, ndc.z);
+  }
+  if (nearest <= 0.0 || any(min_px < vec2<f32>(0.0)) ||
+      any(max_px > params.hiz_size)) {
+    return false;
+  }
+
+  max_px = min(max_px, params.hiz_size - 1.0);
+  let extent = max(max_px.x - min_px.x, max_px.y - min_px.y);
+  let level = u32(clamp(ceil(log2(max(extent, 1.0))), 0.0,
+                        f32(params.hiz_mip_count - 1u)));
+  let last = vec2<u32>(textureDimensions(hiz, level)) - 1u;
+  let lo = min(vec2<u32>(min_px) >> vec2<u32>(level), last);
+  let hi = min(vec2<u32>(max_px) >> vec2<u32>(level), last);
+
+  var farthest = 0.0;
+  for (var y = lo.y; y <= hi.y; y++) {
+    for (var x = lo.x; x <= hi.x; x++) {
+      farthest = max(farthest, textureLoad(hiz, vec2<u32>(x, y), level).r);
+    }
+  }
+  return nearest > farthest;
+}
+
+@compute @workgroup_size(64)
+fn cull(@builtin(global_invocation_id) id: vec3<u32>,
+        @builtin(num_workgroups) groups: vec3<u32>) {
+  let i = id.y * groups.x * 64u + id.x;
+  if (i >= params.object_count) {
+    return;
+  }
+
+  let object = objects[i];
+  if (object.draw >= arrayLength(&regions)) {
+    return;
+  }
+
+  let m = object.transform;
+  let scale = max(length(m[0].xyz), max(length(m[1].xyz), length(m[2].xyz)));
+  let center = (m * vec4<f32>(object.bounds.xyz, 1.0)).xyz;
+  let radius = object.bounds.w * scale;
+  for (var p = 0u; p < 6u; p++) {
+    if (dot(params.planes[p].xyz, center) + params.planes[p].w < -radius) {
+      return;
+    }
+  }
+  if (params.hiz_enabled != 0u && occluded(center, radius)) {
+    return;
+  }
+
+  let region = regions[object.draw];
+  let slot = atomicAdd(&args[object.draw].instance_count, 1u);
+  if (slot >= region.capacity) {
+    // Leaves the count at the capacity once every overflowing object is done
+    atomicSub(&args[object.draw].instance_count, 1u);
+    return;
+  }
+  visible[region.offset + slot] = i;
+}
+)";
+
+const char kHizCopyShader[] = R"(
+@group(0) @binding(0) var src: texture_depth_2d;
+@group(0) @binding(1) var dst: texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn copy_depth(@builtin(global_invocation_id) id: vec3<u32>) {
+  if (any(id.xy >= textureDimensions(dst))) {
+    return;
+  }
+  let depth = textureLoad(src, id.xy, 0);
+  textureStore(dst, id.xy, vec4<f32>(depth, 0.0, 0.0, 0.0));
+}
+)";
+
+// Reads 3x3 source texels per destination texel, so that odd-sized levels
+//  stay conservative (every source texel is covered by the texel below it)
+const char kHizDownsampleShader[] = R"(
+@group(0) @binding(0) var src: texture_2d<f32>;
+@group(0) @binding(1) var dst: texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn downsample(@builtin(global_invocation_id) id: vec3<u32>) {
+  if (any(id.xy >= textureDimensions(dst))) {
+    return;
+  }
+  let last = textureDimensions(src) - 1u;
+  var farthest = 0.0;
+  for (var y = 0u; y < 3u; y++) {
+    for (var x = 0u; x < 3u; x++) {
+      let texel = min(id.xy * 2u + vec2<u32>(x, y), last);
+      farthest = max(farthest, textureLoad(src, texel, 0).r);
+    }
+  }
+  textureStore(dst, id.xy, vec4<f32>(farthest, 0.0, 0.0, 0.0));
+}
+)";
+
+// Matches the culling shader's Params struct
+struct CullParams {
+  float planes[6][4];
+  float hiz_view_proj[16];
+  uint32_t object_count;
+  uint32_t hiz_enabled;
+  float hiz_size[2];
+  uint32_t hiz_mip_count;
+  uint32_t pad[3];
+};
+static_assert(sizeof(CullParams) == 192u);
+
+wgpu::ComputePipeline create_compute_pipeline(const wgpu::Device& device,
+                                              const char* code,
+                                              const char* entry_point) {
+  wgpu::ShaderModuleWGSLDescriptor wgsl_desc{};
+  wgsl_desc.code = code;
+
+  wgpu::ShaderModuleDescriptor module_desc{};
+  module_desc.nextInChain = &wgsl_desc;
+
+  wgpu::ComputePipelineDescriptor desc{};
+  desc.compute.module = device.CreateShaderModule(&module_desc);
+  desc.compute.entryPoint = entry_point;
+  return device.CreateComputePipeline(&desc);
+}
+
+// Gribb-Hartmann, for WebGPU's 0..1 clip space depth. Normalized, so that
+//  plane distances can be compared against sphere radii.
+void extract_frustum_planes(const glm::mat4& m, float out[6][4]) {
+  glm::vec4 r0 = glm::row(m, 0);
+  glm::vec4 r1 = glm::row(m, 1);
+  glm::vec4 r2 = glm::row(m, 2);
+  glm::vec4 r3 = glm::row(m, 3);
+  glm::vec4 planes[6] = {r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2};
+  for (uint32_t i = 0; i < 6u; i++) {
+    float length = glm::length(glm::vec3(planes[i]));
+    glm::vec4 p = length > 0.f ? planes[i] / length : planes[i];
+    out[i][0] = p.x;
+    out[i][1] = p.y;
+    out[i][2] = p.z;
+    out[i][3] = p.w;
+  }
+}
+
+wgpu::BindGroup create_bind_group(const wgpu::Device& device,
+                                  const wgpu::ComputePipeline& pipeline,
+                                  const wgpu::BindGroupEntry* entries,
+                                  size_t entry_count) {
+  wgpu::BindGroupDescriptor desc{};
+  desc.layout = pipeline.GetBindGroupLayout(0);
+  desc.entryCount = entry_count;
+  desc.entries = entries;
+  return device.CreateBindGroup(&desc);
+}
+
+}  // namespace
+
+namespace iggpu {
+
+GpuCuller::GpuCuller(AppBase* app_base, GpuCullerDesc desc)
+    : app_base_(app_base),
+      desc_(desc),
+      object_count_(0u),
+      draws_dirty_(true),
+      hiz_width_(0u),
+      hiz_height_(0u),
+      hiz_mip_count_(0u),
+      hiz_bind_groups_(app_base, ::kHizCopyIdleFrames),
+      hiz_view_proj_(1.f),
+      hiz_valid_(false),
+      stats_{} {
+  const wgpu::Device& device = app_base_->Device;
+  cull_pipeline_ = ::create_compute_pipeline(device, ::kCullShader, "cull");
+  hiz_copy_pipeline_ =
+      ::create_compute_pipeline(device, ::kHizCopyShader, "copy_depth");
+  hiz_downsample_pipeline_ = ::create_compute_pipeline(
+      device, ::kHizDownsampleShader, "downsample");
+  hiz_copy_layout_ = hiz_copy_pipeline_.GetBindGroupLayout(0);
+
+  wgpu::BufferDescriptor bd{};
+  bd.size = sizeof(::CullParams);
+  bd.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+  params_buffer_ = iggpu::create_buffer(device, bd, "GpuCuller");
+
+  bd.size = std::max<uint64_t>(desc_.max_objects, 1u) * sizeof(GpuCullObject);
+  bd.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+  objects_buffer_ = iggpu::create_buffer(device, bd, "GpuCuller objects");
+
+  // Placeholder until the first build_hiz - the culling shader always binds
+  //  a depth pyramid
+  create_hiz(1u, 1u);
+}
+
+GpuCuller::~GpuCuller() {
+  iggpu::destroy_buffer(params_buffer_);
+  iggpu::destroy_buffer(objects_buffer_);
+  iggpu::destroy_buffer(args_buffer_);
+  iggpu::destroy_buffer(args_reset_buffer_);
+  iggpu::destroy_buffer(regions_buffer_);
+  iggpu::destroy_buffer(visible_buffer_);
+  iggpu::destroy_texture(hiz_texture_);
+}
+
+uint32_t GpuCuller::add_draw(uint32_t index_count, uint32_t max_instances,
+                             uint32_t first_index, int32_t base_vertex) {
+  Draw d{};
+  d.index_count = index_count;
+  d.first_index = first_index;
+  d.base_vertex = base_vertex;
+  d.offset = draws_.empty() ? 0u
+                            : draws_.back().offset + draws_.back().capacity;
+  d.capacity = max_instances;
+  draws_.push_back(d);
+  draws_dirty_ = true;
+  return static_cast<uint32_t>(draws_.size() - 1u);
+}
+
+bool GpuCuller::set_objects(std::span<const GpuCullObject> objects,
+                            uint32_t first) {
+  if (static_cast<uint64_t>(first) + objects.size() > desc_.max_objects) {
+    iggpu::log(LogLevel::Error,
+               "[IGGPU] GpuCuller objects exceed max_objects");
+    return false;
+  }
+  if (objects.empty()) {
+    return true;
+  }
+
+  app_base_->Queue.WriteBuffer(objects_buffer_,
+                               first * sizeof(GpuCullObject), objects.data(),
+                               objects.size_bytes());
+  object_count_ = std::max(object_count_,
+                           first + static_cast<uint32_t>(objects.size()));
+  return true;
+}
+
+void GpuCuller::set_object_count(uint32_t object_count) {
+  object_count_ = std::min(object_count, desc_.max_objects);
+}
+
+bool GpuCuller::create_draw_buffers() {
+  iggpu::destroy_buffer(args_buffer_);
+  iggpu::destroy_buffer(args_reset_buffer_);
+  iggpu::destroy_buffer(regions_buffer_);
+  iggpu::destroy_buffer(visible_buffer_);
+  cull_bind_group_ = nullptr;
+  draws_dirty_ = false;
+  if (draws_.empty()) {
+    return false;
+  }
+
+  std::vector<uint32_t> args;
+  std::vector<uint32_t> regions;
+  for (const Draw& d : draws_) {
+    args.insert(args.end(), {d.index_count, 0u, d.first_index,
+                             static_cast<uint32_t>(d.base_vertex), 0u});
+    regions.insert(regions.end(), {d.offset, d.capacity});
+  }
+  uint64_t visible_count = draws_.back().offset + draws_.back().capacity;
+
+  const wgpu::Device& device = app_base_->Device;
+  wgpu::BufferDescriptor bd{};
+  bd.size = args.size() * sizeof(uint32_t);
+  bd.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect |
+             wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
+  args_buffer_ = iggpu::create_buffer(device, bd, "GpuCuller");
+
+  // Copied over the arguments before each cull, to zero instance counts
+  bd.usage = wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst;
+  args_reset_buffer_ = iggpu::create_buffer(device, bd, "GpuCuller");
+
+  bd.size = regions.size() * sizeof(uint32_t);
+  bd.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+  regions_buffer_ = iggpu::create_buffer(device, bd, "GpuCuller");
+
+  bd.size = std::max<uint64_t>(visible_count, 1u) * sizeof(uint32_t);
+  bd.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Vertex;
+  visible_buffer_ = iggpu::create_buffer(device, bd, "GpuCuller");
+
+  if (!args_buffer_ || !args_reset_buffer_ || !regions_buffer_ ||
+      !visible_buffer_) {
+    return false;
+  }
+
+  app_base_->Queue.WriteBuffer(args_reset_buffer_, 0u, args.data(),
+                               args.size() * sizeof(uint32_t));
+  app_base_->Queue.WriteBuffer(regions_buffer_, 0u, regions.data(),
+                               regions.size() * sizeof(uint32_t));
+
+  stats_.draw_count = static_cast<uint32_t>(draws_.size());
+  stats_.visible_capacity = static_cast<uint32_t>(visible_count);
+  create_cull_bind_group();
+  return true;
+}
+
+void GpuCuller::create_cull_bind_group() {
+  if (!args_buffer_) {
+    return;
+  }
+
+  wgpu::TextureViewDescriptor view_desc{};
+  view_desc.mipLevelCount = hiz_mip_count_;
+
+  wgpu::BindGroupEntry entries[6]{};
+  entries[0].binding = 0u;
+  entries[0].buffer = params_buffer_;
+  entries[1].binding = 1u;
+  entries[1].buffer = objects_buffer_;
+  entries[2].binding = 2u;
+  entries[2].buffer = args_buffer_;
+  entries[3].binding = 3u;
+  entries[3].buffer = regions_buffer_;
+  entries[4].binding = 4u;
+  entries[4].buffer = visible_buffer_;
+  entries[5].binding = 5u;
+  entries[5].textureView = hiz_texture_.CreateView(&view_desc);
+  cull_bind_group_ = ::create_bind_group(app_base_->Device, cull_pipeline_,
+                                         entries, 6u);
+}
+
+void GpuCuller::cull(wgpu::CommandEncoder& encoder,
+                     const glm::mat4& view_proj) {
+  if (draws_dirty_ && !create_draw_buffers()) {
+    return;
+  }
+  if (!cull_bind_group_) {
+    return;
+  }
+
+  ::CullParams params{};
+  ::extract_frustum_planes(view_proj, params.planes);
+  std::memcpy(params.hiz_view_proj, &hiz_view_proj_[0][0],
+              sizeof(params.hiz_view_proj));
+  params.object_count = object_count_;
+  params.hiz_enabled = desc_.hiz && hiz_valid_ ? 1u : 0u;
+  params.hiz_size[0] = static_cast<float>(hiz_width_);
+  params.hiz_size[1] = static_cast<float>(hiz_height_);
+  params.hiz_mip_count = hiz_mip_count_;
+  app_base_->Queue.WriteBuffer(params_buffer_, 0u, &params, sizeof(params));
+
+  encoder.CopyBufferToBuffer(args_reset_buffer_, 0u, args_buffer_, 0u,
+                             draws_.size() * kArgsSize);
+
+  uint32_t groups =
+      (object_count_ + ::kCullWorkgroupSize - 1u) / ::kCullWorkgroupSize;
+  if (groups > 0u) {
+    uint32_t groups_x = std::min(groups, ::kMaxWorkgroupsPerDimension);
+    uint32_t groups_y = (groups + groups_x - 1u) / groups_x;
+
+    wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+    pass.SetPipeline(cull_pipeline_);
+    pass.SetBindGroup(0, cull_bind_group_);
+    pass.DispatchWorkgroups(groups_x, groups_y);
+    pass.End();
+  }
+
+  stats_.object_count = object_count_;
+  stats_.cull_passes++;
+}
+
+void GpuCuller::draw(wgpu::RenderPassEncoder& pass, uint32_t draw,
+                     uint32_t instance_slot) const {
+  if (draw >= draws_.size() || !args_buffer_ || draws_[draw].capacity == 0u) {
+    return;
+  }
+
+  const Draw& d = draws_[draw];
+  pass.SetVertexBuffer(instance_slot, visible_buffer_,
+                       d.offset * sizeof(uint32_t),
+                       d.capacity * sizeof(uint32_t));
+  pass.DrawIndexedIndirect(args_buffer_, draw * kArgsSize);
+}
+
+bool GpuCuller::create_hiz(uint32_t width, uint32_t height) {
+  iggpu::destroy_texture(hiz_texture_);
+  hiz_downsample_bind_groups_.clear();
+  hiz_bind_groups_.clear();
+  hiz_copy_target_ = nullptr;
+  hiz_valid_ = false;
+
+  hiz_width_ = width;
+  hiz_height_ = height;
+  hiz_mip_count_ = 1u;
+  while ((std::max(width, height) >> hiz_mip_count_) > 0u) {
+    hiz_mip_count_++;
+  }
+
+  wgpu::TextureDescriptor td{};
+  td.size = {width, height, 1u};
+  td.format = wgpu::TextureFormat::R32Float;
+  td.mipLevelCount = hiz_mip_count_;
+  td.usage =
+      wgpu::TextureUsage::StorageBinding | wgpu::TextureUsage::TextureBinding;
+  hiz_texture_ = iggpu::create_texture(app_base_->Device, td, "GpuCuller Hi-Z");
+  if (!hiz_texture_) {
+    return false;
+  }
+
+  wgpu::TextureViewDescriptor copy_target_desc{};
+  copy_target_desc.mipLevelCount = 1u;
+  hiz_copy_target_ = hiz_texture_.CreateView(&copy_target_desc);
+
+  for (uint32_t mip = 1u; mip < hiz_mip_count_; mip++) {
+    wgpu::TextureViewDescriptor src_desc{};
+    src_desc.baseMipLevel = mip - 1u;
+    src_desc.mipLevelCount = 1u;
+    wgpu::TextureViewDescriptor dst_desc = src_desc;
+    dst_desc.baseMipLevel = mip;
+
+    wgpu::BindGroupEntry entries[2]{};
+    entries[0].binding = 0u;
+    entries[0].textureView = hiz_texture_.CreateView(&src_desc);
+    entries[1].binding = 1u;
+    entries[1].textureView = hiz_texture_.CreateView(&dst_desc);
+    hiz_downsample_bind_groups_.push_back(::create_bind_group(
+        app_base_->Device, hiz_downsample_pipeline_, entries, 2u));
+  }
+
+  create_cull_bind_group();
+  return true;
+}
+
+void GpuCuller::build_hiz(wgpu::CommandEncoder& encoder,
+                          const wgpu::TextureView& depth_view, uint32_t width,
+                          uint32_t height, const glm::mat4& view_proj) {
+  if (!desc_.hiz || width == 0u || height == 0u) {
+    return;
+  }
+  if ((width != hiz_width_ || height != hiz_height_) &&
+      !create_hiz(width, height)) {
+    return;
+  }
+
+  // Depth buffers usually cycle through a few pooled textures, each with its
+  //  own view - keep a copy bind group per view, dropped once it goes unused
+  wgpu::BindGroupEntry entries[2]{};
+  entries[0].binding = 0u;
+  entries[0].textureView = depth_view;
+  entries[1].binding = 1u;
+  entries[1].textureView = hiz_copy_target_;
+  wgpu::BindGroupDescriptor copy_desc{};
+  copy_desc.layout = hiz_copy_layout_;
+  copy_desc.entryCount = 2u;
+  copy_desc.entries = entries;
+  wgpu::BindGroup copy_bind_group = hiz_bind_groups_.bind_group(copy_desc);
+  hiz_bind_groups_.end_frame();
+
+  auto groups = [](uint32_t size) {
+    return (size + ::kHizWorkgroupSize - 1u) / ::kHizWorkgroupSize;
+  };
+
+  wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+  pass.SetPipeline(hiz_copy_pipeline_);
+  pass.SetBindGroup(0, copy_bind_group);
+  pass.DispatchWorkgroups(groups(width), groups(height));
+
+  pass.SetPipeline(hiz_downsample_pipeline_);
+  for (uint32_t mip = 1u; mip < hiz_mip_count_; mip++) {
+    pass.SetBindGroup(0, hiz_downsample_bind_groups_[mip - 1u]);
+    pass.DispatchWorkgroups(groups(std::max(width >> mip, 1u)),
+                            groups(std::max(height >> mip, 1u)));
+  }
+  pass.End();
+
+  hiz_view_proj_ = view_proj;
+  hiz_valid_ = true;
+  stats_.hiz_builds++;
+}
+
+}  // namespace iggpu
@@ -0,0 +1,311 @@
+#include <iggpu/app_base.h>
+#include <iggpu/gpu_errors.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// Bounds memory in storms of distinct errors - past this, new fingerprints
+//  are counted but not logged until the next report
+const size_t kMaxFingerprints = 256u;
+
+// Long messages (Dawn appends the full call context) are cut short in
+//  repeat summaries - the first occurrence was logged in full
+const size_t kMaxSummaryMessageLength = 160u;
+
+struct Fingerprint {
+  std::string message;
+  iggpu::LogLevel log_level;
+  uint64_t repeats_since_report;
+  bool seen_since_report;
+};
+
+struct GpuErrorState {
+  std::mutex mutex;
+  std::unordered_map<uint64_t, Fingerprint> fingerprints;
+  iggpu::GpuErrorCounts counts;
+  uint64_t overflow_since_report = 0u;
+  double report_interval_s = 5.;
+  clock::time_point last_report = clock::now();
+
+  // Set while any fingerprint has unreported repeats (checked without the
+  //  lock, so flush_gpu_error_reports is cheap when nothing has repeated)
+  std::atomic<bool> has_pending{false};
+};
+
+GpuErrorState& state() {
+  static GpuErrorState* state = new GpuErrorState();
+  return *state;
+}
+
+const char* error_type_name(wgpu::ErrorType type) {
+  switch (type) {
+    case wgpu::ErrorType::Validation:
+      return "Validation";
+    case wgpu::ErrorType::OutOfMemory:
+      return "OutOfMemory";
+    case wgpu::ErrorType::Internal:
+      return "Internal";
+    case wgpu::ErrorType::DeviceLost:
+      return "DeviceLost";
+    case wgpu::ErrorType::Unknown:
+      return "Unknown";
+    default:
+      return "UNEXPECTED (this is bad)";
+  }
+}
+
+// FNV-1a over the message with every run of digits (and hex digits after
+//  "0x") collapsed into one '#'
+uint64_t fingerprint(uint64_t kind, const char* scope_label,
+                     std::string_view message) {
+  uint64_t hash = 0xcbf29ce484222325ull ^ kind;
+  auto mix = [&hash](char c) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ull;
+  };
+
+  if (scope_label) {
+    for (const char* c = scope_label; *c; c++) {
+      mix(*c);
+    }
+    mix('\0');
+  }
+
+  bool in_number = false;
+  for (size_t i = 0; i < message.size(); i++) {
+    char c = message[i];
+    bool is_digit = c >= '0' && c <= '9';
+    bool is_hex = in_number && ((c >= 'a' && c <= 'f') ||
+                                (c >= 'A' && c <= 'F') || c == 'x');
+    if (is_digit || is_hex) {
+      if (!in_number) {
+        mix('#');
+        in_number = true;
+      }
+      continue;
+    }
+    in_number = false;
+    mix(c);
+  }
+  return hash;
+}
+
+void count_error(iggpu::GpuErrorCounts& counts, wgpu::ErrorType type) {
+  switch (type) {
+    case wgpu::ErrorType::Validation:
+      counts.validation++;
+      return;
+    case wgpu::ErrorType::OutOfMemory:
+      counts.out_of_memory++;
+      return;
+    case wgpu::ErrorType::Internal:
+      counts.internal++;
+      return;
+    case wgpu::ErrorType::DeviceLost:
+      counts.device_lost++;
+      return;
+    default:
+      counts.unknown++;
+      return;
+  }
+}
+
+std::string summary_text(std::string_view message) {
+  size_t end = message.find('\n');
+  if (end == std::string_view::npos) {
+    end = message.size();
+  }
+  if (end > kMaxSummaryMessageLength) {
+    return std::string(message.substr(0u, kMaxSummaryMessageLength)) + "...";
+  }
+  return std::string(message.substr(0u, end));
+}
+
+// Counts a repeat (or overflow) and returns false, or returns true if this is
+//  a new fingerprint that should be logged and recorded. Caller holds the
+//  lock. Repeats cost a hash and a map lookup - no allocations.
+bool is_new(GpuErrorState& s, uint64_t fp) {
+  if (s.report_interval_s <= 0.) {
+    return true;
+  }
+
+  auto it = s.fingerprints.find(fp);
+  if (it != s.fingerprints.end()) {
+    it->second.repeats_since_report++;
+    it->second.seen_since_report = true;
+  } else if (s.fingerprints.size() >= kMaxFingerprints) {
+    s.overflow_since_report++;
+  } else {
+    return true;
+  }
+
+  s.counts.suppressed++;
+  s.has_pending.store(true, std::memory_order_relaxed);
+  return false;
+}
+
+// Caller holds the lock
+void record(GpuErrorState& s, uint64_t fp, iggpu::LogLevel log_level,
+            const std::string& prefix, std::string_view message) {
+  if (s.report_interval_s <= 0.) {
+    return;
+  }
+
+  s.fingerprints.emplace(
+      fp, Fingerprint{prefix + ::summary_text(message), log_level, 0u, true});
+}
+
+// Caller holds the lock
+void report_repeats(GpuErrorState& s, double elapsed_s) {
+  for (auto it = s.fingerprints.begin(); it != s.fingerprints.end();) {
+    Fingerprint& f = it->second;
+    if (f.repeats_since_report > 0u) {
+      iggpu::log_printf(
+          f.log_level, "[IGGPU] Repeated %llu times in %.1fs: %s",
+          static_cast<unsigned long long>(f.repeats_since_report), elapsed_s,
+          f.message.c_str());
+      f.repeats_since_report = 0u;
+    }
+
+    // Errors that stopped happening are forgotten - if they come back, the
+    //  next occurrence is logged in full again
+    if (!f.seen_since_report) {
+      it = s.fingerprints.erase(it);
+      continue;
+    }
+    f.seen_since_report = false;
+    ++it;
+  }
+
+  if (s.overflow_since_report > 0u) {
+    IGGPU_LOG_WARNING(
+        "[IGGPU] %llu more GPU errors/warnings in %.1fs not logged (too many "
+        "distinct messages)",
+        static_cast<unsigned long long>(s.overflow_since_report), elapsed_s);
+    s.overflow_since_report = 0u;
+  }
+
+  s.has_pending.store(false, std::memory_order_relaxed);
+}
+
+void maybe_report(GpuErrorState& s, bool force) {
+  auto now = clock::now();
+  double elapsed_s = std::chrono::duration<double>(now - s.last_report).count();
+  if (!force && elapsed_s < s.report_interval_s) {
+    return;
+  }
+
+  ::report_repeats(s, elapsed_s);
+  s.last_report = now;
+}
+
+}  // namespace
+
+namespace iggpu {
+
+void report_gpu_error(wgpu::ErrorType type, std::string_view message,
+                      const char* scope_label) {
+  GpuErrorState& s = ::state();
+  uint64_t fp = ::fingerprint(static_cast<uint64_t>(type), scope_label,
+                              message);
+
+  std::lock_guard<std::mutex> l(s.mutex);
+  ::count_error(s.counts, type);
+
+  if (::is_new(s, fp)) {
+    std::string prefix = std::string("GPU ") + ::error_type_name(type) +
+                         " error";
+    if (scope_label) {
+      prefix = prefix + " in scope '" + scope_label + "'";
+    }
+    prefix += " - ";
+
+    IGGPU_LOG_ERROR("[IGGPU] %s%.*s", prefix.c_str(),
+                    static_cast<int>(message.size()), message.data());
+    ::record(s, fp, LogLevel::Error, prefix, message);
+  }
+  ::maybe_report(s, false);
+}
+
+void report_gpu_log_message(LogLevel log_level, std::string_view message) {
+  if (!log_enabled(log_level)) {
+    return;
+  }
+
+  GpuErrorState& s = ::state();
+
+  // Offset so log messages never share a fingerprint with errors
+  uint64_t fp = ::fingerprint(0x100u + static_cast<uint64_t>(log_level),
+                              nullptr, message);
+
+  std::lock_guard<std::mutex> l(s.mutex);
+  if (::is_new(s, fp)) {
+    log_printf(log_level, "[IGGPU/Dawn] %.*s",
+               static_cast<int>(message.size()), message.data());
+    ::record(s, fp, log_level, "Dawn - ", message);
+  }
+  ::maybe_report(s, false);
+}
+
+void flush_gpu_error_reports(bool force) {
+  GpuErrorState& s = ::state();
+  if (!force && !s.has_pending.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> l(s.mutex);
+  ::maybe_report(s, force);
+}
+
+void set_gpu_error_report_interval(double interval_s) {
+  GpuErrorState& s = ::state();
+  std::lock_guard<std::mutex> l(s.mutex);
+  s.report_interval_s = interval_s;
+}
+
+GpuErrorCounts gpu_error_counts() {
+  GpuErrorState& s = ::state();
+  std::lock_guard<std::mutex> l(s.mutex);
+  return s.counts;
+}
+
+void reset_gpu_error_counts() {
+  GpuErrorState& s = ::state();
+  std::lock_guard<std::mutex> l(s.mutex);
+  s.counts = GpuErrorCounts{};
+  s.fingerprints.clear();
+  s.overflow_since_report = 0u;
+  s.last_report = clock::now();
+  s.has_pending.store(false, std::memory_order_relaxed);
+}
+
+GpuErrorScope::GpuErrorScope(AppBase* app_base, const char* label,
+                             wgpu::ErrorFilter filter)
+    : app_base_(gpu_error_scopes_enabled() ? app_base : nullptr),
+      label_(label) {
+  if (app_base_) {
+    app_base_->push_error_scope(filter);
+  }
+}
+
+GpuErrorScope::~GpuErrorScope() {
+  if (!app_base_) {
+    return;
+  }
+
+  const char* label = label_;
+  app_base_->pop_error_scope(
+      [label](wgpu::ErrorType type, std::string_view message) {
+        if (type != wgpu::ErrorType::NoError) {
+          report_gpu_error(type, message, label);
+        }
+      });
+}
+
+}  // namespace iggpu
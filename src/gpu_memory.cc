@@ -0,0 +1,520 @@
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// OOM errors repeat (every allocation that follows fails too) - the report
+//  is long, so it is logged at most this often
+const double kOutOfMemoryReportInterval = 10.;
+
+const char* kUntagged = "untagged";
+
+struct Allocation {
+  uint64_t size;
+  uint32_t tag_idx;
+  bool is_texture;
+  uint64_t usage;
+
+  // Textures only
+  wgpu::TextureFormat format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth_or_array_layers;
+};
+
+struct TagTotals {
+  std::string_view tag;
+  uint64_t live_bytes;
+  uint64_t peak_bytes;
+  uint64_t live_count;
+};
+
+struct GpuMemoryState {
+  std::mutex mutex;
+
+  // Keyed by the C handle (WGPUBuffer/WGPUTexture)
+  std::unordered_map<const void*, Allocation> allocations;
+  std::vector<TagTotals> tags;
+  std::unordered_map<std::string_view, uint32_t> tag_indices;
+
+  uint64_t live_bytes = 0u;
+  uint64_t buffer_bytes = 0u;
+  uint64_t texture_bytes = 0u;
+  uint64_t peak_bytes = 0u;
+
+  uint64_t budget_bytes = 0u;
+  iggpu::GpuMemoryEvictFn evict;
+  uint64_t eviction_requests = 0u;
+  uint64_t rejected_allocations = 0u;
+
+  bool has_reported_oom = false;
+  clock::time_point last_oom_report;
+
+  // Separate lock, so listeners can query stats
+  std::mutex listener_mutex;
+  std::vector<std::pair<uint32_t, iggpu::GpuResourceDestroyedFn>> listeners;
+  uint32_t next_listener_id = 1u;
+  std::atomic<bool> has_listeners{false};
+};
+
+GpuMemoryState& state() {
+  static GpuMemoryState* state = new GpuMemoryState();
+  return *state;
+}
+
+struct FormatBlock {
+  uint32_t bytes;
+  uint32_t width;
+  uint32_t height;
+};
+
+FormatBlock format_block(wgpu::TextureFormat format) {
+  switch (format) {
+    case wgpu::TextureFormat::R8Unorm:
+    case wgpu::TextureFormat::R8Snorm:
+    case wgpu::TextureFormat::R8Uint:
+    case wgpu::TextureFormat::R8Sint:
+    case wgpu::TextureFormat::Stencil8:
+      return {1u, 1u, 1u};
+    case wgpu::TextureFormat::R16Uint:
+    case wgpu::TextureFormat::R16Sint:
+    case wgpu::TextureFormat::R16Float:
+    case wgpu::TextureFormat::RG8Unorm:
+    case wgpu::TextureFormat::RG8Snorm:
+    case wgpu::TextureFormat::RG8Uint:
+    case wgpu::TextureFormat::RG8Sint:
+    case wgpu::TextureFormat::Depth16Unorm:
+      return {2u, 1u, 1u};
+    case wgpu::TextureFormat::RG32Float:
+    case wgpu::TextureFormat::RG32Uint:
+    case wgpu::TextureFormat::RG32Sint:
+    case wgpu::TextureFormat::RGBA16Uint:
+    case wgpu::TextureFormat::RGBA16Sint:
+    case wgpu::TextureFormat::RGBA16Float:
+    case wgpu::TextureFormat::Depth32FloatStencil8:
+      return {8u, 1u, 1u};
+    case wgpu::TextureFormat::RGBA32Float:
+    case wgpu::TextureFormat::RGBA32Uint:
+    case wgpu::TextureFormat::RGBA32Sint:
+      return {16u, 1u, 1u};
+    case wgpu::TextureFormat::BC1RGBAUnorm:
+    case wgpu::TextureFormat::BC1RGBAUnormSrgb:
+    case wgpu::TextureFormat::BC4RUnorm:
+    case wgpu::TextureFormat::BC4RSnorm:
+    case wgpu::TextureFormat::ETC2RGB8Unorm:
+    case wgpu::TextureFormat::ETC2RGB8UnormSrgb:
+    case wgpu::TextureFormat::ETC2RGB8A1Unorm:
+    case wgpu::TextureFormat::ETC2RGB8A1UnormSrgb:
+    case wgpu::TextureFormat::EACR11Unorm:
+    case wgpu::TextureFormat::EACR11Snorm:
+      return {8u, 4u, 4u};
+    case wgpu::TextureFormat::BC2RGBAUnorm:
+    case wgpu::TextureFormat::BC2RGBAUnormSrgb:
+    case wgpu::TextureFormat::BC3RGBAUnorm:
+    case wgpu::TextureFormat::BC3RGBAUnormSrgb:
+    case wgpu::TextureFormat::BC5RGUnorm:
+    case wgpu::TextureFormat::BC5RGSnorm:
+    case wgpu::TextureFormat::BC6HRGBUfloat:
+    case wgpu::TextureFormat::BC6HRGBFloat:
+    case wgpu::TextureFormat::BC7RGBAUnorm:
+    case wgpu::TextureFormat::BC7RGBAUnormSrgb:
+    case wgpu::TextureFormat::ETC2RGBA8Unorm:
+    case wgpu::TextureFormat::ETC2RGBA8UnormSrgb:
+    case wgpu::TextureFormat::EACRG11Unorm:
+    case wgpu::TextureFormat::EACRG11Snorm:
+    case wgpu::TextureFormat::ASTC4x4Unorm:
+    case wgpu::TextureFormat::ASTC4x4UnormSrgb:
+      return {16u, 4u, 4u};
+    default:
+      // Everything else is 4 bytes per texel, or close enough for accounting
+      //  (Depth24PlusStencil8, larger ASTC blocks)
+      return {4u, 1u, 1u};
+  }
+}
+
+// Caller holds the lock
+uint32_t tag_index(GpuMemoryState& s, const char* tag) {
+  std::string_view name = tag ? tag : kUntagged;
+  auto it = s.tag_indices.find(name);
+  if (it != s.tag_indices.end()) {
+    return it->second;
+  }
+
+  uint32_t idx = static_cast<uint32_t>(s.tags.size());
+  s.tags.push_back(TagTotals{name, 0u, 0u, 0u});
+  s.tag_indices.emplace(name, idx);
+  return idx;
+}
+
+// Caller holds the lock
+void subtract(GpuMemoryState& s, const Allocation& a) {
+  TagTotals& t = s.tags[a.tag_idx];
+  t.live_bytes -= a.size;
+  t.live_count--;
+  s.live_bytes -= a.size;
+  (a.is_texture ? s.texture_bytes : s.buffer_bytes) -= a.size;
+}
+
+void track(const void* handle, Allocation a, const char* tag) {
+  if (handle == nullptr) {
+    return;
+  }
+
+  GpuMemoryState& s = ::state();
+  std::lock_guard<std::mutex> l(s.mutex);
+  a.tag_idx = ::tag_index(s, tag);
+
+  // A handle can only be reused after the previous object was freed - it
+  //  was released without destroy_*
+  auto [it, inserted] = s.allocations.try_emplace(handle, a);
+  if (!inserted) {
+    ::subtract(s, it->second);
+    it->second = a;
+  }
+
+  TagTotals& t = s.tags[a.tag_idx];
+  t.live_bytes += a.size;
+  t.live_count++;
+  t.peak_bytes = std::max(t.peak_bytes, t.live_bytes);
+
+  s.live_bytes += a.size;
+  (a.is_texture ? s.texture_bytes : s.buffer_bytes) += a.size;
+  s.peak_bytes = std::max(s.peak_bytes, s.live_bytes);
+}
+
+void notify_destroyed(const void* handle) {
+  GpuMemoryState& s = ::state();
+  if (!s.has_listeners.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> l(s.listener_mutex);
+  for (const auto& [id, cb] : s.listeners) {
+    cb(handle);
+  }
+}
+
+void untrack(const void* handle) {
+  if (handle == nullptr) {
+    return;
+  }
+
+  GpuMemoryState& s = ::state();
+  std::lock_guard<std::mutex> l(s.mutex);
+  auto it = s.allocations.find(handle);
+  if (it == s.allocations.end()) {
+    return;
+  }
+  ::subtract(s, it->second);
+  s.allocations.erase(it);
+}
+
+// Returns false if the allocation does not fit in the budget, even after
+//  asking the eviction callback to make room
+bool admit(uint64_t size, const char* tag) {
+  GpuMemoryState& s = ::state();
+  iggpu::GpuMemoryEvictFn evict;
+  uint64_t bytes_needed = 0u;
+  {
+    std::lock_guard<std::mutex> l(s.mutex);
+    if (s.budget_bytes == 0u || s.live_bytes + size <= s.budget_bytes) {
+      return true;
+    }
+    bytes_needed = s.live_bytes + size - s.budget_bytes;
+    evict = s.evict;
+    if (evict) {
+      s.eviction_requests++;
+    }
+  }
+
+  if (evict) {
+    evict(bytes_needed);
+  }
+
+  std::lock_guard<std::mutex> l(s.mutex);
+  if (s.live_bytes + size <= s.budget_bytes) {
+    return true;
+  }
+
+  if (s.rejected_allocations++ == 0u) {
+    IGGPU_LOG_WARNING(
+        "[IGGPU] GPU memory budget exceeded - refusing %llu byte allocation "
+        "for '%s' (live %llu of %llu bytes)",
+        static_cast<unsigned long long>(size), tag ? tag : kUntagged,
+        static_cast<unsigned long long>(s.live_bytes),
+        static_cast<unsigned long long>(s.budget_bytes));
+  }
+  return false;
+}
+
+std::string bytes_text(uint64_t bytes) {
+  char buff[32];
+  if (bytes >= 1024ull * 1024ull) {
+    std::snprintf(buff, sizeof(buff), "%.1f MiB", bytes / (1024. * 1024.));
+  } else if (bytes >= 1024ull) {
+    std::snprintf(buff, sizeof(buff), "%.1f KiB", bytes / 1024.);
+  } else {
+    std::snprintf(buff, sizeof(buff), "%llu B",
+                  static_cast<unsigned long long>(bytes));
+  }
+  return buff;
+}
+
+}  // namespace
+
+namespace iggpu {
+
+wgpu::Buffer create_buffer(const wgpu::Device& device,
+                           const wgpu::BufferDescriptor& desc,
+                           const char* tag) {
+  if (!::admit(desc.size, tag)) {
+    return nullptr;
+  }
+
+  wgpu::Buffer buffer = device.CreateBuffer(&desc);
+
+  Allocation a{};
+  a.size = desc.size;
+  a.is_texture = false;
+  a.usage = static_cast<uint64_t>(desc.usage);
+  ::track(buffer.Get(), a, tag);
+  return buffer;
+}
+
+wgpu::Texture create_texture(const wgpu::Device& device,
+                             const wgpu::TextureDescriptor& desc,
+                             const char* tag) {
+  uint64_t size = estimate_texture_size(desc);
+  if (!::admit(size, tag)) {
+    return nullptr;
+  }
+
+  wgpu::Texture texture = device.CreateTexture(&desc);
+
+  Allocation a{};
+  a.size = size;
+  a.is_texture = true;
+  a.usage = static_cast<uint64_t>(desc.usage);
+  a.format = desc.format;
+  a.width = desc.size.width;
+  a.height = desc.size.height;
+  a.depth_or_array_layers = desc.size.depthOrArrayLayers;
+  ::track(texture.Get(), a, tag);
+  return texture;
+}
+
+void destroy_buffer(wgpu::Buffer& buffer) {
+  if (!buffer) {
+    return;
+  }
+  ::untrack(buffer.Get());
+  ::notify_destroyed(buffer.Get());
+  buffer.Destroy();
+  buffer = nullptr;
+}
+
+void destroy_texture(wgpu::Texture& texture) {
+  if (!texture) {
+    return;
+  }
+  ::untrack(texture.Get());
+  ::notify_destroyed(texture.Get());
+  texture.Destroy();
+  texture = nullptr;
+}
+
+void release_buffer(wgpu::Buffer& buffer) {
+  if (!buffer) {
+    return;
+  }
+  ::untrack(buffer.Get());
+  ::notify_destroyed(buffer.Get());
+  buffer = nullptr;
+}
+
+void release_texture(wgpu::Texture& texture) {
+  if (!texture) {
+    return;
+  }
+  ::untrack(texture.Get());
+  ::notify_destroyed(texture.Get());
+  texture = nullptr;
+}
+
+uint64_t estimate_texture_size(const wgpu::TextureDescriptor& desc) {
+  FormatBlock block = ::format_block(desc.format);
+  bool is_3d = desc.dimension == wgpu::TextureDimension::e3D;
+
+  uint64_t total = 0u;
+  for (uint32_t mip = 0u; mip < std::max(desc.mipLevelCount, 1u); mip++) {
+    uint64_t w = std::max(desc.size.width >> mip, 1u);
+    uint64_t h = std::max(desc.size.height >> mip, 1u);
+    uint64_t d = is_3d ? std::max(desc.size.depthOrArrayLayers >> mip, 1u)
+                       : std::max(desc.size.depthOrArrayLayers, 1u);
+    uint64_t blocks_x = (w + block.width - 1u) / block.width;
+    uint64_t blocks_y = (h + block.height - 1u) / block.height;
+    total += blocks_x * blocks_y * block.bytes * d;
+  }
+  return total * std::max(desc.sampleCount, 1u);
+}
+
+uint32_t add_gpu_resource_destroyed_listener(GpuResourceDestroyedFn cb) {
+  GpuMemoryState& s = ::state();
+  std::lock_guard<std::mutex> l(s.listener_mutex);
+  uint32_t id = s.next_listener_id++;
+  s.listeners.emplace_back(id, std::move(cb));
+  s.has_listeners.store(true, std::memory_order_relaxed);
+  return id;
+}
+
+void remove_gpu_resource_destroyed_listener(uint32_t listener_id) {
+  GpuMemoryState& s = ::state();
+  std::lock_guard<std::mutex> l(s.listener_mutex);
+  s.listeners.erase(
+      std::remove_if(s.listeners.begin(), s.listeners.end(),
+                     [listener_id](const auto& listener) {
+                       return listener.first == listener_id;
+                     }),
+      s.listeners.end());
+  s.has_listeners.store(!s.listeners.empty(), std::memory_order_relaxed);
+}
+
+void set_gpu_memory_budget(uint64_t budget_bytes, GpuMemoryEvictFn evict) {
+  GpuMemoryState& s = ::state();
+  std::lock_guard<std::mutex> l(s.mutex);
+  s.budget_bytes = budget_bytes;
+  s.evict = std::move(evict);
+}
+
+GpuMemoryStats gpu_memory_stats() {
+  GpuMemoryState& s = ::state();
+  std::lock_guard<std::mutex> l(s.mutex);
+
+  GpuMemoryStats stats{};
+  stats.live_bytes = s.live_bytes;
+  stats.buffer_bytes = s.buffer_bytes;
+  stats.texture_bytes = s.texture_bytes;
+  stats.live_count = s.allocations.size();
+  stats.peak_bytes = s.peak_bytes;
+  stats.budget_bytes = s.budget_bytes;
+  stats.eviction_requests = s.eviction_requests;
+  stats.rejected_allocations = s.rejected_allocations;
+
+  for (const TagTotals& t : s.tags) {
+    stats.tags.push_back(GpuMemoryTagStats{std::string(t.tag), t.live_bytes,
+                                           t.peak_bytes, t.live_count});
+  }
+  std::sort(stats.tags.begin(), stats.tags.end(),
+            [](const GpuMemoryTagStats& a, const GpuMemoryTagStats& b) {
+              return a.live_bytes > b.live_bytes;
+            });
+  return stats;
+}
+
+void reset_gpu_memory_peak() {
+  GpuMemoryState& s = ::state();
+  std::lock_guard<std::mutex> l(s.mutex);
+  s.peak_bytes = s.live_bytes;
+  for (TagTotals& t : s.tags) {
+    t.peak_bytes = t.live_bytes;
+  }
+}
+
+std::string gpu_memory_report(uint32_t max_allocations) {
+  GpuMemoryStats stats = gpu_memory_stats();
+
+  std::string out = "[IGGPU] GPU memory: " + ::bytes_text(stats.live_bytes) +
+                    " live in " + std::to_string(stats.live_count) +
+                    " resources (buffers " + ::bytes_text(stats.buffer_bytes) +
+                    ", textures " + ::bytes_text(stats.texture_bytes) +
+                    "), peak " + ::bytes_text(stats.peak_bytes);
+  if (stats.budget_bytes > 0u) {
+    out += ", budget " + ::bytes_text(stats.budget_bytes);
+  }
+  out += "\n";
+
+  char buff[256];
+  for (const GpuMemoryTagStats& t : stats.tags) {
+    if (t.live_count == 0u && t.peak_bytes == 0u) {
+      continue;
+    }
+    std::snprintf(buff, sizeof(buff), "  %-24s %12s in %5llu (peak %s)\n",
+                  t.tag.c_str(), ::bytes_text(t.live_bytes).c_str(),
+                  static_cast<unsigned long long>(t.live_count),
+                  ::bytes_text(t.peak_bytes).c_str());
+    out += buff;
+  }
+
+  if (max_allocations == 0u) {
+    return out;
+  }
+
+  std::vector<std::pair<Allocation, std::string_view>> largest;
+  {
+    GpuMemoryState& s = ::state();
+    std::lock_guard<std::mutex> l(s.mutex);
+    largest.reserve(s.allocations.size());
+    for (const auto& [handle, a] : s.allocations) {
+      largest.emplace_back(a, s.tags[a.tag_idx].tag);
+    }
+  }
+
+  size_t count = std::min<size_t>(largest.size(), max_allocations);
+  std::partial_sort(largest.begin(), largest.begin() + count, largest.end(),
+                    [](const auto& a, const auto& b) {
+                      return a.first.size > b.first.size;
+                    });
+
+  out += "  Largest allocations:\n";
+  for (size_t i = 0u; i < count; i++) {
+    const Allocation& a = largest[i].first;
+    std::string_view tag = largest[i].second;
+    if (a.is_texture) {
+      std::snprintf(
+          buff, sizeof(buff),
+          "    %12s texture %ux%ux%u format=%u usage=0x%llx (%.*s)\n",
+          ::bytes_text(a.size).c_str(), a.width, a.height,
+          a.depth_or_array_layers, static_cast<uint32_t>(a.format),
+          static_cast<unsigned long long>(a.usage),
+          static_cast<int>(tag.size()), tag.data());
+    } else {
+      std::snprintf(buff, sizeof(buff),
+                    "    %12s buffer usage=0x%llx (%.*s)\n",
+                    ::bytes_text(a.size).c_str(),
+                    static_cast<unsigned long long>(a.usage),
+                    static_cast<int>(tag.size()), tag.data());
+    }
+    out += buff;
+  }
+  return out;
+}
+
+void report_gpu_out_of_memory() {
+  GpuMemoryState& s = ::state();
+  {
+    std::lock_guard<std::mutex> l(s.mutex);
+    auto now = clock::now();
+    if (s.has_reported_oom &&
+        std::chrono::duration<double>(now - s.last_oom_report).count() <
+            kOutOfMemoryReportInterval) {
+      return;
+    }
+    s.has_reported_oom = true;
+    s.last_oom_report = now;
+  }
+
+  iggpu::log(LogLevel::Error, gpu_memory_report());
+}
+
+}  // namespace iggpu
@@ -1,8 +1,24 @@
 #include <iggpu/iggpu_config.h>
 #include <iggpu/log.h>
 
-#ifdef IGGPU_ENABLE_DEFAULT_LOGGING
+#include <cstdarg>
 #include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#ifndef __EMSCRIPTEN__
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #endif
 
 namespace {
@@ -17,6 +33,7 @@ void default_print_cb(iggpu::LogLevel log_level, const std::string& msg) {
       return;
     case iggpu::LogLevel::Warning:
     case iggpu::LogLevel::Info:
+    case iggpu::LogLevel::Verbose:
       std::fprintf(stdout, "%s", msg.c_str());
   }
 #endif
@@ -25,10 +42,310 @@ void default_print_cb(iggpu::LogLevel log_level, const std::string& msg) {
 std::function<void(iggpu::LogLevel, const std::string&)> gLogFn =
     ::default_print_cb;
 
+// Guards gLogFn - held while a message is being written, so that the sink
+//  never sees two messages at once and set_log_fn never races a write
+std::mutex gLogFnMutex;
+
+void write_to_sink(iggpu::LogLevel log_level, const std::string& msg) {
+  std::lock_guard<std::mutex> l(::gLogFnMutex);
+  ::gLogFn(log_level, msg);
+}
+
+// Per-thread scratch strings - assigning into them reuses their capacity, so
+//  formatting and passing messages to the sink doesn't allocate once warm
+std::string& thread_format_buffer() {
+  thread_local std::string buffer;
+  return buffer;
+}
+
+std::string& thread_sink_buffer() {
+  thread_local std::string buffer;
+  return buffer;
+}
+
+#ifndef __EMSCRIPTEN__
+
+// Bounded multi-producer queue (Vyukov), drained by a single consumer. Each
+//  cell's sequence number says whose turn it is: pos for the producer
+//  claiming position pos, pos + 1 for the consumer reading it.
+class LogQueue {
+ public:
+  explicit LogQueue(uint32_t capacity)
+      : cells_(new Cell[capacity]),
+        mask_(capacity - 1u),
+        enqueue_pos_(0u),
+        dequeue_pos_(0u) {
+    for (uint32_t i = 0; i < capacity; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bool try_push(iggpu::LogLevel log_level, std::string_view msg) {
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1u,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    // Cells keep their string's capacity (see try_pop), so this only
+    //  allocates for a message longer than any the cell held before
+    cell->log_level = log_level;
+    cell->msg.assign(msg);
+    cell->sequence.store(pos + 1u, std::memory_order_release);
+    return true;
+  }
+
+  // Single consumer only
+  bool try_pop(iggpu::LogLevel& log_level, std::string& msg) {
+    uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell& cell = cells_[pos & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != pos + 1u) {
+      return false;
+    }
+
+    // Swapped, not moved, so the cell gets the caller's buffer back
+    log_level = cell.log_level;
+    msg.swap(cell.msg);
+    cell.msg.clear();
+    cell.sequence.store(pos + mask_ + 1u, std::memory_order_release);
+    dequeue_pos_.store(pos + 1u, std::memory_order_release);
+    return true;
+  }
+
+  // Calls fn(data, size) for each message published but not yet consumed,
+  //  oldest first, without consuming them. Allocates nothing and takes no
+  //  locks, for the crash handler. Stops at a message still being written.
+  template <typename Fn>
+  void peek_pending(Fn&& fn) const {
+    uint64_t end = enqueue_pos_.load(std::memory_order_acquire);
+    for (uint64_t pos = dequeue_pos_.load(std::memory_order_acquire);
+         pos < end; pos++) {
+      const Cell& cell = cells_[pos & mask_];
+      if (cell.sequence.load(std::memory_order_acquire) != pos + 1u) {
+        return;
+      }
+      fn(cell.msg.data(), cell.msg.size());
+    }
+  }
+
+  // Positions claimed by producers / consumed so far
+  uint64_t enqueued() const {
+    return enqueue_pos_.load(std::memory_order_acquire);
+  }
+  uint64_t dequeued() const {
+    return dequeue_pos_.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Cell {
+    std::atomic<uint64_t> sequence;
+    iggpu::LogLevel log_level;
+    std::string msg;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  const uint64_t mask_;
+  alignas(64) std::atomic<uint64_t> enqueue_pos_;
+  alignas(64) std::atomic<uint64_t> dequeue_pos_;
+};
+
+struct AsyncLogState {
+  explicit AsyncLogState(uint32_t capacity)
+      : queue(capacity),
+        enabled(false),
+        running(false),
+        stop(false),
+        wake_seq(0u),
+        written(0u),
+        dropped(0u),
+        dropped_reported(0u),
+        consuming(false) {}
+
+  LogQueue queue;
+  std::atomic<bool> enabled;
+
+  // Set while drain_thread is running - read by flush_log instead of
+  //  drain_thread.joinable(), which isn't safe during a concurrent join
+  std::atomic<bool> running;
+  std::atomic<bool> stop;
+
+  // Bumped by producers to wake the drain thread
+  std::atomic<uint32_t> wake_seq;
+
+  // Messages passed to the sink (or dropped), for flush_log
+  std::atomic<uint64_t> written;
+
+  std::atomic<uint64_t> dropped;
+  uint64_t dropped_reported;
+
+  // Held by whoever is consuming (drain thread or crash handler)
+  std::atomic<bool> consuming;
+
+  std::thread drain_thread;
+};
+
+// Never freed - producers that raced disable_async_logging may still touch
+//  it during shutdown. Published (under gAsyncLogMutex) with release, read
+//  with acquire on every log call.
+std::atomic<AsyncLogState*> gAsyncLog{nullptr};
+std::mutex gAsyncLogMutex;
+
+const int kFatalSignals[] = {SIGSEGV, SIGABRT, SIGFPE, SIGILL};
+constexpr size_t kFatalSignalCount = sizeof(kFatalSignals) / sizeof(int);
+
+// Handlers installed before ours, chained to after queued messages are out
+#ifdef _WIN32
+using SignalHandler = void (*)(int);
+SignalHandler gPrevSignalHandlers[kFatalSignalCount];
+#else
+struct sigaction gPrevSignalHandlers[kFatalSignalCount];
+#endif
+
+uint32_t next_pow2(uint32_t v) {
+  uint32_t rsl = 2u;
+  while (rsl < v && rsl < (1u << 30)) {
+    rsl <<= 1;
+  }
+  return rsl;
+}
+
+// Writes every queued message. Returns the number written.
+uint64_t drain(AsyncLogState* state) {
+  uint64_t count = 0u;
+  iggpu::LogLevel log_level;
+  std::string msg;
+  while (state->queue.try_pop(log_level, msg)) {
+    ::write_to_sink(log_level, msg);
+    count++;
+  }
+
+  uint64_t dropped = state->dropped.load(std::memory_order_relaxed);
+  if (dropped != state->dropped_reported) {
+    ::write_to_sink(
+        iggpu::LogLevel::Warning,
+        "[IGGPU] Log queue full, dropped " +
+            std::to_string(dropped - state->dropped_reported) +
+            " messages");
+    state->dropped_reported = dropped;
+  }
+
+  return count;
+}
+
+void drain_thread_main(AsyncLogState* state) {
+  while (true) {
+    uint32_t seq = state->wake_seq.load(std::memory_order_acquire);
+
+    bool expected = false;
+    if (state->consuming.compare_exchange_strong(expected, true)) {
+      ::drain(state);
+      state->consuming.store(false);
+    }
+    state->written.store(state->queue.dequeued(), std::memory_order_release);
+    state->written.notify_all();
+
+    if (state->stop.load(std::memory_order_acquire) &&
+        state->queue.dequeued() == state->queue.enqueued()) {
+      return;
+    }
+
+    state->wake_seq.wait(seq, std::memory_order_acquire);
+  }
+}
+
+void stop_drain_thread() {
+  std::lock_guard<std::mutex> l(::gAsyncLogMutex);
+  AsyncLogState* state = ::gAsyncLog.load(std::memory_order_acquire);
+  if (!state || !state->drain_thread.joinable()) {
+    return;
+  }
+
+  state->enabled.store(false, std::memory_order_release);
+  state->stop.store(true, std::memory_order_release);
+  state->wake_seq.fetch_add(1u, std::memory_order_release);
+  state->wake_seq.notify_one();
+  state->drain_thread.join();
+  state->running.store(false, std::memory_order_release);
+  state->written.notify_all();
+}
+
+void write_stderr(const char* data, size_t size) {
+#ifdef _WIN32
+  ::_write(2, data, static_cast<unsigned int>(size));
+#else
+  while (size > 0u) {
+    ssize_t n = ::write(STDERR_FILENO, data, size);
+    if (n <= 0) {
+      return;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+#endif
+}
+
+// Writes messages still in the queue straight to stderr (the log fn may
+//  allocate or lock, so it can't be called here), then hands the signal to
+//  the previously installed handler. Only async-signal-safe calls: the
+//  messages are already formatted, and if the drain thread is mid-write
+//  (it may be the thread that crashed) the queue is left alone.
+void on_fatal_signal(int sig) {
+  AsyncLogState* state = ::gAsyncLog.load(std::memory_order_acquire);
+  if (state) {
+    bool expected = false;
+    if (state->consuming.compare_exchange_strong(expected, true)) {
+      state->queue.peek_pending(::write_stderr);
+    }
+  }
+
+  for (size_t i = 0; i < kFatalSignalCount; i++) {
+    if (kFatalSignals[i] != sig) {
+      continue;
+    }
+    // Re-raised once this handler returns (the signal is blocked until
+    //  then), which runs the previous handler - or the default action
+#ifdef _WIN32
+    std::signal(sig, ::gPrevSignalHandlers[i]);
+#else
+    ::sigaction(sig, &::gPrevSignalHandlers[i], nullptr);
+#endif
+  }
+  std::raise(sig);
+}
+
+void install_crash_handlers() {
+  for (size_t i = 0; i < kFatalSignalCount; i++) {
+#ifdef _WIN32
+    ::gPrevSignalHandlers[i] = std::signal(kFatalSignals[i], ::on_fatal_signal);
+#else
+    struct sigaction action {};
+    action.sa_handler = ::on_fatal_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = 0;
+    ::sigaction(kFatalSignals[i], &action, &::gPrevSignalHandlers[i]);
+#endif
+  }
+}
+
+#endif
+
 }  // namespace
 
 void iggpu::set_log_fn(
     std::function<void(LogLevel, const std::string&)> log_fn) {
+  std::lock_guard<std::mutex> l(::gLogFnMutex);
   if (!log_fn) {
     ::gLogFn = ::null_log_fn;
     return;
@@ -37,6 +354,120 @@ void iggpu::set_log_fn(
   ::gLogFn = log_fn;
 }
 
-void iggpu::log(LogLevel log_level, const std::string& msg) {
-  ::gLogFn(log_level, msg);
+void iggpu::log(LogLevel log_level, std::string_view msg) {
+  if (!log_enabled(log_level)) {
+    return;
+  }
+
+#ifndef __EMSCRIPTEN__
+  AsyncLogState* state = ::gAsyncLog.load(std::memory_order_acquire);
+  if (state && state->enabled.load(std::memory_order_acquire)) {
+    if (!state->queue.try_push(log_level, msg)) {
+      state->dropped.fetch_add(1u, std::memory_order_relaxed);
+      return;
+    }
+    state->wake_seq.fetch_add(1u, std::memory_order_release);
+    state->wake_seq.notify_one();
+    return;
+  }
+#endif
+
+  std::string& buffer = ::thread_sink_buffer();
+  buffer.assign(msg);
+  ::write_to_sink(log_level, buffer);
+}
+
+void iggpu::log_printf(LogLevel log_level, const char* fmt, ...) {
+  if (!log_enabled(log_level)) {
+    return;
+  }
+
+  // Formats into the thread's buffer at its current capacity - only messages
+  //  longer than any before on this thread grow it and format twice
+  std::string& buffer = ::thread_format_buffer();
+  if (buffer.size() < 256u) {
+    buffer.resize(256u);
+  }
+  buffer.resize(buffer.capacity());
+
+  std::va_list args;
+  va_start(args, fmt);
+  int len = std::vsnprintf(buffer.data(), buffer.size() + 1u, fmt, args);
+  va_end(args);
+  if (len < 0) {
+    return;
+  }
+
+  if (static_cast<size_t>(len) > buffer.size()) {
+    buffer.resize(len);
+    va_start(args, fmt);
+    std::vsnprintf(buffer.data(), buffer.size() + 1u, fmt, args);
+    va_end(args);
+  }
+  iggpu::log(log_level, std::string_view(buffer.data(), len));
+}
+
+void iggpu::enable_async_logging(uint32_t queue_capacity) {
+#ifndef __EMSCRIPTEN__
+  std::lock_guard<std::mutex> l(::gAsyncLogMutex);
+  AsyncLogState* state = ::gAsyncLog.load(std::memory_order_acquire);
+  if (!state) {
+    state = new AsyncLogState(::next_pow2(queue_capacity));
+    ::gAsyncLog.store(state, std::memory_order_release);
+    std::atexit(::stop_drain_thread);
+    ::install_crash_handlers();
+  }
+
+  if (state->drain_thread.joinable()) {
+    return;
+  }
+
+  state->stop.store(false, std::memory_order_release);
+  state->drain_thread = std::thread(::drain_thread_main, state);
+  state->running.store(true, std::memory_order_release);
+  state->enabled.store(true, std::memory_order_release);
+#endif
+}
+
+void iggpu::disable_async_logging() {
+#ifndef __EMSCRIPTEN__
+  ::stop_drain_thread();
+#endif
+}
+
+bool iggpu::async_logging_enabled() {
+#ifndef __EMSCRIPTEN__
+  AsyncLogState* state = ::gAsyncLog.load(std::memory_order_acquire);
+  return state && state->enabled.load(std::memory_order_acquire);
+#else
+  return false;
+#endif
+}
+
+void iggpu::flush_log() {
+#ifndef __EMSCRIPTEN__
+  AsyncLogState* state = ::gAsyncLog.load(std::memory_order_acquire);
+  if (!state || !state->enabled.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  uint64_t target = state->queue.enqueued();
+  state->wake_seq.fetch_add(1u, std::memory_order_release);
+  state->wake_seq.notify_one();
+
+  uint64_t written = state->written.load(std::memory_order_acquire);
+  while (written < target && state->running.load(std::memory_order_acquire)) {
+    state->written.wait(written, std::memory_order_acquire);
+    written = state->written.load(std::memory_order_acquire);
+  }
+#endif
+}
+
+uint64_t iggpu::dropped_log_count() {
+#ifndef __EMSCRIPTEN__
+  AsyncLogState* state = ::gAsyncLog.load(std::memory_order_acquire);
+  return state ? state->dropped.load(std::memory_order_relaxed) : 0u;
+#else
+  return 0u;
+#endif
 }
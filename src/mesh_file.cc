@@ -0,0 +1,628 @@
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+#include <iggpu/mesh_file.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/fetch.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+uint64_t align_up(uint64_t v, uint64_t alignment) {
+  return (v + alignment - 1u) / alignment * alignment;
+}
+
+// True if [offset, offset + size) lies within size_limit bytes
+bool in_range(uint64_t offset, uint64_t size, uint64_t size_limit) {
+  return offset <= size_limit && size <= size_limit - offset;
+}
+
+const iggpu::MeshFileAttribute* find_position(
+    const std::vector<iggpu::MeshFileAttribute>& attributes) {
+  for (const auto& attribute : attributes) {
+    if (attribute.semantic == iggpu::MeshAttributeSemantic::Position &&
+        attribute.format == iggpu::MeshAttributeFormat::Float32x3) {
+      return &attribute;
+    }
+  }
+  return nullptr;
+}
+
+void read_position(const iggpu::MeshFileDesc& desc,
+                   const iggpu::MeshFileAttribute& position, uint32_t vertex,
+                   float out[3]) {
+  std::memcpy(out,
+              desc.vertex_data.data() +
+                  static_cast<uint64_t>(vertex) * desc.vertex_stride +
+                  position.offset,
+              3u * sizeof(float));
+}
+
+// Sphere around the box of the submesh's vertices (center xyz, radius w)
+void submesh_bounds(const iggpu::MeshFileDesc& desc,
+                    const iggpu::MeshFileAttribute& position,
+                    const iggpu::MeshFileSubmesh& submesh, float out[4]) {
+  float lo[3] = {0.f, 0.f, 0.f};
+  float hi[3] = {0.f, 0.f, 0.f};
+  float p[3];
+  for (uint32_t i = 0u; i < submesh.index_count; i++) {
+    ::read_position(desc, position,
+                    desc.indices[submesh.first_index + i] + submesh.base_vertex,
+                    p);
+    for (int c = 0; c < 3; c++) {
+      lo[c] = i == 0u ? p[c] : std::min(lo[c], p[c]);
+      hi[c] = i == 0u ? p[c] : std::max(hi[c], p[c]);
+    }
+  }
+
+  float center[3];
+  for (int c = 0; c < 3; c++) {
+    center[c] = (lo[c] + hi[c]) * 0.5f;
+  }
+  float radius_sq = 0.f;
+  for (uint32_t i = 0u; i < submesh.index_count; i++) {
+    ::read_position(desc, position,
+                    desc.indices[submesh.first_index + i] + submesh.base_vertex,
+                    p);
+    float dx = p[0] - center[0];
+    float dy = p[1] - center[1];
+    float dz = p[2] - center[2];
+    radius_sq = std::max(radius_sq, dx * dx + dy * dy + dz * dz);
+  }
+
+  out[0] = center[0];
+  out[1] = center[1];
+  out[2] = center[2];
+  out[3] = std::sqrt(radius_sq);
+}
+
+bool write_padding(std::FILE* f, uint64_t& pos, uint64_t target) {
+  static const uint8_t kZeros[256] = {};
+  while (pos < target) {
+    size_t n = static_cast<size_t>(std::min<uint64_t>(target - pos, 256u));
+    if (std::fwrite(kZeros, 1, n, f) != n) {
+      return false;
+    }
+    pos += n;
+  }
+  return true;
+}
+
+bool write_bytes(std::FILE* f, uint64_t& pos, const void* data, size_t size) {
+  if (size > 0u && std::fwrite(data, 1, size, f) != size) {
+    return false;
+  }
+  pos += size;
+  return true;
+}
+
+// Blobs are padded to 4 bytes in the file, so the buffer (whose size must be
+//  a multiple of 4) is filled in one copy
+wgpu::Buffer create_filled_buffer(iggpu::AppBase* app_base,
+                                  std::span<const uint8_t> data,
+                                  wgpu::BufferUsage usage, const char* tag) {
+  wgpu::BufferDescriptor bd{};
+  bd.size = std::max<uint64_t>(data.size(), 4u);
+  bd.usage = usage | wgpu::BufferUsage::CopyDst;
+
+#ifdef __EMSCRIPTEN__
+  wgpu::Buffer buffer = iggpu::create_buffer(app_base->Device, bd, tag);
+  if (buffer && !data.empty()) {
+    app_base->Queue.WriteBuffer(buffer, 0, data.data(), data.size());
+  }
+  return buffer;
+#else
+  bd.mappedAtCreation = true;
+  wgpu::Buffer buffer = iggpu::create_buffer(app_base->Device, bd, tag);
+  if (!buffer) {
+    return nullptr;
+  }
+  void* dst = buffer.GetMappedRange(0, bd.size);
+  if (dst == nullptr) {
+    iggpu::destroy_buffer(buffer);
+    return nullptr;
+  }
+  if (!data.empty()) {
+    std::memcpy(dst, data.data(), data.size());
+  }
+  buffer.Unmap();
+  return buffer;
+#endif
+}
+
+#ifndef __EMSCRIPTEN__
+// Read-only mapping of a whole file
+class MappedFile {
+ public:
+  MappedFile() : data_(nullptr), size_(0u) {}
+  ~MappedFile() { unmap(); }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool map(const std::string& path, iggpu::MeshFileError& err);
+  std::span<const uint8_t> data() const { return {data_, size_}; }
+
+ private:
+  void unmap();
+
+  const uint8_t* data_;
+  size_t size_;
+};
+
+#ifdef _WIN32
+bool MappedFile::map(const std::string& path, iggpu::MeshFileError& err) {
+  HANDLE file =
+      CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    err = iggpu::MeshFileError::OpenFailed;
+    return false;
+  }
+
+  LARGE_INTEGER file_size{};
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    err = iggpu::MeshFileError::ReadFailed;
+    return false;
+  }
+  if (file_size.QuadPart == 0) {
+    CloseHandle(file);
+    err = iggpu::MeshFileError::InvalidFile;
+    return false;
+  }
+
+  // The view keeps the file and mapping objects alive
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    err = iggpu::MeshFileError::ReadFailed;
+    return false;
+  }
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (view == nullptr) {
+    err = iggpu::MeshFileError::ReadFailed;
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t*>(view);
+  size_ = static_cast<size_t>(file_size.QuadPart);
+  return true;
+}
+
+void MappedFile::unmap() {
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+    data_ = nullptr;
+    size_ = 0u;
+  }
+}
+#else
+bool MappedFile::map(const std::string& path, iggpu::MeshFileError& err) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    err = iggpu::MeshFileError::OpenFailed;
+    return false;
+  }
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    err = iggpu::MeshFileError::ReadFailed;
+    return false;
+  }
+  if (st.st_size == 0) {
+    ::close(fd);
+    err = iggpu::MeshFileError::InvalidFile;
+    return false;
+  }
+
+  // The mapping stays valid after the descriptor is closed
+  void* mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                         MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    err = iggpu::MeshFileError::ReadFailed;
+    return false;
+  }
+
+  // Every page is read once, front to back - start reading ahead now
+  ::madvise(mapping, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+
+  data_ = static_cast<const uint8_t*>(mapping);
+  size_ = static_cast<size_t>(st.st_size);
+  return true;
+}
+
+void MappedFile::unmap() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0u;
+  }
+}
+#endif
+#endif
+
+#ifdef __EMSCRIPTEN__
+struct PendingFetch {
+  iggpu::AppBase* app_base;
+  const char* tag;
+  std::shared_ptr<igasync::Promise<iggpu::MeshLoadRsl>> promise;
+};
+#endif
+
+}  // namespace
+
+namespace iggpu {
+
+uint32_t mesh_attribute_size(MeshAttributeFormat format) {
+  switch (format) {
+    case MeshAttributeFormat::Float32:
+    case MeshAttributeFormat::Unorm8x4:
+    case MeshAttributeFormat::Snorm8x4:
+    case MeshAttributeFormat::Uint32:
+      return 4u;
+    case MeshAttributeFormat::Float32x2:
+      return 8u;
+    case MeshAttributeFormat::Float32x3:
+      return 12u;
+    case MeshAttributeFormat::Float32x4:
+      return 16u;
+  }
+  return 0u;
+}
+
+wgpu::VertexFormat to_vertex_format(MeshAttributeFormat format) {
+  switch (format) {
+    case MeshAttributeFormat::Float32:
+      return wgpu::VertexFormat::Float32;
+    case MeshAttributeFormat::Float32x2:
+      return wgpu::VertexFormat::Float32x2;
+    case MeshAttributeFormat::Float32x3:
+      return wgpu::VertexFormat::Float32x3;
+    case MeshAttributeFormat::Float32x4:
+      return wgpu::VertexFormat::Float32x4;
+    case MeshAttributeFormat::Unorm8x4:
+      return wgpu::VertexFormat::Unorm8x4;
+    case MeshAttributeFormat::Snorm8x4:
+      return wgpu::VertexFormat::Snorm8x4;
+    case MeshAttributeFormat::Uint32:
+      return wgpu::VertexFormat::Uint32;
+  }
+  return wgpu::VertexFormat::Float32;
+}
+
+MeshFileParseRsl parse_mesh_file(std::span<const uint8_t> data) {
+  if (data.size() < sizeof(MeshFileHeader)) {
+    return MeshFileError::InvalidFile;
+  }
+
+  MeshFileView view{};
+  std::memcpy(&view.header, data.data(), sizeof(MeshFileHeader));
+  const MeshFileHeader& h = view.header;
+  if (h.magic != kMeshFileMagic) {
+    return MeshFileError::InvalidFile;
+  }
+  if (h.version != kMeshFileVersion) {
+    return MeshFileError::UnsupportedVersion;
+  }
+  if (h.index_format != MeshIndexFormat::Uint16 &&
+      h.index_format != MeshIndexFormat::Uint32) {
+    return MeshFileError::InvalidFile;
+  }
+
+  uint64_t index_size = h.index_format == MeshIndexFormat::Uint16 ? 2u : 4u;
+  if (h.vertex_data_size > data.size() || h.index_data_size > data.size()) {
+    return MeshFileError::InvalidFile;
+  }
+  uint64_t vertex_data_size = ::align_up(h.vertex_data_size, 4u);
+  uint64_t index_data_size = ::align_up(h.index_data_size, 4u);
+  if (h.vertex_stride == 0u ||
+      static_cast<uint64_t>(h.vertex_count) * h.vertex_stride >
+          h.vertex_data_size ||
+      h.index_count * index_size > h.index_data_size ||
+      !::in_range(h.attributes_offset,
+                  uint64_t{h.attribute_count} * sizeof(MeshFileAttribute),
+                  data.size()) ||
+      !::in_range(h.submeshes_offset,
+                  uint64_t{h.submesh_count} * sizeof(MeshFileSubmesh),
+                  data.size()) ||
+      !::in_range(h.vertex_data_offset, vertex_data_size, data.size()) ||
+      !::in_range(h.index_data_offset, index_data_size, data.size())) {
+    return MeshFileError::InvalidFile;
+  }
+
+  view.attributes.resize(h.attribute_count);
+  std::memcpy(view.attributes.data(), data.data() + h.attributes_offset,
+              h.attribute_count * sizeof(MeshFileAttribute));
+  for (const auto& attribute : view.attributes) {
+    uint32_t size = mesh_attribute_size(attribute.format);
+    if (size == 0u ||
+        static_cast<uint64_t>(attribute.offset) + size > h.vertex_stride) {
+      return MeshFileError::InvalidFile;
+    }
+  }
+
+  view.submeshes.resize(h.submesh_count);
+  std::memcpy(view.submeshes.data(), data.data() + h.submeshes_offset,
+              h.submesh_count * sizeof(MeshFileSubmesh));
+  for (const auto& submesh : view.submeshes) {
+    if (!::in_range(submesh.first_index, submesh.index_count,
+                    h.index_count) ||
+        static_cast<int64_t>(submesh.base_vertex) >= h.vertex_count) {
+      return MeshFileError::InvalidFile;
+    }
+  }
+
+  view.vertex_data = data.subspan(h.vertex_data_offset, vertex_data_size);
+  view.index_data = data.subspan(h.index_data_offset, index_data_size);
+  return view;
+}
+
+MeshFileWriteRsl write_mesh_file(const std::string& path,
+                                 const MeshFileDesc& desc) {
+  if (desc.vertex_stride == 0u ||
+      desc.vertex_data.size() % desc.vertex_stride != 0u) {
+    IGGPU_LOG_ERROR(
+        "[IGGPU] Mesh vertex data is not a whole number of %u byte vertices",
+        desc.vertex_stride);
+    return MeshFileError::InvalidFile;
+  }
+  uint64_t vertex_count = desc.vertex_data.size() / desc.vertex_stride;
+  for (const auto& attribute : desc.attributes) {
+    uint32_t size = mesh_attribute_size(attribute.format);
+    if (size == 0u ||
+        static_cast<uint64_t>(attribute.offset) + size > desc.vertex_stride) {
+      IGGPU_LOG_ERROR("[IGGPU] Mesh attribute at offset %u exceeds stride %u",
+                      attribute.offset, desc.vertex_stride);
+      return MeshFileError::InvalidFile;
+    }
+  }
+
+  // A mesh without submeshes gets one covering every index
+  std::vector<MeshFileSubmesh> submeshes = desc.submeshes;
+  if (submeshes.empty() && !desc.indices.empty()) {
+    submeshes.push_back(MeshFileSubmesh{
+        0u, static_cast<uint32_t>(desc.indices.size()), 0, 0u, {}});
+  }
+
+  uint32_t max_index = 0u;
+  for (uint32_t index : desc.indices) {
+    max_index = std::max(max_index, index);
+  }
+  for (const auto& submesh : submeshes) {
+    if (!::in_range(submesh.first_index, submesh.index_count,
+                    desc.indices.size())) {
+      IGGPU_LOG_ERROR("[IGGPU] Mesh submesh indices [%u, %u) out of range",
+                      submesh.first_index,
+                      submesh.first_index + submesh.index_count);
+      return MeshFileError::InvalidFile;
+    }
+    if (static_cast<int64_t>(submesh.base_vertex) >=
+        static_cast<int64_t>(vertex_count)) {
+      IGGPU_LOG_ERROR("[IGGPU] Mesh submesh base vertex %d out of range",
+                      submesh.base_vertex);
+      return MeshFileError::InvalidFile;
+    }
+    for (uint32_t i = 0u; i < submesh.index_count; i++) {
+      int64_t vertex = static_cast<int64_t>(
+                           desc.indices[submesh.first_index + i]) +
+                       submesh.base_vertex;
+      if (vertex < 0 || vertex >= static_cast<int64_t>(vertex_count)) {
+        IGGPU_LOG_ERROR(
+            "[IGGPU] Mesh index %lld out of range (%llu vertices)",
+            static_cast<long long>(vertex),
+            static_cast<unsigned long long>(vertex_count));
+        return MeshFileError::InvalidFile;
+      }
+    }
+  }
+
+  MeshFileHeader h{};
+  h.magic = kMeshFileMagic;
+  h.version = kMeshFileVersion;
+  h.vertex_stride = desc.vertex_stride;
+  h.vertex_count = static_cast<uint32_t>(vertex_count);
+  h.index_count = static_cast<uint32_t>(desc.indices.size());
+  // 0xFFFF is left out - it restarts strips
+  h.index_format = max_index < 0xFFFFu ? MeshIndexFormat::Uint16
+                                       : MeshIndexFormat::Uint32;
+  h.attribute_count = static_cast<uint32_t>(desc.attributes.size());
+  h.submesh_count = static_cast<uint32_t>(submeshes.size());
+
+  h.attributes_offset = sizeof(MeshFileHeader);
+  h.submeshes_offset =
+      h.attributes_offset + h.attribute_count * sizeof(MeshFileAttribute);
+  h.vertex_data_offset =
+      ::align_up(h.submeshes_offset + h.submesh_count * sizeof(MeshFileSubmesh),
+                 kMeshFileAlignment);
+  h.vertex_data_size = desc.vertex_data.size();
+  h.index_data_offset = ::align_up(
+      h.vertex_data_offset + ::align_up(h.vertex_data_size, 4u),
+      kMeshFileAlignment);
+  h.index_data_size =
+      uint64_t{h.index_count} *
+      (h.index_format == MeshIndexFormat::Uint16 ? 2u : 4u);
+
+  if (const MeshFileAttribute* position = ::find_position(desc.attributes)) {
+    float p[3];
+    for (uint32_t v = 0u; v < h.vertex_count; v++) {
+      ::read_position(desc, *position, v, p);
+      for (int c = 0; c < 3; c++) {
+        h.bounds_min[c] = v == 0u ? p[c] : std::min(h.bounds_min[c], p[c]);
+        h.bounds_max[c] = v == 0u ? p[c] : std::max(h.bounds_max[c], p[c]);
+      }
+    }
+    for (auto& submesh : submeshes) {
+      ::submesh_bounds(desc, *position, submesh, submesh.bounds);
+    }
+  }
+
+  std::vector<uint16_t> indices_u16;
+  const void* index_data = desc.indices.data();
+  if (h.index_format == MeshIndexFormat::Uint16) {
+    indices_u16.assign(desc.indices.begin(), desc.indices.end());
+    index_data = indices_u16.data();
+  }
+
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (f == nullptr) {
+    IGGPU_LOG_ERROR("[IGGPU] Failed to open %s for writing", path.c_str());
+    return MeshFileError::OpenFailed;
+  }
+
+  uint64_t pos = 0u;
+  bool ok =
+      ::write_bytes(f, pos, &h, sizeof(h)) &&
+      ::write_bytes(f, pos, desc.attributes.data(),
+                    h.attribute_count * sizeof(MeshFileAttribute)) &&
+      ::write_bytes(f, pos, submeshes.data(),
+                    h.submesh_count * sizeof(MeshFileSubmesh)) &&
+      ::write_padding(f, pos, h.vertex_data_offset) &&
+      ::write_bytes(f, pos, desc.vertex_data.data(), h.vertex_data_size) &&
+      ::write_padding(f, pos, h.index_data_offset) &&
+      ::write_bytes(f, pos, index_data, h.index_data_size) &&
+      ::write_padding(f, pos,
+                      h.index_data_offset + ::align_up(h.index_data_size, 4u));
+  ok = std::fclose(f) == 0 && ok;
+  if (!ok) {
+    IGGPU_LOG_ERROR("[IGGPU] Failed to write %s", path.c_str());
+    return MeshFileError::WriteFailed;
+  }
+
+  return pos;
+}
+
+std::vector<wgpu::VertexAttribute> LoadedMesh::vertex_attributes() const {
+  std::vector<wgpu::VertexAttribute> out;
+  out.reserve(attributes.size());
+  for (const auto& attribute : attributes) {
+    wgpu::VertexAttribute va{};
+    va.format = to_vertex_format(attribute.format);
+    va.offset = attribute.offset;
+    va.shaderLocation = attribute.shader_location;
+    out.push_back(va);
+  }
+  return out;
+}
+
+void LoadedMesh::destroy() {
+  iggpu::destroy_buffer(vertex_buffer);
+  iggpu::destroy_buffer(index_buffer);
+}
+
+MeshLoadRsl load_mesh_from_memory(AppBase* app_base,
+                                  std::span<const uint8_t> data,
+                                  const char* tag) {
+  auto parse_rsl = parse_mesh_file(data);
+  if (std::holds_alternative<MeshFileError>(parse_rsl)) {
+    return std::get<MeshFileError>(parse_rsl);
+  }
+  MeshFileView& view = std::get<MeshFileView>(parse_rsl);
+
+  LoadedMesh mesh{};
+  mesh.vertex_buffer = ::create_filled_buffer(
+      app_base, view.vertex_data, wgpu::BufferUsage::Vertex, tag);
+  mesh.index_buffer = ::create_filled_buffer(
+      app_base, view.index_data, wgpu::BufferUsage::Index, tag);
+  if (!mesh.vertex_buffer || !mesh.index_buffer) {
+    mesh.destroy();
+    return MeshFileError::BufferCreationFailed;
+  }
+
+  const MeshFileHeader& h = view.header;
+  mesh.index_format = h.index_format == MeshIndexFormat::Uint16
+                          ? wgpu::IndexFormat::Uint16
+                          : wgpu::IndexFormat::Uint32;
+  mesh.vertex_stride = h.vertex_stride;
+  mesh.vertex_count = h.vertex_count;
+  mesh.index_count = h.index_count;
+  mesh.attributes = std::move(view.attributes);
+  mesh.submeshes = std::move(view.submeshes);
+  std::memcpy(mesh.bounds_min, h.bounds_min, sizeof(mesh.bounds_min));
+  std::memcpy(mesh.bounds_max, h.bounds_max, sizeof(mesh.bounds_max));
+  return mesh;
+}
+
+#ifndef __EMSCRIPTEN__
+MeshLoadRsl load_mesh_file(AppBase* app_base, const std::string& path,
+                           const char* tag) {
+  ::MappedFile file;
+  MeshFileError err{};
+  if (!file.map(path, err)) {
+    IGGPU_LOG_ERROR("[IGGPU] Failed to map mesh file %s (%s)", path.c_str(),
+                    mesh_file_error_text(err).c_str());
+    return err;
+  }
+
+  auto rsl = load_mesh_from_memory(app_base, file.data(), tag);
+  if (std::holds_alternative<MeshFileError>(rsl)) {
+    IGGPU_LOG_ERROR(
+        "[IGGPU] Failed to load mesh file %s (%s)", path.c_str(),
+        mesh_file_error_text(std::get<MeshFileError>(rsl)).c_str());
+  }
+  return rsl;
+}
+#endif
+
+std::shared_ptr<igasync::Promise<MeshLoadRsl>> load_mesh_file_async(
+    AppBase* app_base, const std::string& path, const char* tag) {
+  auto promise = igasync::Promise<MeshLoadRsl>::Create();
+
+#ifdef __EMSCRIPTEN__
+  emscripten_fetch_attr_t attr;
+  emscripten_fetch_attr_init(&attr);
+  std::strcpy(attr.requestMethod, "GET");
+  attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
+  attr.userData = new ::PendingFetch{app_base, tag, promise};
+  attr.onsuccess = [](emscripten_fetch_t* fetch) {
+    auto* pending = static_cast<::PendingFetch*>(fetch->userData);
+    std::span<const uint8_t> data(
+        reinterpret_cast<const uint8_t*>(fetch->data),
+        static_cast<size_t>(fetch->numBytes));
+    auto rsl = load_mesh_from_memory(pending->app_base, data, pending->tag);
+    if (std::holds_alternative<MeshFileError>(rsl)) {
+      IGGPU_LOG_ERROR(
+          "[IGGPU] Failed to load mesh file %s (%s)", fetch->url,
+          mesh_file_error_text(std::get<MeshFileError>(rsl)).c_str());
+    }
+    emscripten_fetch_close(fetch);
+    pending->promise->resolve(std::move(rsl));
+    delete pending;
+  };
+  attr.onerror = [](emscripten_fetch_t* fetch) {
+    auto* pending = static_cast<::PendingFetch*>(fetch->userData);
+    IGGPU_LOG_ERROR("[IGGPU] Failed to fetch mesh file %s (HTTP %u)",
+                    fetch->url, static_cast<uint32_t>(fetch->status));
+    MeshFileError err = fetch->status == 404u ? MeshFileError::OpenFailed
+                                              : MeshFileError::ReadFailed;
+    emscripten_fetch_close(fetch);
+    pending->promise->resolve(err);
+    delete pending;
+  };
+  emscripten_fetch(&attr, path.c_str());
+#else
+  promise->resolve(load_mesh_file(app_base, path, tag));
+#endif
+
+  return promise;
+}
+
+}  // namespace iggpu
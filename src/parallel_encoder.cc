@@ -0,0 +1,153 @@
+#include <igasync/task.h>
+#include <iggpu/log.h>
+#include <iggpu/parallel_encoder.h>
+
+#include <chrono>
+
+namespace iggpu {
+
+ParallelEncoder::ParallelEncoder(AppBase* app_base, uint32_t worker_count)
+    : app_base_(app_base),
+      task_list_(igasync::TaskList::Create()),
+      batch_generation_(0u),
+      shutdown_(false),
+      jobs_remaining_(0u),
+      worker_jobs_(0u),
+      stats_{} {
+#ifdef __EMSCRIPTEN__
+  // WebGPU objects can't be used from web workers here - record inline
+  worker_count = 0u;
+#else
+  if (worker_count > 0u &&
+      !app_base_->Device.HasFeature(
+          wgpu::FeatureName::ImplicitDeviceSynchronization)) {
+    iggpu::log(LogLevel::Warning,
+               "[IGGPU] ParallelEncoder: device is not thread safe "
+               "(no ImplicitDeviceSynchronization), recording on one "
+               "thread");
+    worker_count = 0u;
+  }
+#endif
+
+  for (uint32_t i = 0; i < worker_count; i++) {
+    workers_.emplace_back([this]() { worker_loop(); });
+  }
+}
+
+ParallelEncoder::~ParallelEncoder() {
+  {
+    std::lock_guard<std::mutex> l(mut_);
+    shutdown_ = true;
+  }
+  work_cv_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+uint32_t ParallelEncoder::default_worker_count() {
+  uint32_t hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 1u ? hardware_threads - 1u : 0u;
+}
+
+std::vector<wgpu::CommandBuffer> ParallelEncoder::record(
+    const std::vector<EncoderJob>& jobs) {
+  std::vector<wgpu::CommandBuffer> command_buffers(jobs.size());
+  run_batch(static_cast<uint32_t>(jobs.size()), [&](uint32_t i) {
+    wgpu::CommandEncoder encoder = app_base_->Device.CreateCommandEncoder();
+    jobs[i](encoder);
+    command_buffers[i] = encoder.Finish();
+  });
+  return command_buffers;
+}
+
+std::vector<wgpu::RenderBundle> ParallelEncoder::record_bundles(
+    const wgpu::RenderBundleEncoderDescriptor& desc,
+    const std::vector<BundleJob>& jobs) {
+  std::vector<wgpu::RenderBundle> bundles(jobs.size());
+  run_batch(static_cast<uint32_t>(jobs.size()), [&](uint32_t i) {
+    wgpu::RenderBundleEncoder encoder =
+        app_base_->Device.CreateRenderBundleEncoder(&desc);
+    jobs[i](encoder);
+    bundles[i] = encoder.Finish();
+  });
+  return bundles;
+}
+
+void ParallelEncoder::submit(const std::vector<EncoderJob>& jobs) {
+  std::vector<wgpu::CommandBuffer> command_buffers = record(jobs);
+  app_base_->Queue.Submit(command_buffers.size(), command_buffers.data());
+}
+
+void ParallelEncoder::run_batch(uint32_t job_count,
+                                const std::function<void(uint32_t)>& job) {
+  auto start = std::chrono::steady_clock::now();
+  stats_.batches++;
+  stats_.jobs += job_count;
+
+  if (workers_.empty() || job_count <= 1u) {
+    for (uint32_t i = 0; i < job_count; i++) {
+      job(i);
+    }
+  } else {
+    {
+      std::lock_guard<std::mutex> l(mut_);
+      jobs_remaining_ = job_count;
+    }
+
+    std::thread::id calling_thread = std::this_thread::get_id();
+    for (uint32_t i = 0; i < job_count; i++) {
+      task_list_->schedule(igasync::Task::Of([this, &job, i, calling_thread]() {
+        job(i);
+        if (std::this_thread::get_id() != calling_thread) {
+          worker_jobs_++;
+        }
+
+        std::lock_guard<std::mutex> l(mut_);
+        if (--jobs_remaining_ == 0u) {
+          done_cv_.notify_all();
+        }
+      }));
+    }
+
+    {
+      std::lock_guard<std::mutex> l(mut_);
+      batch_generation_++;
+    }
+    work_cv_.notify_all();
+
+    // The calling thread helps instead of idling
+    while (task_list_->execute_next()) {
+    }
+
+    std::unique_lock<std::mutex> l(mut_);
+    done_cv_.wait(l, [this]() { return jobs_remaining_ == 0u; });
+  }
+
+  stats_.worker_jobs = worker_jobs_.load();
+  stats_.last_batch_ms = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+}
+
+void ParallelEncoder::worker_loop() {
+  uint64_t seen_generation = 0u;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> l(mut_);
+      work_cv_.wait(l, [&]() {
+        return shutdown_ || batch_generation_ != seen_generation;
+      });
+      if (shutdown_) {
+        return;
+      }
+      seen_generation = batch_generation_;
+    }
+
+    while (task_list_->execute_next()) {
+    }
+  }
+}
+
+}  // namespace iggpu
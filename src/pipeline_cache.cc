@@ -0,0 +1,246 @@
+#include <iggpu/log.h>
+#include <iggpu/pipeline_cache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+const char kEntryMagic[4] = {'I', 'G', 'P', 'C'};
+const char kStartupBaselineFile[] = "cold_startup_ms.txt";
+
+uint64_t fnv1a64(const std::string& data) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// Adapter descriptions contain all sorts of characters - keep the ones that
+//  are safe in a path on every platform
+std::string sanitize_path_component(const std::string& s) {
+  std::string out;
+  for (char c : s) {
+    bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+    out += safe ? c : '_';
+  }
+  return out.empty() ? "default" : out;
+}
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+namespace iggpu {
+
+PipelineCache::PipelineCache(std::string cache_dir)
+    : cache_dir_(std::move(cache_dir)), stats_{} {}
+
+void PipelineCache::set_adapter_key(const std::string& adapter_key) {
+  std::lock_guard<std::mutex> l(mut_);
+  entries_.clear();
+  known_missing_.clear();
+  adapter_dir_.clear();
+
+  if (cache_dir_.empty()) {
+    return;
+  }
+
+  std::filesystem::path dir = std::filesystem::path(cache_dir_) /
+                              ("v" + std::to_string(kCacheVersion)) /
+                              ::sanitize_path_component(adapter_key);
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    IGGPU_LOG_WARNING(
+        "[IGGPU] Could not create pipeline cache directory %s, cache will "
+        "not persist",
+        dir.string().c_str());
+    return;
+  }
+  adapter_dir_ = dir.string();
+}
+
+std::string PipelineCache::entry_path(const std::string& key) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin",
+                static_cast<unsigned long long>(::fnv1a64(key)));
+  return (std::filesystem::path(adapter_dir_) / name).string();
+}
+
+bool PipelineCache::read_entry(const std::string& key,
+                               std::vector<uint8_t>& out) const {
+  std::ifstream f(entry_path(key), std::ios::binary);
+  if (!f) {
+    return false;
+  }
+
+  char magic[4];
+  uint64_t key_size = 0u, value_size = 0u;
+  f.read(magic, sizeof(magic));
+  f.read(reinterpret_cast<char*>(&key_size), sizeof(key_size));
+  if (!f || std::memcmp(magic, ::kEntryMagic, sizeof(magic)) != 0 ||
+      key_size != key.size()) {
+    return false;
+  }
+
+  // Entries are named by key hash - make sure this isn't a collision
+  std::string stored_key(key_size, '\0');
+  f.read(stored_key.data(), key_size);
+  if (!f || stored_key != key) {
+    return false;
+  }
+
+  f.read(reinterpret_cast<char*>(&value_size), sizeof(value_size));
+  if (!f) {
+    return false;
+  }
+  out.resize(value_size);
+  f.read(reinterpret_cast<char*>(out.data()), value_size);
+  return static_cast<bool>(f);
+}
+
+void PipelineCache::write_entry(const std::string& key, const void* value,
+                                size_t value_size) const {
+  // Write to a temporary file and rename, so that a crash mid-write (or
+  //  another process reading the cache) never sees a partial entry
+  std::string path = entry_path(key);
+  std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream f(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!f) {
+      return;
+    }
+
+    uint64_t key_size = key.size();
+    uint64_t value_size_64 = value_size;
+    f.write(::kEntryMagic, sizeof(::kEntryMagic));
+    f.write(reinterpret_cast<const char*>(&key_size), sizeof(key_size));
+    f.write(key.data(), key.size());
+    f.write(reinterpret_cast<const char*>(&value_size_64),
+            sizeof(value_size_64));
+    f.write(reinterpret_cast<const char*>(value), value_size);
+    if (!f) {
+      return;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+  }
+}
+
+size_t PipelineCache::load(const void* key, size_t key_size, void* value,
+                           size_t value_size) {
+  auto start = std::chrono::steady_clock::now();
+  std::string key_str(reinterpret_cast<const char*>(key), key_size);
+  bool is_size_query = value == nullptr || value_size == 0u;
+
+  std::lock_guard<std::mutex> l(mut_);
+  auto it = entries_.find(key_str);
+  if (it == entries_.end() && is_persistent() &&
+      known_missing_.count(key_str) == 0u) {
+    std::vector<uint8_t> data;
+    if (read_entry(key_str, data)) {
+      it = entries_.emplace(key_str, std::move(data)).first;
+    } else {
+      known_missing_.insert(key_str);
+    }
+  }
+  stats_.load_ms += ::ms_since(start);
+
+  if (it == entries_.end()) {
+    if (is_size_query) stats_.misses++;
+    return 0u;
+  }
+
+  if (is_size_query) {
+    stats_.hits++;
+    return it->second.size();
+  }
+
+  size_t copy_size = std::min(value_size, it->second.size());
+  std::memcpy(value, it->second.data(), copy_size);
+  stats_.bytes_loaded += copy_size;
+  return copy_size;
+}
+
+void PipelineCache::store(const void* key, size_t key_size, const void* value,
+                          size_t value_size) {
+  auto start = std::chrono::steady_clock::now();
+  std::string key_str(reinterpret_cast<const char*>(key), key_size);
+  const uint8_t* value_bytes = reinterpret_cast<const uint8_t*>(value);
+
+  std::lock_guard<std::mutex> l(mut_);
+  entries_[key_str] = std::vector<uint8_t>(value_bytes, value_bytes + value_size);
+  known_missing_.erase(key_str);
+  if (is_persistent()) {
+    write_entry(key_str, value, value_size);
+  }
+
+  stats_.stores++;
+  stats_.bytes_stored += value_size;
+  stats_.store_ms += ::ms_since(start);
+}
+
+PipelineCacheStats PipelineCache::stats() const {
+  std::lock_guard<std::mutex> l(mut_);
+  return stats_;
+}
+
+void PipelineCache::report_startup_time(double startup_ms) {
+  std::lock_guard<std::mutex> l(mut_);
+  if (!is_persistent()) {
+    return;
+  }
+
+  std::filesystem::path baseline_path =
+      std::filesystem::path(adapter_dir_) / ::kStartupBaselineFile;
+
+  double cold_ms = 0.;
+  bool has_baseline = false;
+  {
+    std::ifstream f(baseline_path);
+    has_baseline = static_cast<bool>(f >> cold_ms);
+  }
+
+  if (stats_.hits == 0u && stats_.misses > 0u) {
+    // Nothing was cached - this is a cold start
+    std::ofstream f(baseline_path, std::ios::trunc);
+    f << startup_ms;
+    startup_time_saved_ms_ = std::nullopt;
+    IGGPU_LOG_INFO("[IGGPU] Pipeline cache cold start: %fms (%llu misses)",
+                   startup_ms, static_cast<unsigned long long>(stats_.misses));
+    return;
+  }
+
+  if (has_baseline) {
+    startup_time_saved_ms_ = cold_ms - startup_ms;
+    IGGPU_LOG_INFO(
+        "[IGGPU] Pipeline cache warm start: %fms (%llu hits, %llu misses), "
+        "%fms faster than cold start",
+        startup_ms, static_cast<unsigned long long>(stats_.hits),
+        static_cast<unsigned long long>(stats_.misses),
+        *startup_time_saved_ms_);
+  }
+}
+
+std::optional<double> PipelineCache::startup_time_saved_ms() const {
+  std::lock_guard<std::mutex> l(mut_);
+  return startup_time_saved_ms_;
+}
+
+}  // namespace iggpu
@@ -0,0 +1,332 @@
+#include <iggpu/pipeline_manager.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+// Descriptor keys are built by appending every field that affects the
+//  compiled pipeline, in a fixed order. Object handles are keyed by identity.
+class KeyBuilder {
+ public:
+  template <typename T>
+  void add(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    key_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void add_handle(const void* handle) { add(handle); }
+
+  void add_string(const char* str) {
+    size_t len = str ? std::strlen(str) : 0u;
+    add(len);
+    key_.append(str ? str : "", len);
+  }
+
+#ifndef __EMSCRIPTEN__
+  void add_string(const wgpu::StringView& str) {
+    if (str.data == nullptr) {
+      add_string(static_cast<const char*>(nullptr));
+      return;
+    }
+    size_t len = str.length == WGPU_STRLEN ? std::strlen(str.data) : str.length;
+    add(len);
+    key_.append(str.data, len);
+  }
+#endif
+
+  void add_constants(size_t count, const wgpu::ConstantEntry* constants) {
+    add(count);
+    for (size_t i = 0; i < count; i++) {
+      add_string(constants[i].key);
+      add(constants[i].value);
+    }
+  }
+
+  void add_stencil_face(const wgpu::StencilFaceState& face) {
+    add(static_cast<uint32_t>(face.compare));
+    add(static_cast<uint32_t>(face.failOp));
+    add(static_cast<uint32_t>(face.depthFailOp));
+    add(static_cast<uint32_t>(face.passOp));
+  }
+
+  void add_blend_component(const wgpu::BlendComponent& c) {
+    add(static_cast<uint32_t>(c.operation));
+    add(static_cast<uint32_t>(c.srcFactor));
+    add(static_cast<uint32_t>(c.dstFactor));
+  }
+
+  std::string take() { return std::move(key_); }
+
+ private:
+  std::string key_;
+};
+
+// Extension structs can't be keyed generically - descriptors using any are
+//  built as they are, without deduplication
+bool has_chained_structs(const wgpu::RenderPipelineDescriptor& desc) {
+  if (desc.nextInChain || desc.vertex.nextInChain ||
+      desc.primitive.nextInChain || desc.multisample.nextInChain ||
+      (desc.depthStencil && desc.depthStencil->nextInChain)) {
+    return true;
+  }
+  for (size_t i = 0; i < desc.vertex.constantCount; i++) {
+    if (desc.vertex.constants[i].nextInChain) return true;
+  }
+#ifndef __EMSCRIPTEN__
+  for (size_t i = 0; i < desc.vertex.bufferCount; i++) {
+    if (desc.vertex.buffers[i].nextInChain) return true;
+  }
+#endif
+  if (desc.fragment) {
+    if (desc.fragment->nextInChain) return true;
+    for (size_t i = 0; i < desc.fragment->constantCount; i++) {
+      if (desc.fragment->constants[i].nextInChain) return true;
+    }
+    for (size_t i = 0; i < desc.fragment->targetCount; i++) {
+      if (desc.fragment->targets[i].nextInChain) return true;
+    }
+  }
+  return false;
+}
+
+bool has_chained_structs(const wgpu::ComputePipelineDescriptor& desc) {
+  if (desc.nextInChain || desc.compute.nextInChain) {
+    return true;
+  }
+  for (size_t i = 0; i < desc.compute.constantCount; i++) {
+    if (desc.compute.constants[i].nextInChain) return true;
+  }
+  return false;
+}
+
+std::string render_pipeline_key(const wgpu::RenderPipelineDescriptor& desc) {
+  KeyBuilder k;
+  k.add_handle(desc.layout.Get());
+
+  k.add_handle(desc.vertex.module.Get());
+  k.add_string(desc.vertex.entryPoint);
+  k.add_constants(desc.vertex.constantCount, desc.vertex.constants);
+  k.add(desc.vertex.bufferCount);
+  for (size_t i = 0; i < desc.vertex.bufferCount; i++) {
+    const auto& buffer = desc.vertex.buffers[i];
+    k.add(buffer.arrayStride);
+    k.add(static_cast<uint32_t>(buffer.stepMode));
+    k.add(buffer.attributeCount);
+    for (size_t j = 0; j < buffer.attributeCount; j++) {
+      k.add(static_cast<uint32_t>(buffer.attributes[j].format));
+      k.add(buffer.attributes[j].offset);
+      k.add(buffer.attributes[j].shaderLocation);
+    }
+  }
+
+  k.add(static_cast<uint32_t>(desc.primitive.topology));
+  k.add(static_cast<uint32_t>(desc.primitive.stripIndexFormat));
+  k.add(static_cast<uint32_t>(desc.primitive.frontFace));
+  k.add(static_cast<uint32_t>(desc.primitive.cullMode));
+
+  k.add(desc.depthStencil != nullptr);
+  if (desc.depthStencil) {
+    const auto& ds = *desc.depthStencil;
+    k.add(static_cast<uint32_t>(ds.format));
+    k.add(static_cast<uint32_t>(ds.depthWriteEnabled));
+    k.add(static_cast<uint32_t>(ds.depthCompare));
+    k.add_stencil_face(ds.stencilFront);
+    k.add_stencil_face(ds.stencilBack);
+    k.add(ds.stencilReadMask);
+    k.add(ds.stencilWriteMask);
+    k.add(ds.depthBias);
+    k.add(ds.depthBiasSlopeScale);
+    k.add(ds.depthBiasClamp);
+  }
+
+  k.add(desc.multisample.count);
+  k.add(desc.multisample.mask);
+  k.add(desc.multisample.alphaToCoverageEnabled);
+
+  k.add(desc.fragment != nullptr);
+  if (desc.fragment) {
+    const auto& fs = *desc.fragment;
+    k.add_handle(fs.module.Get());
+    k.add_string(fs.entryPoint);
+    k.add_constants(fs.constantCount, fs.constants);
+    k.add(fs.targetCount);
+    for (size_t i = 0; i < fs.targetCount; i++) {
+      const auto& target = fs.targets[i];
+      k.add(static_cast<uint32_t>(target.format));
+      k.add(static_cast<uint32_t>(target.writeMask));
+      k.add(target.blend != nullptr);
+      if (target.blend) {
+        k.add_blend_component(target.blend->color);
+        k.add_blend_component(target.blend->alpha);
+      }
+    }
+  }
+
+  return k.take();
+}
+
+std::string compute_pipeline_key(const wgpu::ComputePipelineDescriptor& desc) {
+  KeyBuilder k;
+  k.add_handle(desc.layout.Get());
+  k.add_handle(desc.compute.module.Get());
+  k.add_string(desc.compute.entryPoint);
+  k.add_constants(desc.compute.constantCount, desc.compute.constants);
+  return k.take();
+}
+
+// Failed builds are not cached - drop the key so that the next request for
+//  the same descriptor starts a new build
+void forget_key(std::unordered_map<std::string, uint32_t>& ids,
+                const std::string& key, uint32_t id) {
+  if (key.empty()) {
+    return;
+  }
+  auto it = ids.find(key);
+  if (it != ids.end() && it->second == id) {
+    ids.erase(it);
+  }
+}
+
+}  // namespace
+
+namespace iggpu {
+
+PipelineManager::PipelineManager(AppBase* app_base)
+    : app_base_(app_base),
+      stats_{},
+      alive_token_(std::make_shared<bool>(true)) {}
+
+PipelineManager::PipelineId PipelineManager::request_render_pipeline(
+    const wgpu::RenderPipelineDescriptor& desc) {
+  stats_.requests++;
+
+  std::string key;
+  if (!::has_chained_structs(desc)) {
+    key = ::render_pipeline_key(desc);
+    auto it = render_ids_.find(key);
+    if (it != render_ids_.end()) {
+      stats_.deduplicated++;
+      return it->second;
+    }
+  }
+
+  PipelineId id = static_cast<PipelineId>(render_entries_.size());
+  if (!key.empty()) {
+    render_ids_.emplace(key, id);
+  }
+  render_entries_.push_back({nullptr,
+                             igasync::Promise<wgpu::RenderPipeline>::Create(),
+                             std::move(key)});
+
+  stats_.builds_started++;
+  auto start = std::chrono::steady_clock::now();
+  std::weak_ptr<bool> token = alive_token_;
+  auto promise = render_entries_[id].promise;
+  app_base_->create_render_pipeline_async(
+      desc, [this, token, id, promise, start](wgpu::RenderPipeline pipeline) {
+        if (!token.expired()) {
+          on_build_finished(static_cast<bool>(pipeline), start);
+          if (pipeline) {
+            render_entries_[id].pipeline = pipeline;
+          } else {
+            ::forget_key(render_ids_, render_entries_[id].key, id);
+          }
+        }
+        promise->resolve(std::move(pipeline));
+      });
+
+  return id;
+}
+
+PipelineManager::PipelineId PipelineManager::request_compute_pipeline(
+    const wgpu::ComputePipelineDescriptor& desc) {
+  stats_.requests++;
+
+  std::string key;
+  if (!::has_chained_structs(desc)) {
+    key = ::compute_pipeline_key(desc);
+    auto it = compute_ids_.find(key);
+    if (it != compute_ids_.end()) {
+      stats_.deduplicated++;
+      return it->second;
+    }
+  }
+
+  PipelineId id = static_cast<PipelineId>(compute_entries_.size());
+  if (!key.empty()) {
+    compute_ids_.emplace(key, id);
+  }
+  compute_entries_.push_back({nullptr,
+                              igasync::Promise<wgpu::ComputePipeline>::Create(),
+                              std::move(key)});
+
+  stats_.builds_started++;
+  auto start = std::chrono::steady_clock::now();
+  std::weak_ptr<bool> token = alive_token_;
+  auto promise = compute_entries_[id].promise;
+  app_base_->create_compute_pipeline_async(
+      desc, [this, token, id, promise, start](wgpu::ComputePipeline pipeline) {
+        if (!token.expired()) {
+          on_build_finished(static_cast<bool>(pipeline), start);
+          if (pipeline) {
+            compute_entries_[id].pipeline = pipeline;
+          } else {
+            ::forget_key(compute_ids_, compute_entries_[id].key, id);
+          }
+        }
+        promise->resolve(std::move(pipeline));
+      });
+
+  return id;
+}
+
+PipelineManager::RenderPipelinePromise PipelineManager::render_pipeline_promise(
+    PipelineId id) const {
+  if (id >= render_entries_.size()) {
+    return nullptr;
+  }
+  return render_entries_[id].promise;
+}
+
+PipelineManager::ComputePipelinePromise
+PipelineManager::compute_pipeline_promise(PipelineId id) const {
+  if (id >= compute_entries_.size()) {
+    return nullptr;
+  }
+  return compute_entries_[id].promise;
+}
+
+wgpu::RenderPipeline PipelineManager::render_pipeline(
+    PipelineId id, wgpu::RenderPipeline fallback) const {
+  if (id >= render_entries_.size() || !render_entries_[id].pipeline) {
+    return fallback;
+  }
+  return render_entries_[id].pipeline;
+}
+
+wgpu::ComputePipeline PipelineManager::compute_pipeline(
+    PipelineId id, wgpu::ComputePipeline fallback) const {
+  if (id >= compute_entries_.size() || !compute_entries_[id].pipeline) {
+    return fallback;
+  }
+  return compute_entries_[id].pipeline;
+}
+
+void PipelineManager::on_build_finished(
+    bool success, std::chrono::steady_clock::time_point start) {
+  if (!success) {
+    stats_.builds_failed++;
+    return;
+  }
+
+  double build_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  stats_.builds_completed++;
+  stats_.total_build_ms += build_ms;
+  stats_.max_build_ms = std::max(stats_.max_build_ms, build_ms);
+}
+
+}  // namespace iggpu
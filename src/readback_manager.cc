@@ -0,0 +1,358 @@
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+#include <iggpu/readback_manager.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// Staging buffers are rounded up to a power of two (at least this), so that
+//  readbacks of slightly different sizes can share them
+const uint64_t kMinStagingSize = 256u;
+
+uint64_t staging_size(uint64_t size) {
+  uint64_t rsl = kMinStagingSize;
+  while (rsl < size) {
+    rsl <<= 1;
+  }
+  return rsl;
+}
+
+uint32_t align_up(uint32_t v, uint32_t alignment) {
+  return (v + alignment - 1u) / alignment * alignment;
+}
+
+// 0 for formats that can't be read back (compressed, multi-aspect...)
+uint32_t texel_size(wgpu::TextureFormat format) {
+  switch (format) {
+    case wgpu::TextureFormat::R8Unorm:
+    case wgpu::TextureFormat::R8Snorm:
+    case wgpu::TextureFormat::R8Uint:
+    case wgpu::TextureFormat::R8Sint:
+      return 1u;
+    case wgpu::TextureFormat::R16Uint:
+    case wgpu::TextureFormat::R16Sint:
+    case wgpu::TextureFormat::R16Float:
+    case wgpu::TextureFormat::RG8Unorm:
+    case wgpu::TextureFormat::RG8Snorm:
+    case wgpu::TextureFormat::RG8Uint:
+    case wgpu::TextureFormat::RG8Sint:
+      return 2u;
+    case wgpu::TextureFormat::R32Float:
+    case wgpu::TextureFormat::R32Uint:
+    case wgpu::TextureFormat::R32Sint:
+    case wgpu::TextureFormat::RG16Uint:
+    case wgpu::TextureFormat::RG16Sint:
+    case wgpu::TextureFormat::RG16Float:
+    case wgpu::TextureFormat::RGBA8Unorm:
+    case wgpu::TextureFormat::RGBA8UnormSrgb:
+    case wgpu::TextureFormat::RGBA8Snorm:
+    case wgpu::TextureFormat::RGBA8Uint:
+    case wgpu::TextureFormat::RGBA8Sint:
+    case wgpu::TextureFormat::BGRA8Unorm:
+    case wgpu::TextureFormat::BGRA8UnormSrgb:
+    case wgpu::TextureFormat::RGB10A2Unorm:
+    case wgpu::TextureFormat::RG11B10Ufloat:
+    case wgpu::TextureFormat::Depth32Float:
+      return 4u;
+    case wgpu::TextureFormat::RG32Float:
+    case wgpu::TextureFormat::RG32Uint:
+    case wgpu::TextureFormat::RG32Sint:
+    case wgpu::TextureFormat::RGBA16Uint:
+    case wgpu::TextureFormat::RGBA16Sint:
+    case wgpu::TextureFormat::RGBA16Float:
+      return 8u;
+    case wgpu::TextureFormat::RGBA32Float:
+    case wgpu::TextureFormat::RGBA32Uint:
+    case wgpu::TextureFormat::RGBA32Sint:
+      return 16u;
+    default:
+      return 0u;
+  }
+}
+
+}  // namespace
+
+namespace iggpu {
+
+ReadbackManager::ReadbackManager(AppBase* app_base, uint32_t max_in_flight)
+    : app_base_(app_base),
+      max_in_flight_(max_in_flight == 0u ? 1u : max_in_flight),
+      pending_count_(0u),
+      frame_(0u),
+      stats_{},
+      latency_frames_(120u),
+      alive_token_(std::make_shared<bool>(true)) {}
+
+ReadbackManager::~ReadbackManager() {
+  // Pending callbacks are dropped - they check alive_token_
+  for (auto& request : recorded_) {
+    iggpu::destroy_buffer(request->buffer);
+  }
+  for (auto& request : mapping_) {
+    iggpu::destroy_buffer(request->buffer);
+  }
+  for (auto& buffer : free_buffers_) {
+    iggpu::destroy_buffer(buffer);
+  }
+}
+
+bool ReadbackManager::begin_request(uint64_t size) {
+  if (size == 0u) {
+    return false;
+  }
+
+  if (pending_count_ >= max_in_flight_) {
+    stats_.exhausted_count++;
+    return false;
+  }
+
+  stats_.requests++;
+  pending_count_++;
+  stats_.in_flight = pending_count_;
+  return true;
+}
+
+wgpu::Buffer ReadbackManager::acquire_buffer(uint64_t size) {
+  // Smallest free buffer that fits
+  auto best = free_buffers_.end();
+  for (auto it = free_buffers_.begin(); it != free_buffers_.end(); ++it) {
+    if (it->GetSize() >= size &&
+        (best == free_buffers_.end() || it->GetSize() < best->GetSize())) {
+      best = it;
+    }
+  }
+
+  if (best != free_buffers_.end()) {
+    wgpu::Buffer buffer = *best;
+    free_buffers_.erase(best);
+    return buffer;
+  }
+
+  wgpu::BufferDescriptor bd{};
+  bd.size = ::staging_size(size);
+  bd.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+  wgpu::Buffer buffer =
+      iggpu::create_buffer(app_base_->Device, bd, "ReadbackManager");
+  if (buffer) {
+    stats_.pool_buffer_count++;
+  }
+  return buffer;
+}
+
+bool ReadbackManager::read_buffer(wgpu::CommandEncoder& encoder,
+                                  wgpu::Buffer src, uint64_t offset,
+                                  uint64_t size, Callback cb) {
+  if (offset % 4u != 0u || size % 4u != 0u) {
+    iggpu::log(LogLevel::Error,
+               "[IGGPU] Buffer readback offset and size must be multiples "
+               "of 4");
+    return false;
+  }
+
+  if (!begin_request(size)) {
+    return false;
+  }
+
+  auto request = std::make_shared<Request>();
+  request->buffer = acquire_buffer(size);
+  request->size = size;
+  request->cb = std::move(cb);
+  request->frame = frame_;
+  request->width = request->height = 0u;
+  request->bytes_per_row = request->padded_bytes_per_row = 0u;
+  if (!request->buffer) {
+    on_mapped(*request, false);
+    return true;
+  }
+
+  encoder.CopyBufferToBuffer(src, offset, request->buffer, 0u, size);
+  recorded_.push_back(std::move(request));
+  return true;
+}
+
+bool ReadbackManager::read_texture(wgpu::CommandEncoder& encoder,
+                                   wgpu::Texture src, wgpu::Origin3D origin,
+                                   wgpu::Extent3D extent, Callback cb,
+                                   uint32_t mip_level) {
+  uint32_t texel_size = ::texel_size(src.GetFormat());
+  if (texel_size == 0u) {
+    iggpu::log(LogLevel::Error,
+               "[IGGPU] Texture readback does not support this format");
+    return false;
+  }
+
+  uint32_t bytes_per_row = extent.width * texel_size;
+  uint32_t padded_bytes_per_row =
+      ::align_up(bytes_per_row, kBytesPerRowAlignment);
+  uint64_t size = static_cast<uint64_t>(padded_bytes_per_row) * extent.height;
+  if (!begin_request(size)) {
+    return false;
+  }
+
+  auto request = std::make_shared<Request>();
+  request->buffer = acquire_buffer(size);
+  request->size = size;
+  request->cb = std::move(cb);
+  request->frame = frame_;
+  request->width = extent.width;
+  request->height = extent.height;
+  request->bytes_per_row = bytes_per_row;
+  request->padded_bytes_per_row = padded_bytes_per_row;
+  if (!request->buffer) {
+    on_mapped(*request, false);
+    return true;
+  }
+
+  wgpu::ImageCopyTexture src_copy{};
+  src_copy.texture = src;
+  src_copy.mipLevel = mip_level;
+  src_copy.origin = origin;
+
+  wgpu::ImageCopyBuffer dst_copy{};
+  dst_copy.buffer = request->buffer;
+  dst_copy.layout.offset = 0u;
+  dst_copy.layout.bytesPerRow = padded_bytes_per_row;
+  dst_copy.layout.rowsPerImage = extent.height;
+
+  wgpu::Extent3D copy_size = extent;
+  copy_size.depthOrArrayLayers = 1u;
+  encoder.CopyTextureToBuffer(&src_copy, &dst_copy, &copy_size);
+  recorded_.push_back(std::move(request));
+  return true;
+}
+
+std::shared_ptr<igasync::Promise<ReadbackResult>>
+ReadbackManager::read_buffer_async(wgpu::CommandEncoder& encoder,
+                                   wgpu::Buffer src, uint64_t offset,
+                                   uint64_t size) {
+  return iggpu::as_promise<ReadbackResult>([&](auto resolve) {
+    if (!read_buffer(encoder, src, offset, size, resolve)) {
+      resolve(ReadbackResult{});
+    }
+  });
+}
+
+std::shared_ptr<igasync::Promise<ReadbackResult>>
+ReadbackManager::read_texture_async(wgpu::CommandEncoder& encoder,
+                                    wgpu::Texture src, wgpu::Origin3D origin,
+                                    wgpu::Extent3D extent,
+                                    uint32_t mip_level) {
+  return iggpu::as_promise<ReadbackResult>([&](auto resolve) {
+    if (!read_texture(encoder, src, origin, extent, resolve, mip_level)) {
+      resolve(ReadbackResult{});
+    }
+  });
+}
+
+void ReadbackManager::on_submitted() {
+  std::weak_ptr<bool> token = alive_token_;
+
+  for (auto& request : recorded_) {
+    request->map_future = app_base_->map_buffer_async(
+        request->buffer, wgpu::MapMode::Read, 0, request->size,
+        [this, token, request](bool success) {
+          if (token.expired()) return;
+          on_mapped(*request, success);
+        });
+    mapping_.push_back(std::move(request));
+  }
+  recorded_.clear();
+  frame_++;
+}
+
+bool ReadbackManager::wait_for_any_mapping() {
+#ifdef __EMSCRIPTEN__
+  // Browsers cannot block on GPU progress
+  return false;
+#else
+  if (mapping_.empty()) {
+    return false;
+  }
+
+  std::vector<GpuFuture> futures;
+  for (const auto& request : mapping_) {
+    futures.push_back(request->map_future);
+  }
+  if (app_base_->wait_any(futures) < 0) {
+    app_base_->process_events();
+  }
+  return true;
+#endif
+}
+
+void ReadbackManager::wait_for_capacity() {
+  while (!can_read() && wait_for_any_mapping()) {
+  }
+}
+
+void ReadbackManager::wait_for_all() {
+  while (wait_for_any_mapping()) {
+  }
+}
+
+void ReadbackManager::on_mapped(Request& request, bool success) {
+  mapping_.erase(
+      std::remove_if(mapping_.begin(), mapping_.end(),
+                     [&request](const std::shared_ptr<Request>& r) {
+                       return r.get() == &request;
+                     }),
+      mapping_.end());
+
+  ReadbackResult result{};
+  result.success = false;
+  result.width = request.width;
+  result.height = request.height;
+  result.bytes_per_row = request.bytes_per_row;
+  result.latency_frames = frame_ - request.frame;
+
+  if (success) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(
+        request.buffer.GetConstMappedRange(0, request.size));
+    if (data != nullptr && request.padded_bytes_per_row == 0u) {
+      result.data.assign(data, data + request.size);
+      result.success = true;
+    } else if (data != nullptr) {
+      // Strip the row padding
+      result.data.resize(static_cast<size_t>(request.bytes_per_row) *
+                         request.height);
+      for (uint32_t row = 0u; row < request.height; row++) {
+        std::memcpy(result.data.data() +
+                        static_cast<size_t>(row) * request.bytes_per_row,
+                    data + static_cast<size_t>(row) *
+                               request.padded_bytes_per_row,
+                    request.bytes_per_row);
+      }
+      result.success = true;
+    }
+    request.buffer.Unmap();
+  }
+
+  pending_count_--;
+  stats_.in_flight = pending_count_;
+  if (result.success) {
+    stats_.completed++;
+    stats_.bytes_read += result.data.size();
+    latency_frames_.add(static_cast<double>(result.latency_frames));
+  } else {
+    stats_.failed++;
+  }
+
+  // Keep at most one idle staging buffer per possible request - beyond that
+  //  the pool only grew for a burst
+  if (success && request.buffer && free_buffers_.size() < max_in_flight_) {
+    free_buffers_.push_back(std::move(request.buffer));
+  } else if (request.buffer) {
+    iggpu::destroy_buffer(request.buffer);
+    stats_.pool_buffer_count--;
+  }
+
+  Callback cb = std::move(request.cb);
+  if (cb) {
+    cb(std::move(result));
+  }
+}
+
+}  // namespace iggpu
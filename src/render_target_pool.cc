@@ -0,0 +1,158 @@
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+#include <iggpu/render_target_pool.h>
+
+#include <algorithm>
+#include <tuple>
+
+namespace iggpu {
+
+bool RenderTargetPool::Key::operator<(const Key& o) const {
+  return std::tie(width, height, format, usage, sample_count, surface_sized) <
+         std::tie(o.width, o.height, o.format, o.usage, o.sample_count,
+                  o.surface_sized);
+}
+
+RenderTargetPool::RenderTargetPool(AppBase* app_base, uint32_t max_idle_frames)
+    : app_base_(app_base),
+      max_idle_frames_(max_idle_frames),
+      resize_listener_(app_base->add_resize_listener(
+          [this](uint32_t, uint32_t) { on_resize(); })),
+      frame_index_(1u),
+      shared_(std::make_shared<SharedState>()),
+      stats_{} {}
+
+RenderTargetPool::~RenderTargetPool() {
+  resize_listener_.reset();
+  for (auto& [key, entries] : entries_) {
+    for (Entry& entry : entries) {
+      iggpu::release_texture(entry.target.texture);
+    }
+  }
+}
+
+RenderTarget RenderTargetPool::acquire(const RenderTargetDesc& desc) {
+  stats_.acquires++;
+
+  Key key{};
+  key.surface_sized = desc.width == 0u || desc.height == 0u;
+  key.width = key.surface_sized ? app_base_->Width : desc.width;
+  key.height = key.surface_sized ? app_base_->Height : desc.height;
+  key.format = desc.format;
+  key.usage = desc.usage;
+  key.sample_count = desc.sample_count;
+
+  std::vector<Entry>& entries = entries_[key];
+  for (Entry& entry : entries) {
+    if (entry.last_used_frame <= shared_->completed_frame) {
+      entry.last_used_frame = frame_index_;
+      stats_.reuses++;
+      return entry.target;
+    }
+  }
+
+  wgpu::TextureDescriptor td{};
+  td.size.width = key.width;
+  td.size.height = key.height;
+  td.size.depthOrArrayLayers = 1u;
+  td.format = key.format;
+  td.usage = key.usage;
+  td.sampleCount = key.sample_count;
+  td.dimension = wgpu::TextureDimension::e2D;
+  td.mipLevelCount = 1u;
+
+  Entry entry{};
+  entry.target.texture =
+      iggpu::create_texture(app_base_->Device, td, "RenderTargetPool");
+  if (!entry.target.texture) {
+    iggpu::log(LogLevel::Error,
+               "[IGGPU] RenderTargetPool failed to create texture");
+    return {};
+  }
+  entry.target.view = entry.target.texture.CreateView();
+  entry.last_used_frame = frame_index_;
+  entries.push_back(entry);
+
+  stats_.textures_created++;
+  update_texture_count();
+  return entry.target;
+}
+
+void RenderTargetPool::end_frame() {
+  app_base_->on_submitted_work_done(
+      [shared = shared_, frame_index = frame_index_]() {
+        shared->completed_frame =
+            std::max(shared->completed_frame, frame_index);
+      });
+  frame_index_++;
+
+  release_idle();
+}
+
+void RenderTargetPool::invalidate() {
+  for (auto& [key, entries] : entries_) {
+    for (Entry& entry : entries) {
+      iggpu::release_texture(entry.target.texture);
+    }
+    stats_.textures_released += entries.size();
+  }
+  entries_.clear();
+  stats_.invalidations++;
+  update_texture_count();
+}
+
+void RenderTargetPool::on_resize() {
+  // Fixed size targets are still valid
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->first.surface_sized) {
+      for (Entry& entry : it->second) {
+        iggpu::release_texture(entry.target.texture);
+      }
+      stats_.textures_released += it->second.size();
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  stats_.invalidations++;
+  update_texture_count();
+}
+
+void RenderTargetPool::release_idle() {
+  if (max_idle_frames_ == 0u || frame_index_ <= max_idle_frames_) {
+    return;
+  }
+
+  uint64_t oldest_kept_frame = frame_index_ - max_idle_frames_;
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto& entries = it->second;
+    auto new_end = std::partition(
+        entries.begin(), entries.end(), [oldest_kept_frame](const Entry& e) {
+          return e.last_used_frame >= oldest_kept_frame;
+        });
+    for (auto e = new_end; e != entries.end(); ++e) {
+      iggpu::release_texture(e->target.texture);
+    }
+    stats_.textures_released += std::distance(new_end, entries.end());
+    entries.erase(new_end, entries.end());
+
+    if (entries.empty()) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  update_texture_count();
+}
+
+void RenderTargetPool::update_texture_count() {
+  uint32_t count = 0u;
+  for (const auto& [key, entries] : entries_) {
+    count += entries.size();
+  }
+  stats_.texture_count = count;
+  stats_.high_water_texture_count =
+      std::max(stats_.high_water_texture_count, count);
+}
+
+}  // namespace iggpu
@@ -0,0 +1,62 @@
+#include <iggpu/rolling_stats.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double percentile_of_sorted(const std::vector<double>& sorted, double p) {
+  // Nearest-rank percentile
+  size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+  if (rank > 0) rank--;
+  if (rank >= sorted.size()) rank = sorted.size() - 1;
+  return sorted[rank];
+}
+
+}  // namespace
+
+namespace iggpu {
+
+RollingStats::RollingStats(uint32_t capacity)
+    : samples_(capacity == 0u ? 1u : capacity, 0.), next_(0u), count_(0u) {}
+
+void RollingStats::add(double sample) {
+  samples_[next_] = sample;
+  next_ = (next_ + 1u) % samples_.size();
+  if (count_ < samples_.size()) {
+    count_++;
+  }
+}
+
+void RollingStats::clear() {
+  next_ = 0u;
+  count_ = 0u;
+}
+
+Percentiles RollingStats::percentiles() const {
+  Percentiles rsl{};
+  if (count_ == 0u) {
+    return rsl;
+  }
+
+  // Samples occupy [0, count_) until the window wraps, and the whole buffer
+  //  afterwards - either way order does not matter once sorted.
+  std::vector<double> sorted(samples_.begin(), samples_.begin() + count_);
+  std::sort(sorted.begin(), sorted.end());
+
+  double sum = 0.;
+  for (double s : sorted) {
+    sum += s;
+  }
+
+  rsl.p50 = ::percentile_of_sorted(sorted, 0.5);
+  rsl.p95 = ::percentile_of_sorted(sorted, 0.95);
+  rsl.p99 = ::percentile_of_sorted(sorted, 0.99);
+  rsl.min = sorted.front();
+  rsl.max = sorted.back();
+  rsl.mean = sum / sorted.size();
+  rsl.sample_count = count_;
+  return rsl;
+}
+
+}  // namespace iggpu
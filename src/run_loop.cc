@@ -0,0 +1,86 @@
+#include <iggpu/run_loop.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace iggpu {
+
+RunLoop::RunLoop(RunLoopConfig config, RunLoopCallbacks callbacks)
+    : config_(config),
+      callbacks_(std::move(callbacks)),
+      has_last_frame_(false),
+      accumulator_s_(0.),
+      frame_requested_(true),
+      stop_requested_(false) {}
+
+bool RunLoop::wants_frame() const {
+  return frame_requested_.load() || !callbacks_.needs_frame ||
+         callbacks_.needs_frame();
+}
+
+double RunLoop::seconds_until_next_frame() const {
+  if (config_.max_fps <= 0. || !has_last_frame_) {
+    return 0.;
+  }
+
+  return std::max(
+      std::chrono::duration<double>(next_frame_ - clock::now()).count(), 0.);
+}
+
+void RunLoop::run_frame() {
+  frame_requested_.store(false);
+
+  auto now = clock::now();
+  double dt_s =
+      has_last_frame_
+          ? std::chrono::duration<double>(now - last_frame_).count()
+          : 0.;
+  last_frame_ = now;
+
+  if (config_.max_fps > 0.) {
+    auto period = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1. / config_.max_fps));
+
+    // Keep a steady cadence, unless the loop fell more than a frame behind
+    next_frame_ = has_last_frame_ ? next_frame_ + period : now + period;
+    if (next_frame_ < now) {
+      next_frame_ = now + period;
+    }
+  }
+  has_last_frame_ = true;
+
+  double alpha = 1.;
+  if (config_.fixed_timestep_s > 0.) {
+    accumulator_s_ += dt_s;
+    uint32_t steps = 0u;
+    while (accumulator_s_ >= config_.fixed_timestep_s &&
+           steps < config_.max_updates_per_frame) {
+      if (callbacks_.update) {
+        callbacks_.update(config_.fixed_timestep_s);
+      }
+      accumulator_s_ -= config_.fixed_timestep_s;
+      steps++;
+    }
+
+    // Too far behind - drop the backlog
+    if (accumulator_s_ >= config_.fixed_timestep_s) {
+      accumulator_s_ = std::fmod(accumulator_s_, config_.fixed_timestep_s);
+    }
+    alpha = accumulator_s_ / config_.fixed_timestep_s;
+  } else if (callbacks_.update) {
+    callbacks_.update(dt_s);
+  }
+
+  if (callbacks_.render) {
+    callbacks_.render(alpha);
+  }
+}
+
+void RunLoop::on_idle() {
+  if (has_last_frame_) {
+    last_frame_ = clock::now();
+  }
+}
+
+}  // namespace iggpu
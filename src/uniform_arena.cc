@@ -0,0 +1,178 @@
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+#include <iggpu/uniform_arena.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// WebGPU default for both minUniformBufferOffsetAlignment and
+//  minStorageBufferOffsetAlignment
+const uint32_t kDefaultOffsetAlignment = 256u;
+
+uint64_t align_up(uint64_t v, uint64_t alignment) {
+  return (v + alignment - 1u) / alignment * alignment;
+}
+
+}  // namespace
+
+namespace iggpu {
+
+UniformArena::UniformArena(AppBase* app_base, UniformArenaDesc desc)
+    : app_base_(app_base),
+      desc_(desc),
+      alignment_(::kDefaultOffsetAlignment),
+      frame_slot_(0u),
+      current_page_(0u),
+      stats_{} {
+  wgpu::SupportedLimits limits{};
+  app_base_->Device.GetLimits(&limits);
+  uint32_t alignment = desc_.storage
+                           ? limits.limits.minStorageBufferOffsetAlignment
+                           : limits.limits.minUniformBufferOffsetAlignment;
+  if (alignment > 0u) {
+    alignment_ = alignment;
+  }
+
+  uint64_t max_binding_size =
+      desc_.storage ? limits.limits.maxStorageBufferBindingSize
+                    : limits.limits.maxUniformBufferBindingSize;
+  if (max_binding_size > 0u && desc_.binding_size > max_binding_size) {
+    IGGPU_LOG_WARNING(
+        "[IGGPU] UniformArena binding size %u exceeds the device limit, "
+        "clamping to %llu",
+        desc_.binding_size, static_cast<unsigned long long>(max_binding_size));
+    desc_.binding_size = static_cast<uint32_t>(max_binding_size);
+  }
+  desc_.binding_size =
+      static_cast<uint32_t>(::align_up(desc_.binding_size, 4u));
+  desc_.page_size = std::max(::align_up(desc_.page_size, 4u),
+                             static_cast<uint64_t>(desc_.binding_size));
+  desc_.frame_count = std::max(desc_.frame_count, 1u);
+
+  wgpu::BindGroupLayoutEntry entry{};
+  entry.binding = 0u;
+  entry.visibility = desc_.visibility;
+  entry.buffer.type = desc_.storage ? wgpu::BufferBindingType::ReadOnlyStorage
+                                    : wgpu::BufferBindingType::Uniform;
+  entry.buffer.hasDynamicOffset = true;
+  entry.buffer.minBindingSize = desc_.binding_size;
+
+  wgpu::BindGroupLayoutDescriptor bgld{};
+  bgld.entryCount = 1u;
+  bgld.entries = &entry;
+  layout_ = app_base_->Device.CreateBindGroupLayout(&bgld);
+
+  frames_.resize(desc_.frame_count);
+}
+
+UniformArena::~UniformArena() {
+  for (auto& pages : frames_) {
+    for (auto& page : pages) {
+      iggpu::destroy_buffer(page.buffer);
+    }
+  }
+}
+
+bool UniformArena::add_page(std::vector<Page>& pages) {
+  wgpu::BufferDescriptor bd{};
+  bd.size = desc_.page_size;
+  bd.usage = (desc_.storage ? wgpu::BufferUsage::Storage
+                            : wgpu::BufferUsage::Uniform) |
+             wgpu::BufferUsage::CopyDst;
+
+  Page page{};
+  page.buffer = iggpu::create_buffer(app_base_->Device, bd, "UniformArena");
+  if (!page.buffer) {
+    return false;
+  }
+
+  wgpu::BindGroupEntry entry{};
+  entry.binding = 0u;
+  entry.buffer = page.buffer;
+  entry.offset = 0u;
+  entry.size = desc_.binding_size;
+
+  wgpu::BindGroupDescriptor bgd{};
+  bgd.layout = layout_;
+  bgd.entryCount = 1u;
+  bgd.entries = &entry;
+  page.bind_group = app_base_->Device.CreateBindGroup(&bgd);
+
+  page.data.resize(desc_.page_size);
+  page.used = 0u;
+  pages.push_back(std::move(page));
+  stats_.page_count++;
+  return true;
+}
+
+UniformAllocation UniformArena::allocate(uint64_t size) {
+  if (size == 0u || size > desc_.binding_size) {
+    if (stats_.rejected_allocations++ == 0u) {
+      IGGPU_LOG_ERROR(
+          "[IGGPU] UniformArena allocations must be non-empty and no larger "
+          "than the binding size (%llu of %u bytes requested)",
+          static_cast<unsigned long long>(size), desc_.binding_size);
+    }
+    return {};
+  }
+
+  std::vector<Page>& pages = frames_[frame_slot_];
+  uint64_t offset = 0u;
+  while (true) {
+    if (current_page_ >= pages.size() && !add_page(pages)) {
+      return {};
+    }
+
+    // The whole binding window must fit in the buffer, not only the
+    //  allocation
+    offset = ::align_up(pages[current_page_].used, alignment_);
+    if (offset + desc_.binding_size <= desc_.page_size) {
+      break;
+    }
+    current_page_++;
+  }
+
+  Page& page = pages[current_page_];
+  page.used = offset + size;
+
+  stats_.allocations++;
+  stats_.bytes_allocated += size;
+
+  UniformAllocation a{};
+  a.data = page.data.data() + offset;
+  a.size = size;
+  a.dynamic_offset = static_cast<uint32_t>(offset);
+  a.bind_group = page.bind_group;
+  return a;
+}
+
+void UniformArena::upload(UploadRing* upload_ring) {
+  uint64_t frame_bytes = 0u;
+  for (Page& page : frames_[frame_slot_]) {
+    if (page.used == 0u) {
+      continue;
+    }
+
+    uint64_t size = ::align_up(page.used, 4u);
+    if (upload_ring) {
+      upload_ring->upload(page.buffer, 0u, page.data.data(), size);
+    } else {
+      app_base_->Queue.WriteBuffer(page.buffer, 0u, page.data.data(), size);
+    }
+    stats_.uploads++;
+    frame_bytes += page.used;
+  }
+  stats_.high_water_bytes = std::max(stats_.high_water_bytes, frame_bytes);
+}
+
+void UniformArena::end_frame() {
+  frame_slot_ = (frame_slot_ + 1u) % desc_.frame_count;
+  current_page_ = 0u;
+  for (Page& page : frames_[frame_slot_]) {
+    page.used = 0u;
+  }
+}
+
+}  // namespace iggpu
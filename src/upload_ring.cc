@@ -0,0 +1,310 @@
+#include <iggpu/gpu_memory.h>
+#include <iggpu/log.h>
+#include <iggpu/upload_ring.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+uint64_t align_up(uint64_t v, uint64_t alignment) {
+  return (v + alignment - 1u) / alignment * alignment;
+}
+
+}  // namespace
+
+namespace iggpu {
+
+UploadRing::UploadRing(AppBase* app_base, uint64_t slot_size,
+                       uint32_t max_slots)
+    : app_base_(app_base),
+      slot_size_(::align_up(slot_size, kCopyAlignment)),
+      max_slots_(max_slots == 0u ? 1u : max_slots),
+      active_slot_(-1),
+      stats_{},
+      staged_bytes_(0u),
+      alive_token_(std::make_shared<bool>(true)) {}
+
+UploadRing::~UploadRing() {
+  for (auto& slot : slots_) {
+    iggpu::destroy_buffer(slot.buffer);
+  }
+  for (auto& buffer : oversized_buffers_) {
+    iggpu::destroy_buffer(buffer);
+  }
+}
+
+int32_t UploadRing::create_slot() {
+  wgpu::BufferDescriptor bd{};
+  bd.size = slot_size_;
+  bd.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+  bd.mappedAtCreation = true;
+
+  Slot slot{};
+  slot.buffer = iggpu::create_buffer(app_base_->Device, bd, "UploadRing");
+  if (!slot.buffer) {
+    return -1;
+  }
+  slot.mapped_data =
+      reinterpret_cast<uint8_t*>(slot.buffer.GetMappedRange(0, slot_size_));
+  if (!slot.mapped_data) {
+    iggpu::destroy_buffer(slot.buffer);
+    return -1;
+  }
+  slot.offset = 0u;
+  slot.state = SlotState::Free;
+
+  // Reuse the entry of a dead slot, if any (in-flight callbacks refer to
+  //  slots by index, so entries are never erased)
+  auto dead = std::find_if(slots_.begin(), slots_.end(), [](const Slot& s) {
+    return s.state == SlotState::Dead;
+  });
+  if (dead == slots_.end()) {
+    dead = slots_.insert(slots_.end(), slot);
+  } else {
+    *dead = slot;
+  }
+  stats_.slot_count = live_slot_count();
+  return static_cast<int32_t>(dead - slots_.begin());
+}
+
+uint32_t UploadRing::live_slot_count() const {
+  return std::count_if(slots_.begin(), slots_.end(), [](const Slot& s) {
+    return s.state != SlotState::Dead;
+  });
+}
+
+int32_t UploadRing::acquire_slot() {
+  auto find_free = [this]() -> int32_t {
+    for (uint32_t i = 0; i < slots_.size(); i++) {
+      if (slots_[i].state == SlotState::Free) {
+        return static_cast<int32_t>(i);
+      }
+    }
+    return -1;
+  };
+
+  int32_t slot_idx = find_free();
+  if (slot_idx >= 0) {
+    return slot_idx;
+  }
+
+  if (live_slot_count() < max_slots_) {
+    return create_slot();
+  }
+
+  bool any_in_flight = std::any_of(
+      slots_.begin(), slots_.end(),
+      [](const Slot& s) { return s.state == SlotState::InFlight; });
+  if (!any_in_flight) {
+    // The current frame alone needs more than max_slots staging buffers -
+    //  waiting would never finish, so grow past the limit instead.
+    iggpu::log(LogLevel::Warning,
+               "[IGGPU] UploadRing frame exceeds ring capacity, growing");
+    return create_slot();
+  }
+
+  stats_.stall_count++;
+#ifdef __EMSCRIPTEN__
+  // Browsers cannot block on GPU progress - grow the ring instead
+  return create_slot();
+#else
+  // Sleep until the GPU retires any in-flight slot (instead of spinning on
+  //  process_events). Slots whose re-map fails for good turn Dead and drop
+  //  out of the wait set - if none are left, make room for a new one.
+  std::vector<GpuFuture> map_futures;
+  while ((slot_idx = find_free()) < 0) {
+    map_futures.clear();
+    for (const auto& slot : slots_) {
+      if (slot.state == SlotState::InFlight) {
+        map_futures.push_back(slot.map_future);
+      }
+    }
+    if (map_futures.empty()) {
+      return create_slot();
+    }
+    if (app_base_->wait_any(map_futures) < 0) {
+      app_base_->process_events();
+    }
+  }
+  return slot_idx;
+#endif
+}
+
+std::span<uint8_t> UploadRing::allocate(wgpu::Buffer dst, uint64_t dst_offset,
+                                        uint64_t size) {
+  if (size == 0u || size % kCopyAlignment != 0u ||
+      dst_offset % kCopyAlignment != 0u) {
+    iggpu::log(LogLevel::Error,
+               "[IGGPU] UploadRing allocations must have a non-zero size and "
+               "an offset and size aligned to 4 bytes");
+    return {};
+  }
+
+  if (size > slot_size_) {
+    wgpu::BufferDescriptor bd{};
+    bd.size = size;
+    bd.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+    bd.mappedAtCreation = true;
+    wgpu::Buffer buffer =
+        iggpu::create_buffer(app_base_->Device, bd, "UploadRing");
+    if (!buffer) {
+      return {};
+    }
+
+    auto* mapped_data =
+        reinterpret_cast<uint8_t*>(buffer.GetMappedRange(0, size));
+    if (!mapped_data) {
+      iggpu::destroy_buffer(buffer);
+      return {};
+    }
+
+    oversized_buffers_.push_back(buffer);
+    pending_copies_.push_back({buffer, 0u, dst, dst_offset, size});
+    count_staged(size);
+    return std::span<uint8_t>(mapped_data, size);
+  }
+
+  if (active_slot_ >= 0 && slots_[active_slot_].offset + size > slot_size_) {
+    // Stays mapped until record_copies, but takes no new allocations
+    slots_[active_slot_].state = SlotState::Recorded;
+    active_slot_ = -1;
+  }
+
+  if (active_slot_ < 0) {
+    active_slot_ = acquire_slot();
+    if (active_slot_ < 0) {
+      return {};
+    }
+    slots_[active_slot_].state = SlotState::Active;
+
+    uint32_t slots_in_use =
+        std::count_if(slots_.begin(), slots_.end(), [](const Slot& s) {
+          return s.state != SlotState::Free && s.state != SlotState::Dead;
+        });
+    stats_.high_water_slots = std::max(stats_.high_water_slots, slots_in_use);
+  }
+
+  Slot& slot = slots_[active_slot_];
+  uint64_t src_offset = slot.offset;
+  slot.offset = ::align_up(slot.offset + size, kCopyAlignment);
+
+  pending_copies_.push_back({slot.buffer, src_offset, dst, dst_offset, size});
+  count_staged(size);
+  return std::span<uint8_t>(slot.mapped_data + src_offset, size);
+}
+
+void UploadRing::count_staged(uint64_t size) {
+  stats_.bytes_uploaded += size;
+  stats_.upload_count++;
+  staged_bytes_ += size;
+  stats_.high_water_bytes = std::max(stats_.high_water_bytes, staged_bytes_);
+}
+
+bool UploadRing::upload(wgpu::Buffer dst, uint64_t dst_offset,
+                        const void* data, uint64_t size) {
+  auto staging = allocate(dst, dst_offset, size);
+  if (staging.empty()) {
+    return false;
+  }
+  std::memcpy(staging.data(), data, size);
+  return true;
+}
+
+void UploadRing::record_copies(wgpu::CommandEncoder& encoder) {
+  for (auto& slot : slots_) {
+    if (slot.state == SlotState::Active ||
+        (slot.state == SlotState::Recorded && slot.mapped_data != nullptr)) {
+      slot.buffer.Unmap();
+      slot.mapped_data = nullptr;
+      slot.state = SlotState::Recorded;
+    }
+  }
+  active_slot_ = -1;
+
+  for (auto& buffer : oversized_buffers_) {
+    buffer.Unmap();
+  }
+
+  for (const auto& copy : pending_copies_) {
+    encoder.CopyBufferToBuffer(copy.src, copy.src_offset, copy.dst,
+                               copy.dst_offset, copy.size);
+  }
+  pending_copies_.clear();
+}
+
+void UploadRing::on_submitted() {
+  std::weak_ptr<bool> token = alive_token_;
+
+  for (uint32_t i = 0; i < slots_.size(); i++) {
+    Slot& slot = slots_[i];
+    if (slot.state != SlotState::Recorded || slot.mapped_data != nullptr) {
+      continue;
+    }
+
+    slot.state = SlotState::InFlight;
+    slot.map_future = app_base_->map_buffer_async(
+        slot.buffer, wgpu::MapMode::Write, 0, slot_size_,
+        [this, token, i](bool success) {
+          if (token.expired()) return;
+          on_slot_mapped(i, success);
+        });
+  }
+
+  if (!oversized_buffers_.empty()) {
+    uint64_t oversized_bytes = 0u;
+    for (const auto& buffer : oversized_buffers_) {
+      oversized_bytes += buffer.GetSize();
+    }
+
+    app_base_->on_submitted_work_done(
+        [this, token, oversized_bytes,
+         buffers = std::move(oversized_buffers_)]() mutable {
+          for (auto& buffer : buffers) {
+            iggpu::destroy_buffer(buffer);
+          }
+          if (token.expired()) return;
+          staged_bytes_ -= oversized_bytes;
+        });
+    oversized_buffers_.clear();
+  }
+}
+
+void UploadRing::on_slot_mapped(uint32_t slot_idx, bool success) {
+  Slot& slot = slots_[slot_idx];
+  staged_bytes_ -= std::min(staged_bytes_, slot.offset);
+  slot.offset = 0u;
+
+  if (!success) {
+    // Mapping only fails if the buffer or device was destroyed - replace the
+    //  buffer so the slot stays usable.
+    wgpu::BufferDescriptor bd{};
+    bd.size = slot_size_;
+    bd.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+    bd.mappedAtCreation = true;
+    iggpu::destroy_buffer(slot.buffer);
+    slot.buffer = iggpu::create_buffer(app_base_->Device, bd, "UploadRing");
+  }
+
+  slot.mapped_data =
+      slot.buffer ? reinterpret_cast<uint8_t*>(
+                        slot.buffer.GetMappedRange(0, slot_size_))
+                  : nullptr;
+  if (slot.mapped_data) {
+    slot.state = SlotState::Free;
+    return;
+  }
+
+  // Neither re-mapped nor replaceable (e.g. the device was lost) - retire
+  //  the slot, so that allocate() fails or creates a new one instead of
+  //  waiting on it forever
+  iggpu::log(LogLevel::Error,
+             "[IGGPU] UploadRing failed to map a staging buffer, dropping it");
+  iggpu::destroy_buffer(slot.buffer);
+  slot.state = SlotState::Dead;
+  stats_.slot_count = live_slot_count();
+}
+
+UploadRingStats UploadRing::stats() const { return stats_; }
+
+}  // namespace iggpu
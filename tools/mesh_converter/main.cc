@@ -0,0 +1,123 @@
+#include <iggpu/mesh_file.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "obj_reader.h"
+
+namespace {
+
+void print_usage() {
+  std::cerr << "Usage: iggpu_mesh_converter INPUT.obj OUTPUT.igmesh\n"
+               "       iggpu_mesh_converter --info FILE.igmesh\n";
+}
+
+const char* semantic_name(iggpu::MeshAttributeSemantic semantic) {
+  switch (semantic) {
+    case iggpu::MeshAttributeSemantic::Position:
+      return "Position";
+    case iggpu::MeshAttributeSemantic::Normal:
+      return "Normal";
+    case iggpu::MeshAttributeSemantic::Tangent:
+      return "Tangent";
+    case iggpu::MeshAttributeSemantic::TexCoord0:
+      return "TexCoord0";
+    case iggpu::MeshAttributeSemantic::TexCoord1:
+      return "TexCoord1";
+    case iggpu::MeshAttributeSemantic::Color:
+      return "Color";
+    default:
+      return "Custom";
+  }
+}
+
+int print_info(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "Failed to open " << path << std::endl;
+    return -1;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+
+  auto parse_rsl = iggpu::parse_mesh_file(data);
+  if (std::holds_alternative<iggpu::MeshFileError>(parse_rsl)) {
+    std::cerr << "Invalid mesh file " << path << ": "
+              << iggpu::mesh_file_error_text(
+                     std::get<iggpu::MeshFileError>(parse_rsl))
+              << std::endl;
+    return -1;
+  }
+
+  const auto& view = std::get<iggpu::MeshFileView>(parse_rsl);
+  const auto& h = view.header;
+  std::cout << path << ": " << data.size() << " bytes\n"
+            << "  vertices: " << h.vertex_count << " x " << h.vertex_stride
+            << " bytes\n"
+            << "  indices: " << h.index_count << " ("
+            << (h.index_format == iggpu::MeshIndexFormat::Uint16 ? "uint16"
+                                                                  : "uint32")
+            << ")\n"
+            << "  bounds: (" << h.bounds_min[0] << ", " << h.bounds_min[1]
+            << ", " << h.bounds_min[2] << ") - (" << h.bounds_max[0] << ", "
+            << h.bounds_max[1] << ", " << h.bounds_max[2] << ")\n";
+  for (const auto& attribute : view.attributes) {
+    std::cout << "  attribute " << ::semantic_name(attribute.semantic)
+              << ": location " << attribute.shader_location << ", offset "
+              << attribute.offset << ", "
+              << iggpu::mesh_attribute_size(attribute.format) << " bytes\n";
+  }
+  for (const auto& submesh : view.submeshes) {
+    std::cout << "  submesh (material " << submesh.material
+              << "): " << submesh.index_count << " indices from "
+              << submesh.first_index << ", radius " << submesh.bounds[3]
+              << "\n";
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 3 && std::strcmp(argv[1], "--info") == 0) {
+    return ::print_info(argv[2]);
+  }
+  if (argc != 3 || argv[1][0] == '-') {
+    ::print_usage();
+    return -1;
+  }
+
+  iggpu::tools::ObjMesh mesh;
+  std::string error;
+  if (!iggpu::tools::read_obj(argv[1], mesh, error)) {
+    std::cerr << error << std::endl;
+    return -1;
+  }
+
+  auto write_rsl =
+      iggpu::write_mesh_file(argv[2], iggpu::tools::to_mesh_file_desc(mesh));
+  if (std::holds_alternative<iggpu::MeshFileError>(write_rsl)) {
+    std::cerr << "Failed to write " << argv[2] << ": "
+              << iggpu::mesh_file_error_text(
+                     std::get<iggpu::MeshFileError>(write_rsl))
+              << std::endl;
+    return -1;
+  }
+
+  std::cout << "Wrote " << argv[2] << " (" << std::get<uint64_t>(write_rsl)
+            << " bytes): " << mesh.vertex_count() << " vertices, "
+            << mesh.indices.size() << " indices\n";
+  for (uint32_t i = 0u; i < mesh.groups.size(); i++) {
+    std::cout << "  material " << i << ": "
+              << (mesh.groups[i].material.empty() ? "(none)"
+                                                  : mesh.groups[i].material)
+              << "\n";
+  }
+  return 0;
+}
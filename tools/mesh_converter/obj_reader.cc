@@ -0,0 +1,246 @@
+#include "obj_reader.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+struct VertexKey {
+  int32_t v;
+  int32_t vt;
+  int32_t vn;
+
+  bool operator==(const VertexKey& o) const {
+    return v == o.v && vt == o.vt && vn == o.vn;
+  }
+};
+
+struct VertexKeyHash {
+  size_t operator()(const VertexKey& k) const {
+    size_t h = static_cast<uint32_t>(k.v);
+    h = h * 31u + static_cast<uint32_t>(k.vt);
+    h = h * 31u + static_cast<uint32_t>(k.vn);
+    return h;
+  }
+};
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+std::string_view next_token(std::string_view& line) {
+  size_t start = 0u;
+  while (start < line.size() && ::is_space(line[start])) start++;
+  size_t end = start;
+  while (end < line.size() && !::is_space(line[end])) end++;
+  std::string_view token = line.substr(start, end - start);
+  line.remove_prefix(end);
+  return token;
+}
+
+// Reads up to count floats - missing ones are left as they were
+void read_floats(std::string_view line, float* out, int count) {
+  for (int i = 0; i < count; i++) {
+    std::string token(::next_token(line));
+    if (token.empty()) {
+      return;
+    }
+    out[i] = std::strtof(token.c_str(), nullptr);
+  }
+}
+
+// OBJ indices are 1-based, or negative to count back from the last element.
+//  Returns -1 for a missing or out of range index.
+int32_t resolve_index(std::string_view token, size_t element_count) {
+  if (token.empty()) {
+    return -1;
+  }
+  long idx = std::strtol(std::string(token).c_str(), nullptr, 10);
+  long resolved = idx < 0 ? static_cast<long>(element_count) + idx : idx - 1;
+  if (resolved < 0 || resolved >= static_cast<long>(element_count)) {
+    return -1;
+  }
+  return static_cast<int32_t>(resolved);
+}
+
+}  // namespace
+
+namespace iggpu::tools {
+
+bool parse_obj(std::string_view text, ObjMesh& out, std::string& error) {
+  std::vector<float> positions;
+  std::vector<float> normals;
+  std::vector<float> texcoords;
+
+  // The vertex layout depends on whether the file has any texcoords
+  out = ObjMesh{};
+  out.has_texcoords = text.find("\nvt ") != std::string_view::npos ||
+                      text.substr(0, 3) == "vt ";
+  out.floats_per_vertex = out.has_texcoords ? 8u : 6u;
+  out.groups.push_back(ObjGroup{"", 0u, 0u});
+
+  std::unordered_map<VertexKey, uint32_t, VertexKeyHash> vertex_lookup;
+  std::vector<bool> needs_normal;
+  std::vector<uint32_t> face;
+
+  size_t line_start = 0u;
+  uint32_t line_number = 0u;
+  while (line_start < text.size()) {
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == std::string_view::npos) line_end = text.size();
+    std::string_view line = text.substr(line_start, line_end - line_start);
+    line_start = line_end + 1u;
+    line_number++;
+
+    std::string_view keyword = ::next_token(line);
+    if (keyword == "v") {
+      float p[3] = {0.f, 0.f, 0.f};
+      ::read_floats(line, p, 3);
+      positions.insert(positions.end(), p, p + 3);
+    } else if (keyword == "vn") {
+      float n[3] = {0.f, 0.f, 0.f};
+      ::read_floats(line, n, 3);
+      normals.insert(normals.end(), n, n + 3);
+    } else if (keyword == "vt") {
+      float t[2] = {0.f, 0.f};
+      ::read_floats(line, t, 2);
+      texcoords.insert(texcoords.end(), t, t + 2);
+    } else if (keyword == "usemtl") {
+      std::string material(::next_token(line));
+      if (out.groups.back().index_count > 0u) {
+        out.groups.push_back(ObjGroup{
+            material, static_cast<uint32_t>(out.indices.size()), 0u});
+      } else {
+        out.groups.back().material = material;
+      }
+    } else if (keyword == "f") {
+      face.clear();
+      for (std::string_view token = ::next_token(line); !token.empty();
+           token = ::next_token(line)) {
+        size_t slash1 = token.find('/');
+        size_t slash2 = slash1 == std::string_view::npos
+                            ? std::string_view::npos
+                            : token.find('/', slash1 + 1u);
+        VertexKey key{};
+        key.v = ::resolve_index(token.substr(0, slash1), positions.size() / 3u);
+        key.vt = slash1 == std::string_view::npos
+                     ? -1
+                     : ::resolve_index(
+                           token.substr(slash1 + 1u, slash2 - slash1 - 1u),
+                           texcoords.size() / 2u);
+        key.vn = slash2 == std::string_view::npos
+                     ? -1
+                     : ::resolve_index(token.substr(slash2 + 1u),
+                                       normals.size() / 3u);
+        if (key.v < 0) {
+          error = "Invalid vertex index on line " + std::to_string(line_number);
+          return false;
+        }
+
+        auto it = vertex_lookup.find(key);
+        if (it == vertex_lookup.end()) {
+          uint32_t idx = out.vertex_count();
+          const float* p = &positions[key.v * 3u];
+          out.vertices.insert(out.vertices.end(), p, p + 3);
+          if (key.vn >= 0) {
+            const float* n = &normals[key.vn * 3u];
+            out.vertices.insert(out.vertices.end(), n, n + 3);
+          } else {
+            out.vertices.insert(out.vertices.end(), {0.f, 0.f, 0.f});
+          }
+          if (out.has_texcoords) {
+            if (key.vt >= 0) {
+              const float* t = &texcoords[key.vt * 2u];
+              out.vertices.insert(out.vertices.end(), t, t + 2);
+            } else {
+              out.vertices.insert(out.vertices.end(), {0.f, 0.f});
+            }
+          }
+          needs_normal.push_back(key.vn < 0);
+          it = vertex_lookup.emplace(key, idx).first;
+        }
+        face.push_back(it->second);
+      }
+
+      for (size_t i = 2u; i < face.size(); i++) {
+        out.indices.insert(out.indices.end(), {face[0], face[i - 1], face[i]});
+        out.groups.back().index_count += 3u;
+      }
+    }
+  }
+
+  // Area-weighted face normals, summed into the vertices missing one
+  float* v = out.vertices.data();
+  uint32_t stride = out.floats_per_vertex;
+  for (size_t i = 0u; i + 2u < out.indices.size(); i += 3u) {
+    uint32_t a = out.indices[i];
+    uint32_t b = out.indices[i + 1u];
+    uint32_t c = out.indices[i + 2u];
+    if (!needs_normal[a] && !needs_normal[b] && !needs_normal[c]) {
+      continue;
+    }
+    float e1[3], e2[3];
+    for (int k = 0; k < 3; k++) {
+      e1[k] = v[b * stride + k] - v[a * stride + k];
+      e2[k] = v[c * stride + k] - v[a * stride + k];
+    }
+    float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                  e1[0] * e2[1] - e1[1] * e2[0]};
+    for (uint32_t idx : {a, b, c}) {
+      if (needs_normal[idx]) {
+        for (int k = 0; k < 3; k++) v[idx * stride + 3u + k] += n[k];
+      }
+    }
+  }
+  for (uint32_t idx = 0u; idx < needs_normal.size(); idx++) {
+    if (!needs_normal[idx]) continue;
+    float* n = &v[idx * stride + 3u];
+    float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (len > 0.f) {
+      n[0] /= len;
+      n[1] /= len;
+      n[2] /= len;
+    }
+  }
+
+  if (out.groups.back().index_count == 0u && out.groups.size() > 1u) {
+    out.groups.pop_back();
+  }
+  return true;
+}
+
+bool read_obj(const std::string& path, ObjMesh& out, std::string& error) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "Failed to open " + path;
+    return false;
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return parse_obj(ss.str(), out, error);
+}
+
+MeshFileDesc to_mesh_file_desc(const ObjMesh& mesh) {
+  MeshFileDesc desc{};
+  desc.vertex_stride = mesh.floats_per_vertex * sizeof(float);
+  desc.attributes.push_back({MeshAttributeSemantic::Position,
+                             MeshAttributeFormat::Float32x3, 0u, 0u});
+  desc.attributes.push_back({MeshAttributeSemantic::Normal,
+                             MeshAttributeFormat::Float32x3, 12u, 1u});
+  if (mesh.has_texcoords) {
+    desc.attributes.push_back({MeshAttributeSemantic::TexCoord0,
+                               MeshAttributeFormat::Float32x2, 24u, 2u});
+  }
+  desc.vertex_data = std::span<const uint8_t>(
+      reinterpret_cast<const uint8_t*>(mesh.vertices.data()),
+      mesh.vertices.size() * sizeof(float));
+  desc.indices = mesh.indices;
+  for (uint32_t i = 0u; i < mesh.groups.size(); i++) {
+    desc.submeshes.push_back(MeshFileSubmesh{
+        mesh.groups[i].first_index, mesh.groups[i].index_count, 0, i, {}});
+  }
+  return desc;
+}
+
+}  // namespace iggpu::tools
@@ -0,0 +1,47 @@
+#ifndef IGGPU_TOOLS_OBJ_READER_H
+#define IGGPU_TOOLS_OBJ_READER_H
+
+#include <iggpu/mesh_file.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iggpu::tools {
+
+// Triangles of one material (usemtl), in file order
+struct ObjGroup {
+  std::string material;
+  uint32_t first_index;
+  uint32_t index_count;
+};
+
+// Wavefront OBJ geometry, with one vertex per distinct v/vt/vn triple.
+//  Faces are fan-triangulated. Vertices without a normal get the average
+//  of their faces' normals.
+struct ObjMesh {
+  // Interleaved position (3 floats), normal (3 floats) and, if
+  //  has_texcoords, texcoord (2 floats)
+  std::vector<float> vertices;
+  uint32_t floats_per_vertex = 6u;
+  bool has_texcoords = false;
+
+  std::vector<uint32_t> indices;
+  std::vector<ObjGroup> groups;
+
+  uint32_t vertex_count() const {
+    return static_cast<uint32_t>(vertices.size() / floats_per_vertex);
+  }
+};
+
+bool parse_obj(std::string_view text, ObjMesh& out, std::string& error);
+bool read_obj(const std::string& path, ObjMesh& out, std::string& error);
+
+// Layout: position at location 0, normal at 1, texcoord at 2. Submesh i is
+//  groups[i], with material i. The desc points into mesh.
+MeshFileDesc to_mesh_file_desc(const ObjMesh& mesh);
+
+}  // namespace iggpu::tools
+
+#endif